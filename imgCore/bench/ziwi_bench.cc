@@ -0,0 +1,507 @@
+/**
+ * @file ziwi_bench.cc
+ * @brief Micro-benchmark of every imgCore kernel on synthetic frames.
+ *
+ * Each case prints one JSON object per line:
+ *  {"kernel": "...", "mode": 0, "bpp": 12, "highZero": false, "width": 1920,
+ *   "height": 1080, "bytes": ..., "reps": ..., "seconds": ...,
+ *   "MBps": ..., "Mpixps": ...}
+ * "seconds" is the best run, MB/s is computed over the input bytes.
+ *
+ * Usage: ziwi_bench [--quick] [--filter <kernel substring>] [--csv]
+ *                   [--threads N]
+ * --threads sizes the imgCore pool (LuxSetNumThreads), 1 for the serial
+ * numbers; default one thread per core.
+ */
+
+#include <imgCore/LuxCheck.h>
+#include <imgCore/LuxDLL.h>
+#include <imgCore/LuxDecode.h>
+#include <imgCore/LuxStats.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchCase {
+    std::string kernel;
+    int mode;
+    int bpp;
+    bool highZero;
+    int width;
+    int height;
+    uint64_t bytes;  ///< Input bytes of one run
+};
+
+struct BenchOptions {
+    bool quick = false;
+    bool csv = false;
+    std::string filter;
+    double budget = 0.25;  ///< Seconds spent on every case
+    int threads = 0;       ///< Threads of the pool, 0: one per core
+};
+
+BenchOptions gOptions;
+
+/// Bits of a sample in the synthetic frame: 16-bit highZero holds 12 bits.
+int sampleBits(int bpp, bool highZero) {
+    return (bpp == 16 && highZero) ? 12 : bpp;
+}
+
+/// Bytes of a frame as the parsers expect it.
+uint64_t frameBytes(int width, int height, int bpp, bool highZero) {
+    uint64_t pixels = static_cast<uint64_t>(width) * height;
+    if (bpp == 8) return pixels;
+    if (bpp == 12 && !highZero) return pixels * 3 / 2;
+    return pixels * 2;
+}
+
+/**
+ * @brief Generate a big endian frame: a diagonal gradient plus noise so the
+ * data is neither constant nor random.
+ */
+std::vector<uint8_t> makeFrame(int width, int height, int bpp, bool highZero) {
+    std::vector<uint8_t> frame(frameBytes(width, height, bpp, highZero));
+    int bits = sampleBits(bpp, highZero);
+    uint32_t mask = (1u << bits) - 1;
+
+    std::mt19937 rng(width * 31 + height * 17 + bpp);
+    auto sample = [&](int x, int y) {
+        uint32_t v = ((x + y) << (bits - 8 > 0 ? bits - 8 : 0)) / 4;
+        return (v + (rng() & 0x3F)) & mask;
+    };
+
+    uint64_t k = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint32_t v = sample(x, y);
+            if (bpp == 8) {
+                frame[k++] = static_cast<uint8_t>(v);
+            } else if (bpp == 12 && !highZero) {
+                /// AAAAAAAA AAAABBBB BBBBBBBB
+                uint32_t w = sample(++x, y);
+                frame[k++] = static_cast<uint8_t>(v >> 4);
+                frame[k++] = static_cast<uint8_t>(((v & 0x0F) << 4) | (w >> 8));
+                frame[k++] = static_cast<uint8_t>(w & 0xFF);
+            } else {
+                frame[k++] = static_cast<uint8_t>(v >> 8);
+                frame[k++] = static_cast<uint8_t>(v & 0xFF);
+            }
+        }
+    }
+    return frame;
+}
+
+void printResult(const BenchCase &c, int reps, double best) {
+    double mbps = c.bytes / best / 1e6;
+    double mpixps = static_cast<double>(c.width) * c.height / best / 1e6;
+    if (gOptions.csv) {
+        std::cout << c.kernel << ',' << c.mode << ',' << c.bpp << ','
+                  << c.highZero << ',' << c.width << ',' << c.height << ','
+                  << c.bytes << ',' << reps << ',' << best << ',' << mbps
+                  << ',' << mpixps << std::endl;
+        return;
+    }
+    std::cout << "{\"kernel\": \"" << c.kernel << "\", \"mode\": " << c.mode
+              << ", \"bpp\": " << c.bpp
+              << ", \"highZero\": " << (c.highZero ? "true" : "false")
+              << ", \"width\": " << c.width << ", \"height\": " << c.height
+              << ", \"bytes\": " << c.bytes << ", \"reps\": " << reps
+              << ", \"seconds\": " << best << ", \"MBps\": " << mbps
+              << ", \"Mpixps\": " << mpixps << "}" << std::endl;
+}
+
+/**
+ * @brief Run @c body until the time budget is spent (at least 3 times) and
+ * report the best run. @c setup runs before every timed run and is not timed,
+ * e.g. to restore a buffer that the kernel modifies in place.
+ */
+void run(const BenchCase &c, const std::function<void()> &body,
+         const std::function<void()> &setup = nullptr) {
+    if (!gOptions.filter.empty() &&
+        c.kernel.find(gOptions.filter) == std::string::npos)
+        return;
+
+    using Clock = std::chrono::steady_clock;
+    double best = 1e30, spent = 0;
+    int reps = 0;
+    while (reps < 3 || spent < gOptions.budget) {
+        if (setup) setup();
+        auto t0 = Clock::now();
+        body();
+        double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+        best = std::min(best, dt);
+        spent += dt;
+        ++reps;
+    }
+    printResult(c, reps, best);
+}
+
+/// Every parse kernel: enhanced modes 0 - 5, legacy, extend / stretch to 16.
+void benchParse(int width, int height) {
+    const int layouts[][2] = {{8, 0}, {12, 0}, {12, 1}, {16, 0}, {16, 1}};
+    uint64_t pixels = static_cast<uint64_t>(width) * height;
+    std::vector<uint8_t> out8(pixels * 2);
+    std::vector<uint16_t> out16(pixels * 2);
+
+    for (auto &layout : layouts) {
+        int bpp = layout[0];
+        bool highZero = layout[1] != 0;
+        auto frame = makeFrame(width, height, bpp, highZero);
+        uint64_t length = frame.size();
+        auto src = frame;
+
+        for (int mode = 0; mode <= 5; ++mode) {
+            run({"parse_enhanced", mode, bpp, highZero, width, height,
+                 frame.size()},
+                [&]() {
+                    LuxParseImage64Enhanced(src.data(), length, bpp, highZero,
+                                            out8.data(), mode);
+                });
+        }
+
+        run({"parse", 0, bpp, highZero, width, height, frame.size()}, [&]() {
+            LuxParseImage64(src.data(), length, bpp, highZero, out8.data());
+        });
+        run({"parse_extend16", 0, bpp, highZero, width, height, frame.size()},
+            [&]() {
+                LuxParseImage64ExtendTo16(src.data(), length, bpp, highZero,
+                                          out16.data());
+            });
+        run({"parse_stretch16", 0, bpp, highZero, width, height,
+             frame.size()},
+            [&]() {
+                LuxParseImage64StretchTo16(src.data(), length, bpp, highZero,
+                                           out16.data());
+            });
+
+        // The single pass decode takes highZero on 16-bit frames only
+        if (bpp == 12 && highZero) continue;
+        std::vector<uint16_t> stretch16(pixels), planes(pixels);
+        LuxDecodeStats stats;
+        LuxDecodeRequest request{};
+        request.outputs = LUX_DECODE_DISPLAY8 | LUX_DECODE_EXTEND16 |
+                          LUX_DECODE_STRETCH16 | LUX_DECODE_PLANES |
+                          LUX_DECODE_STATS;
+        request.display8 = out8.data();
+        request.extend16 = out16.data();
+        request.stretch16 = stretch16.data();
+        for (int s = 0; s < 4; ++s)
+            request.planes[s] = planes.data() + s * (pixels / 4);
+        request.stats = &stats;
+        run({"decode_multi", 0, bpp, highZero, width, height, frame.size()},
+            [&]() {
+                LuxDecodeMulti(frame.data(), frame.size(), width, height, bpp,
+                               true, highZero, &request);
+            });
+    }
+}
+
+/// Endian revert, normalize, white balance, channel split, demosaic, histogram
+void benchPixelKernels(int width, int height) {
+    uint64_t pixels = static_cast<uint64_t>(width) * height;
+
+    // Endian revert of a 16-bit frame, in place and out of place
+    auto frame16 = makeFrame(width, height, 16, false);
+    std::vector<uint8_t> swapped(frame16.size());
+    run({"endian_revert", 0, 16, false, width, height, frame16.size()}, [&]() {
+        LuxEndianRevert64(frame16.data(), frame16.size(), 16, swapped.data(),
+                          true);
+    });
+
+    // Normalize 16 -> 8 (mode 5 core)
+    std::vector<uint16_t> samples(pixels);
+    for (uint64_t i = 0; i < pixels; ++i)
+        samples[i] = static_cast<uint16_t>((frame16[2 * i] << 8) |
+                                           frame16[2 * i + 1]);
+    std::vector<uint8_t> out8(pixels * 3);
+    run({"normalize", 0, 16, false, width, height, pixels * 2}, [&]() {
+        LuxNormalize<uint16_t, uint8_t>(samples.data(),
+                                        static_cast<int>(pixels),
+                                        out8.data());
+    });
+
+    // White balance on 8-bit Bayer, in place
+    auto bayer8 = makeFrame(width, height, 8, false);
+    auto work8 = bayer8;
+    for (int bayerType = 0; bayerType < 4; ++bayerType) {
+        run({"white_balance", bayerType, 8, false, width, height, pixels},
+            [&]() {
+                LuxSetChannelFactors(work8.data(), width, height, bayerType,
+                                     1.2f, 1.0f, 1.6f);
+            },
+            [&]() { ::memcpy(work8.data(), bayer8.data(), pixels); });
+    }
+
+    // R/G1/G2/B split
+    std::vector<uint8_t> planes(pixels);
+    uint64_t plane = pixels / 4;
+    for (int bayerType = 0; bayerType < 4; ++bayerType) {
+        run({"channel_split", bayerType, 8, false, width, height, pixels},
+            [&]() {
+                LuxGetBayerRawChanenls(bayer8.data(), width, height,
+                                       bayerType, planes.data(),
+                                       planes.data() + plane,
+                                       planes.data() + 2 * plane,
+                                       planes.data() + 3 * plane);
+            });
+    }
+
+    // Demosaic, 8-bit and 16-bit
+    run({"demosaic", 0, 8, false, width, height, pixels}, [&]() {
+        cv::Mat bayer(height, width, CV_8UC1, bayer8.data());
+        cv::Mat rgb(height, width, CV_8UC3, out8.data());
+        cv::cvtColor(bayer, rgb, cv::COLOR_BayerRG2RGB);
+    });
+    std::vector<uint16_t> rgb16(pixels * 3);
+    run({"demosaic", 0, 16, false, width, height, pixels * 2}, [&]() {
+        cv::Mat bayer(height, width, CV_16UC1, samples.data());
+        cv::Mat rgb(height, width, CV_16UC3, rgb16.data());
+        cv::cvtColor(bayer, rgb, cv::COLOR_BayerRG2RGB);
+    });
+
+    // Demosaic fused with the color matrix and the sRGB curve
+    LuxColorConf color{{1.6f, -0.4f, -0.2f, -0.2f, 1.5f, -0.3f, 0, -0.6f, 1.6f},
+                       LUX_GAMMA_SRGB, 2.2};
+    LuxSetColorConf(&color);
+    std::vector<uint8_t> rgb8(pixels * 3);
+    run({"demosaic_color", 0, 8, false, width, height, pixels}, [&]() {
+        cv::Mat bayer(height, width, CV_8UC1, bayer8.data());
+        cv::Mat rgb(height, width, CV_8UC3, rgb8.data());
+        LuxDemosaic(bayer, rgb, cv::COLOR_BayerRG2RGB);
+    });
+    run({"demosaic_color", 0, 16, false, width, height, pixels * 2}, [&]() {
+        cv::Mat bayer(height, width, CV_16UC1, samples.data());
+        cv::Mat rgb(height, width, CV_16UC3, rgb16.data());
+        LuxDemosaic(bayer, rgb, cv::COLOR_BayerRG2RGB);
+    });
+    run({"color", 0, 8, false, width, height, pixels * 3}, [&]() {
+        LuxApplyColor(rgb8.data(), width, height, 0, nullptr);
+    });
+    color = {{1, 0, 0, 0, 1, 0, 0, 0, 1}, LUX_GAMMA_NONE, 2.2};
+    LuxSetColorConf(&color);
+
+    // Histogram, the core of LuxDrawHist
+    run({"histogram", 0, 8, false, width, height, pixels}, [&]() {
+        cv::Mat image(height, width, CV_8UC1, bayer8.data());
+        cv::Mat hist;
+        int numbins = 256;
+        float range[] = {0, 256};
+        const float *histRange = {range};
+        cv::calcHist(&image, 1, 0, cv::Mat(), hist, 1, &numbins, &histRange);
+    });
+}
+
+/// CRC variants on line sized records, frame verification and check sums
+void benchCheck(int width, int height) {
+    auto frame = makeFrame(width, height, 16, false);
+    uint64_t lineBytes = static_cast<uint64_t>(width) * 2;
+
+    for (int crcType = LUX_CRC4_ITU; crcType < LUX_CRC_COUNT; ++crcType) {
+        run({"crc", crcType, 16, false, width, height, frame.size()}, [&]() {
+            for (int y = 0; y < height; ++y)
+                LuxCalcCRC(crcType, frame.data() + y * lineBytes, lineBytes);
+        });
+    }
+
+    LuxCheckConf conf{LUX_CRC16_CCITT_FALSE, LUX_CHECK_LINE, LUX_CHECK_TAIL, 0,
+                      0, false, true};
+    std::vector<uint8_t> framed(LuxCheckFrameBytes(&conf, lineBytes, height));
+    std::vector<uint8_t> payload(frame.size());
+    run({"crc_verify", LUX_CRC16_CCITT_FALSE, 16, false, width, height,
+         framed.size()},
+        [&]() {
+            LuxCheckVerify(framed.data(), framed.size(), lineBytes, height,
+                           &conf, payload.data(), nullptr, 0);
+        });
+
+    run({"checksum16", 0, 16, false, width, height, frame.size()}, [&]() {
+        LuxCalcCheckSum(frame.data(), static_cast<int64_t>(frame.size()));
+    });
+    run({"checksum32", 0, 16, false, width, height, frame.size()}, [&]() {
+        LuxCalcCheckSum32(frame.data(), static_cast<int64_t>(frame.size()));
+    });
+}
+
+/// Lossless codec, both directions measured over the frame bytes
+void benchCodec(int width, int height) {
+    for (int bpp : {8, 12, 16}) {
+        auto frame = makeFrame(width, height, bpp, false);
+        std::vector<uint8_t> stream(LuxCodecMaxBytes(width, height, bpp));
+        long long streamBytes = 0;
+        run({"codec_encode", 0, bpp, false, width, height, frame.size()},
+            [&]() {
+                streamBytes =
+                    LuxCodecEncode(frame.data(), frame.size(), width, height,
+                                   bpp, true, stream.data(), stream.size());
+            });
+
+        std::vector<uint8_t> decoded(frame.size());
+        run({"codec_decode", 0, bpp, false, width, height, frame.size()},
+            [&]() {
+                LuxCodecDecode(stream.data(), streamBytes, decoded.data(),
+                               decoded.size());
+            });
+    }
+}
+
+/// Per channel statistics with percentiles, full frame and a centered ROI
+void benchStats(int width, int height) {
+    const double ranks[] = {1, 50, 99};
+    for (int bpp : {8, 12, 16}) {
+        auto frame = makeFrame(width, height, bpp, false);
+        LuxBayerStats stats;
+        run({"bayer_stats", 0, bpp, false, width, height, frame.size()},
+            [&]() {
+                LuxComputeBayerStats(frame.data(), frame.size(), width, height,
+                                     bpp, true, false, nullptr, ranks, 3,
+                                     &stats);
+            });
+
+        LuxRoi roi{width / 4 & ~1, height / 4, width / 2, height / 2};
+        run({"bayer_stats_roi", 0, bpp, false, roi.width, roi.height,
+             frame.size() / 4},
+            [&]() {
+                LuxComputeBayerStats(frame.data(), frame.size(), width, height,
+                                     bpp, true, false, &roi, ranks, 3, &stats);
+            });
+    }
+}
+
+/// One frame into the running per-pixel mean and variance
+void benchTemporal(int width, int height) {
+    for (int bpp : {12, 16}) {
+        auto frame = makeFrame(width, height, bpp, false);
+        LuxTemporalAccumulator accumulator(width, height, bpp, true, false);
+        run({"temporal_add", 0, bpp, false, width, height, frame.size()},
+            [&]() { accumulator.add(frame.data(), frame.size()); });
+    }
+}
+
+/// Row and column profiles of each Bayer site
+void benchProfiles(int width, int height) {
+    std::vector<float> rows(2 * static_cast<size_t>(height));
+    std::vector<float> columns(2 * static_cast<size_t>(width));
+    for (int bpp : {12, 16}) {
+        auto frame = makeFrame(width, height, bpp, false);
+        LuxFpnResult result;
+        run({"fpn_profiles", 0, bpp, false, width, height, frame.size()},
+            [&]() {
+                LuxComputeFpnProfiles(frame.data(), frame.size(), width,
+                                      height, bpp, true, false, rows.data(),
+                                      columns.data(), &result);
+            });
+    }
+}
+
+/// Difference of two frames with its heatmap, the range given (one pass)
+/// and found (two passes)
+void benchDiff(int width, int height) {
+    std::vector<unsigned char> heatmap(static_cast<size_t>(width) * height *
+                                       3);
+    for (int bpp : {12, 16}) {
+        auto frameA = makeFrame(width, height, bpp, false);
+        auto frameB = frameA;
+        for (size_t i = 0; i < frameB.size(); i += 97) frameB[i] ^= 0x15;
+        LuxDiffResult result;
+        for (int range : {64, 0})
+            run({range > 0 ? "diff" : "diff_autorange", 0, bpp, false, width,
+                 height, 2 * frameA.size()},
+                [&]() {
+                    LuxComputeDiff(frameA.data(), frameB.data(), frameA.size(),
+                                   width, height, bpp, true, false,
+                                   LUX_DIFF_ABS, 16, range, heatmap.data(),
+                                   &result);
+                });
+    }
+}
+
+/// White balance and exposure from the default subsample
+void benchAutoTune(int width, int height) {
+    for (int bpp : {8, 12, 16}) {
+        auto frame = makeFrame(width, height, bpp, false);
+        LuxAutoConf conf{LUX_AWB_GRAY_WORLD, true, 0, 3, 0, 0.5, 99.5};
+        LuxAutoResult result;
+        run({"auto_tune", 0, bpp, false, width, height, frame.size()}, [&]() {
+            LuxAutoTune(frame.data(), frame.size(), width, height, bpp, true,
+                        false, &conf, &result);
+        });
+    }
+}
+
+/// Single pass decode of the MIPI CSI-2 packings, the unpack dominates
+void benchMipi(int width, int height) {
+    uint64_t pixels = static_cast<uint64_t>(width) * height;
+    std::vector<uint8_t> out8(pixels);
+    std::vector<uint16_t> out16(pixels);
+    for (int bpp : {LUX_BPP_RAW10, LUX_BPP_RAW12, LUX_BPP_RAW14}) {
+        std::vector<uint8_t> frame(LuxPackedBytes(pixels, bpp));
+        std::mt19937 rng(bpp);
+        for (auto &b : frame) b = static_cast<uint8_t>(rng());
+        LuxDecodeRequest request{};
+        request.outputs = LUX_DECODE_DISPLAY8 | LUX_DECODE_EXTEND16;
+        request.display8 = out8.data();
+        request.extend16 = out16.data();
+        run({"decode_mipi", 0, bpp, false, width, height, frame.size()},
+            [&]() {
+                LuxDecodeMulti(frame.data(), frame.size(), width, height, bpp,
+                               true, false, &request);
+            });
+    }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--quick") {
+            gOptions.quick = true;
+            gOptions.budget = 0.05;
+        } else if (arg == "--csv") {
+            gOptions.csv = true;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            gOptions.filter = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            gOptions.threads = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--quick] [--filter <kernel>] [--csv] [--threads N]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    LuxSetNumThreads(gOptions.threads);
+
+    // The library logs to stderr, keep stdout machine readable
+    std::vector<std::pair<int, int>> resolutions = {
+        {640, 480}, {1920, 1080}, {4096, 3072}, {5120, 3840}};
+    if (gOptions.quick) resolutions = {{640, 480}, {1920, 1080}};
+
+    if (gOptions.csv)
+        std::cout << "kernel,mode,bpp,highZero,width,height,bytes,reps,seconds,"
+                     "MBps,Mpixps"
+                  << std::endl;
+
+    for (auto &res : resolutions) {
+        benchParse(res.first, res.second);
+        benchPixelKernels(res.first, res.second);
+        benchCheck(res.first, res.second);
+        benchCodec(res.first, res.second);
+        benchStats(res.first, res.second);
+        benchTemporal(res.first, res.second);
+        benchProfiles(res.first, res.second);
+        benchDiff(res.first, res.second);
+        benchAutoTune(res.first, res.second);
+        benchMipi(res.first, res.second);
+    }
+    return 0;
+}
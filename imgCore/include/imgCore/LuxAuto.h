@@ -0,0 +1,86 @@
+/**
+ * @file LuxAuto.h
+ * @brief Automatic white balance and exposure of a Bayer frame.
+ *
+ * The statistics come from a strided subsample of 2x2 Bayer quads read
+ * straight from the packed frame, so tuning a 20 MP frame reads a few
+ * hundred thousand samples instead of the whole frame. The result feeds the
+ * white balance stage of LuxLoadImageDataEnhanced2() (eaf, r, g, b, mode).
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXAUTO_H
+#define LUXAUTO_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+enum LuxAwbMethod {
+    LUX_AWB_NONE = 0,        ///< r = g = b = 1
+    LUX_AWB_GRAY_WORLD = 1,  ///< The channel means are made equal
+    LUX_AWB_WHITE_PATCH = 2  ///< The highPercentile of the channels
+};
+
+struct LuxAutoConf {
+    int awb;          ///< LuxAwbMethod
+    bool autoLevels;  ///< Pick the window and the gain from the percentiles
+    int mode;         ///< Window [0, 4] kept when autoLevels is off
+    /// As LuxSetChannelFactors(): 0 GBRG, 1 GRBG, 2 BGGR, 3 RGGB
+    int bayerType;
+    /// Every step-th quad in both directions, <= 0: about 32K quads
+    int step;
+    double lowPercentile;   ///< Black point, e.g. 0.5
+    double highPercentile;  ///< White point and white patch, e.g. 99.5
+};
+
+struct LuxAutoResult {
+    /// Factors of LuxLoadImageDataEnhanced2() / LuxSetChannelFactors(), the
+    /// exposure gain included, in [0, 10]
+    float r;
+    float g;
+    float b;
+    /// Window [0, 4] of LuxParseImageEnhanced() keeping the brightest
+    /// sample in 8 bits, LuxAutoConf::mode if autoLevels is off
+    int mode;
+    float exposureGain;  ///< 8-bit white point to 255, 1 without autoLevels
+    uint16_t black;      ///< Sample value of lowPercentile
+    uint16_t white;      ///< Sample value of highPercentile
+    int step;            ///< The step used
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief White balance factors and exposure of @c imgData.
+ *
+ * Sample layouts as for LuxDecodeMulti(). The percentiles come from a 10-bit
+ * histogram of the subsample.
+ *
+ * @param width Samples per row
+ * @param result Output
+ * @return long long
+ * The number of samples read if success.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -4 : width or height or bpp or length are wrong.
+ *  -6 : conf is wrong (awb, mode, bayerType, percentiles) or result is
+ *       nullptr.
+ */
+DLL_EXPORT
+long long LuxAutoTune(const unsigned char *imgData, unsigned long long length,
+                      int width, int height, int bpp, bool isBigEndian,
+                      bool highZero, const LuxAutoConf *conf,
+                      LuxAutoResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file LuxCalib.h
+ * @brief Black level, dark frame and flat field calibration of the raws.
+ *
+ * The decoders (LuxDecode.h), the statistics (LuxStats.h), the automatic
+ * tuning (LuxAuto.h) and the raw loaders calibrate every row right after
+ * unpacking it, before the defect correction and the bit window or mode 5:
+ *
+ *     v = min((max(v - offset, 0) * gain) >> 12, full scale)
+ *
+ * one 16-bit pass over the row, 8 samples at a time with SSE2. The offset is
+ * the dark frame, or the black level of the Bayer site without one; the gain
+ * is the flat field (the mean of the site over the sample, the dark frame or
+ * black level taken off) times the rescale of [black, full scale] back to
+ * [0, full scale].
+ *
+ * The calibration frames are raws unpacked once into a cache: from memory
+ * (e.g. a mapping of the caller), or from a file, a .zraw payload read in
+ * place from its mapping. They apply to the frames of their geometry
+ * (samples per row x rows) and significant bits; the black level to every
+ * frame.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXCALIB_H
+#define LUXCALIB_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+enum LuxCalibFrameKind {
+    LUX_CALIB_DARK = 0,  ///< Same exposure, no light: offset of every pixel
+    LUX_CALIB_FLAT = 1,  ///< Uniform light: vignetting and pixel response
+};
+
+struct LuxCalibConf {
+    /// Per Bayer site (0, 0), (0, 1), (1, 0), (1, 1), in sample values;
+    /// default 0. A dark frame replaces it for the frames of its geometry.
+    int blackLevel[4];
+    /// 1 (default): stretch [black, full scale] back to [0, full scale],
+    /// 0: the samples keep their values minus the black
+    int rescale;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @return 0, or -1 if @c conf is nullptr or a black level not in
+/// [0, 65535].
+DLL_EXPORT
+int LuxSetCalibConf(const LuxCalibConf *conf);
+
+DLL_EXPORT
+void LuxGetCalibConf(LuxCalibConf *conf);
+
+/**
+ * @brief Replace the calibration frame @c kind (LuxCalibFrameKind) by the
+ * raw @c imgData, unpacked into the cache: @c imgData may go afterwards.
+ * Layouts and parameters as for LuxDecodeMulti(); a dark frame and a flat
+ * field have the same geometry and bits, the last one set wins.
+ *
+ * @return long long
+ * The number of samples if success.
+ *  -1 : @c kind is wrong.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -4 : width or height or bpp or length are wrong.
+ */
+DLL_EXPORT
+long long LuxSetCalibFrame(int kind, const unsigned char *imgData,
+                           unsigned long long length, int width, int height,
+                           int bpp, bool isBigEndian, bool highZero);
+
+/**
+ * @brief LuxSetCalibFrame() of a file: a headerless raw, a LuxCodec stream
+ * or a container, read as LuxReadFrameFromFile().
+ * @return As LuxSetCalibFrame(), -3 if the file can not be opened.
+ */
+DLL_EXPORT
+long long LuxLoadCalibFrame(int kind, const char *fileName, int width,
+                            int height, int bpp, bool isBigEndian,
+                            bool highZero);
+
+/// @brief Drop the calibration frame @c kind, -1: both.
+DLL_EXPORT
+void LuxClearCalibFrame(int kind);
+
+/// @brief 1 if the calibration frame @c kind is set, 0 if not.
+DLL_EXPORT
+int LuxHasCalibFrame(int kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+struct LuxCalibData;
+
+/// @brief The calibration of one decode: the frames and the black level of
+/// the library when it starts, for frames of @c width samples x @c height
+/// rows of @c bits significant bits. Its rows may be calibrated
+/// concurrently.
+class LuxCalibPass {
+public:
+    LuxCalibPass(int width, int height, int bits);
+
+    /// False if nothing applies to the frame: skip apply()
+    bool active() const { return active_; }
+
+    /// @brief Calibrate the unpacked samples [x0, x0 + count) of row @c y
+    /// in place.
+    void apply(int64_t y, uint16_t *v, int x0, int count) const;
+
+private:
+    /// The frames, nullptr if they do not match the geometry
+    std::shared_ptr<const LuxCalibData> data_;
+    /// Without frames: offset and gain of the even and the odd rows
+    std::vector<uint16_t> offset_[2];
+    std::vector<uint16_t> gain_[2];
+    int width_;
+    uint16_t mask_;
+    bool active_;
+};
+
+#endif
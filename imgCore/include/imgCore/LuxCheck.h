@@ -99,6 +99,79 @@ DLL_EXPORT
 uint32_t
 LuxCalcCheckSum32(uint8_t const *p_data, int64_t data_len);
 
+/*************************************************************************************************/
+/*                                     Integrity Verification                                    */
+/*************************************************************************************************/
+
+/// CRC variants of the generic engine, same parameters as LuxCRC* above.
+enum LuxCRCType {
+    LUX_CRC_NONE = 0,
+    LUX_CRC4_ITU,
+    LUX_CRC5_EPC,
+    LUX_CRC5_ITU,
+    LUX_CRC5_USB,
+    LUX_CRC6_ITU,
+    LUX_CRC7_MMC,
+    LUX_CRC8,
+    LUX_CRC8_ITU,
+    LUX_CRC8_ROHC,
+    LUX_CRC8_MAXIM,
+    LUX_CRC16_IBM,
+    LUX_CRC16_MAXIM,
+    LUX_CRC16_USB,
+    LUX_CRC16_MODBUS,
+    LUX_CRC16_CCITT,
+    LUX_CRC16_CCITT_FALSE,
+    LUX_CRC16_X25,
+    LUX_CRC16_XMODEM,
+    LUX_CRC16_DNP,
+    LUX_CRC32,
+    LUX_CRC32_MPEG_2,
+    LUX_CRC_COUNT
+};
+
+/// What one CRC protects: every line or the whole frame.
+enum LuxCheckScope { LUX_CHECK_LINE = 0, LUX_CHECK_FRAME = 1 };
+
+/// Where the CRC field sits inside a record.
+enum LuxCheckPosition { LUX_CHECK_TAIL = 0, LUX_CHECK_HEAD = 1 };
+
+/**
+ * @brief Layout of a CRC protected record (one line or one frame).
+ *
+ *  - TAIL: [header][payload][padding][CRC]
+ *  - HEAD: [CRC][header][payload][padding]
+ *
+ * The CRC always covers the payload, the header only if @c coverHeader.
+ */
+struct LuxCheckConf {
+    int crcType;        ///< LuxCRCType, LUX_CRC_NONE disables the stage
+    int scope;          ///< LuxCheckScope
+    int position;       ///< LuxCheckPosition
+    int headerBytes;    ///< Link header in front of the payload
+    int paddingBytes;   ///< Bytes after the payload which are not covered
+    bool coverHeader;   ///< CRC covers the link header too ?
+    bool crcBigEndian;  ///< Byte order of the CRC field
+};
+
+DLL_EXPORT
+uint32_t
+LuxCalcCRC(int crcType, uint8_t const *data, uint64_t length);
+
+DLL_EXPORT
+int
+LuxCRCBytes(int crcType);
+
+DLL_EXPORT
+uint64_t
+LuxCheckFrameBytes(const LuxCheckConf *conf, uint64_t lineBytes, int lines);
+
+DLL_EXPORT
+long long
+LuxCheckVerify(uint8_t const *input, uint64_t inLength, uint64_t lineBytes,
+               int lines, const LuxCheckConf *conf, uint8_t *payloadOut,
+               int *badLines, int badLinesCap);
+
 #ifdef __cplusplus
 }
 #endif
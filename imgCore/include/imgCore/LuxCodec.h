@@ -0,0 +1,94 @@
+/**
+ * @file LuxCodec.h
+ * @brief Lossless codec for 8 / 12 / 16-bit Bayer frames.
+ *
+ * Every sample is predicted from its same-colour neighbours (MED predictor
+ * over the 2x2 Bayer lattice) and the residual is Rice coded with a per
+ * channel adaptive parameter. The frame is cut into strips of rows which do
+ * not reference each other, so they are encoded and decoded in parallel.
+ * The decoder restores the input bytes exactly, packing and endianness
+ * included.
+ *
+ * Stream: LuxCodecHeader, uint64_t strip offsets [strips + 1] relative to
+ * the end of the offset table, strip data.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXCODEC_H
+#define LUXCODEC_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+#define LUX_CODEC_MAGIC "LXC1"
+#define LUX_CODEC_STRIP_ROWS 16
+
+#pragma pack(push, 1)
+struct LuxCodecHeader {
+    char magic[4];       ///< "LXC1"
+    uint16_t bpp;        ///< 8, 12, 16
+    uint8_t bigEndian;   ///< Byte order of the 16-bit samples
+    uint8_t reserved;
+    uint32_t width;      ///< Samples per row
+    uint32_t height;
+    uint32_t stripRows;
+    uint32_t strips;
+    uint64_t rawBytes;   ///< Bytes of the decoded frame
+};
+#pragma pack(pop)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Upper bound of the encoded size, for the output buffer.
+DLL_EXPORT
+long long LuxCodecMaxBytes(int width, int height, int bpp);
+
+/**
+ * @brief Encode one frame.
+ *
+ * @param input width x height samples as the loaders read them: 8-bit,
+ * 12-bit packed (AAAAAAAA AAAABBBB BBBBBBBB) or 16-bit
+ * @param width Samples per row (width x channels), even for 12 bpp
+ * @param isBigEndian Byte order of the 16-bit samples
+ * @return long long
+ * The bytes number of the stream if success.
+ *  -1 : Parameters are wrong (bpp, geometry, length).
+ *  -2 : @c outCap is too small, see LuxCodecMaxBytes().
+ */
+DLL_EXPORT
+long long LuxCodecEncode(const unsigned char *input, unsigned long long length,
+                         int width, int height, int bpp, bool isBigEndian,
+                         unsigned char *output, unsigned long long outCap);
+
+/**
+ * @brief Read the header of a stream.
+ * @return 0 if success, -1 if it is not a valid stream.
+ */
+DLL_EXPORT
+int LuxCodecInfo(const unsigned char *input, unsigned long long length,
+                 LuxCodecHeader *header);
+
+/**
+ * @brief Decode a stream, the strips in parallel.
+ * @return long long
+ * The bytes number of the frame if success.
+ *  -1 : The stream is corrupt.
+ *  -2 : @c outCap is too small.
+ */
+DLL_EXPORT
+long long LuxCodecDecode(const unsigned char *input, unsigned long long length,
+                         unsigned char *output, unsigned long long outCap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
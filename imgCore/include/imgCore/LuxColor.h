@@ -0,0 +1,93 @@
+/**
+ * @file LuxColor.h
+ * @brief Color correction matrix and gamma of the demosaiced RGB.
+ *
+ * The stage maps every RGB pixel through a 3x3 matrix (the sensor primaries
+ * to the display ones), then every channel through a gamma curve:
+ *
+ *     [R' G' B'] = ccm x [R G B],  out = curve(clamp(R', G', B'))
+ *
+ * The 8-bit path multiplies in 4.12 fixed point, 8 pixels at a time with
+ * SSE2, and reads the curve from a 256-entry table; the 16-bit path from a
+ * 65536-entry one. The raw loaders run it fused with the demosaic: every
+ * band of rows is demosaiced, then corrected while it is still in cache,
+ * the bands in parallel.
+ *
+ * The identity matrix and LUX_GAMMA_NONE (the default) turn the stage off.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXCOLOR_H
+#define LUXCOLOR_H
+
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+enum LuxGammaCurve {
+    LUX_GAMMA_NONE = 0,   ///< Linear
+    LUX_GAMMA_SRGB = 1,   ///< The sRGB transfer function
+    LUX_GAMMA_POWER = 2,  ///< out = in ^ (1 / LuxColorConf::power)
+};
+
+struct LuxColorConf {
+    /// Row-major, R' = ccm[0] R + ccm[1] G + ccm[2] B; every coefficient in
+    /// (-8, 8), the rows of a white-preserving matrix sum to 1. Default: the
+    /// identity.
+    float ccm[9];
+    int gamma;     ///< LuxGammaCurve, default LUX_GAMMA_NONE
+    double power;  ///< LUX_GAMMA_POWER, > 0, e.g. 2.2
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @return 0, or -1 if @c conf is nullptr, a coefficient out of (-8, 8),
+/// the curve unknown or the power not > 0.
+DLL_EXPORT
+int LuxSetColorConf(const LuxColorConf *conf);
+
+DLL_EXPORT
+void LuxGetColorConf(LuxColorConf *conf);
+
+/// @brief 1 if the stage changes the pixels, 0 if it is off.
+DLL_EXPORT
+int LuxColorActive();
+
+/**
+ * @brief Apply the stage in place to @c height rows of @c width interleaved
+ * RGB pixels of 8 bits, @c stride bytes apart (0: packed).
+ * @param conf nullptr: the one of the library
+ * @return The number of pixels, -1 if @c conf is wrong, -4 if the geometry
+ * is wrong.
+ */
+DLL_EXPORT
+long long LuxApplyColor(unsigned char *rgb, int width, int height,
+                        unsigned long long stride, const LuxColorConf *conf);
+
+/// @brief LuxApplyColor() of 16-bit RGB, @c stride in samples.
+DLL_EXPORT
+long long LuxApplyColor16(uint16_t *rgb, int width, int height,
+                          unsigned long long stride,
+                          const LuxColorConf *conf);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief cv::cvtColor(@c bayer, @c rgb, @c code) then the color stage of
+ * the library, fused by bands of rows. @c rgb is allocated by the caller;
+ * a 1-channel one or the stage off is a plain cv::cvtColor().
+ */
+DLL_EXPORT
+void LuxDemosaic(const cv::Mat &bayer, cv::Mat &rgb, int code);
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file LuxContainer.h
+ * @brief Self-describing Ziwi raw container (.zraw).
+ *
+ * Layout, all fields little endian:
+ *  [0, 128)            LuxZrawHeader
+ *  [payloadOffset, +)  Sensor bytes exactly as the loaders expect them
+ *                      (packing / endianness described by the header),
+ *                      row-major, in tiles or as a LuxCodec stream,
+ *                      64-byte aligned
+ *  [previewOffset, +)  Optional 8-bit preview (CV_8UC1 / CV_8UC3), aligned
+ *
+ * The file is mapped read-only, so a plain untiled payload is used in place.
+ * Headerless .raw files are not affected, see LuxZrawIsContainer().
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXCONTAINER_H
+#define LUXCONTAINER_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+#define LUX_ZRAW_MAGIC "ZIWIRAW"
+#define LUX_ZRAW_VERSION 1
+#define LUX_ZRAW_HEADER_BYTES 128
+#define LUX_ZRAW_ALIGN 64
+
+enum LuxZrawFlags {
+    LUX_ZRAW_TILED = 1 << 0,    ///< Payload stored as tileWidth x tileHeight
+    LUX_ZRAW_PREVIEW = 1 << 1,  ///< Preview present
+    LUX_ZRAW_CRC = 1 << 2,      ///< payloadCRC32 is valid
+    LUX_ZRAW_COMPRESSED = 1 << 3,  ///< Payload is a LuxCodec stream
+};
+
+#pragma pack(push, 1)
+struct LuxZrawHeader {
+    char magic[8];           ///< "ZIWIRAW\0"
+    uint16_t version;        ///< LUX_ZRAW_VERSION
+    uint16_t headerBytes;    ///< LUX_ZRAW_HEADER_BYTES
+    uint32_t flags;          ///< LuxZrawFlags
+    uint32_t width;
+    uint32_t height;
+    uint16_t bpp;            ///< 8, 12, 16
+    uint16_t channels;
+    uint8_t bigEndian;       ///< Byte order of the 16-bit samples
+    uint8_t highZero;        ///< 0000AAAA AAAAAAAA (TW2 workspace)
+    uint8_t bayerPattern;    ///< 0: GBRG, 1: GRBG, 2: BGGR, 3: RGGB
+    uint8_t dataFormat;      ///< 1: raw, 2: bayer, 3: others
+    uint32_t tileWidth;      ///< Pixels, 0 if untiled
+    uint32_t tileHeight;
+    uint64_t payloadOffset;
+    uint64_t payloadBytes;   ///< Bytes as stored (compressed or not)
+    uint64_t previewOffset;  ///< 0 if no preview
+    uint64_t previewBytes;
+    uint32_t previewWidth;
+    uint32_t previewHeight;
+    uint32_t previewType;    ///< CV_8UC1 / CV_8UC3
+    uint32_t payloadCRC32;   ///< LUX_CRC32 of the payload as stored
+    uint8_t reserved[40];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(LuxZrawHeader) == LUX_ZRAW_HEADER_BYTES,
+              "LuxZrawHeader must be 128 bytes");
+
+/// A mapped container, filled by LuxZrawOpen()
+struct LuxZrawFile {
+    LuxZrawHeader header;
+    const unsigned char *base;  ///< Start of the mapping
+    uint64_t size;              ///< Bytes of the file
+    void *handle;               ///< Platform mapping, internal
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bytes of the untiled payload described by @c header.
+ * @return -1 if the geometry is wrong.
+ */
+DLL_EXPORT
+long long LuxZrawFrameBytes(const LuxZrawHeader *header);
+
+/**
+ * @return 1 if @c fileName starts with the container magic, 0 if not (e.g. a
+ * legacy .raw), -3 if the file can not be opened.
+ */
+DLL_EXPORT
+int LuxZrawIsContainer(const char *fileName);
+
+/**
+ * @brief Write a container. Magic, version, offsets, sizes and the CRC are
+ * filled in from @c info, the rest (geometry, format, tiles, preview size) is
+ * taken as is. With LUX_ZRAW_TILED the row-major @c payload is stored tiled;
+ * the tiles must divide the frame and tileWidth * bpp * channels must be a
+ * multiple of 8. With LUX_ZRAW_COMPRESSED it is stored as a LuxCodec stream,
+ * which can not be combined with tiles.
+ *
+ * @param payload Row-major sensor bytes, LuxZrawFrameBytes(info) long
+ * @param preview Ignored without LUX_ZRAW_PREVIEW
+ * @return long long
+ * The bytes number of the file if success.
+ *  -1 : Header is wrong.
+ *  -3 : File open failed.
+ */
+DLL_EXPORT
+long long LuxZrawWrite(const char *fileName, const LuxZrawHeader *info,
+                       const unsigned char *payload,
+                       const unsigned char *preview);
+
+/**
+ * @brief Map @c fileName read-only and validate the header.
+ * @return int
+ *  0 : Success, release with LuxZrawClose().
+ *  -3 : File open / map failed.
+ *  -4 : Not a container or unsupported version.
+ *  -5 : Truncated file or inconsistent header.
+ */
+DLL_EXPORT
+int LuxZrawOpen(const char *fileName, LuxZrawFile *file);
+
+DLL_EXPORT
+void LuxZrawClose(LuxZrawFile *file);
+
+/**
+ * @brief The payload in place, nullptr if it is tiled or compressed (use
+ * LuxZrawReadFrame)
+ */
+DLL_EXPORT
+const unsigned char *LuxZrawPayload(const LuxZrawFile *file);
+
+/// @brief The preview in place, nullptr if there is none
+DLL_EXPORT
+const unsigned char *LuxZrawPreview(const LuxZrawFile *file);
+
+/**
+ * @brief Copy the payload into @c output row-major, untiling or decoding if
+ * needed. @c output holds LuxZrawFrameBytes() bytes.
+ * @return The bytes number of the frame, -1 if the header or the stream is
+ * wrong.
+ */
+DLL_EXPORT
+long long LuxZrawReadFrame(const LuxZrawFile *file, unsigned char *output);
+
+/**
+ * @brief Check the stored LUX_CRC32 of the payload.
+ * @return 1 if it matches, 0 if not, -1 if the file carries no CRC.
+ */
+DLL_EXPORT
+int LuxZrawVerify(const LuxZrawFile *file);
+
+/**
+ * @brief LuxLoadImageDataFromFileEnhanced() for containers: the geometry and
+ * format come from the header, no parameters are needed.
+ *
+ * @param mode [0, 1, 2, 3, 4, 5], see LuxParseImageEnhanced()
+ * @return long long
+ * The bytes number of the parsed image if success.
+ *  -3 : File open failed.
+ *  -4 : Not a container / wrong header.
+ *  Others : see LuxLoadImageDataEnhanced()
+ */
+DLL_EXPORT
+long long LuxLoadImageDataFromZraw(const char *inputFileName,
+                                   const char *outputRawFileName,
+                                   const char *outputTiffFileName,
+                                   bool saveTiff, int mode, int code);
+
+/**
+ * @brief Read one frame of @c length bytes for the LuxLoadImageDataFromFile*
+ * loaders: a headerless .raw as is, a LuxCodec stream or a container
+ * (decoded / untiled). The geometry is checked by the length only, as for
+ * the headerless files.
+ *
+ * @return long long
+ * @c length if success.
+ *  -3 : File open failed.
+ *  -4 : The length of the frame is NOT right, or the stream is corrupt.
+ */
+DLL_EXPORT
+long long LuxReadFrameFromFile(const char *fileName, unsigned char *output,
+                               unsigned long long length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,11 +7,28 @@
 #ifndef LUXTW2_H
 #define LUXTW2_H
 
+#include <imgCore/LuxAuto.h>
+#include <imgCore/LuxCalib.h>
+#include <imgCore/LuxCheck.h>
+#include <imgCore/LuxCodec.h>
+#include <imgCore/LuxColor.h>
+#include <imgCore/LuxContainer.h>
+#include <imgCore/LuxDecode.h>
+#include <imgCore/LuxDefect.h>
+#include <imgCore/LuxDiff.h>
+#include <imgCore/LuxPacking.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxProfile.h>
+#include <imgCore/LuxStats.h>
+#include <imgCore/LuxTemporal.h>
+#include <imgCore/LuxUnpack.h>
+#include <imgCore/LuxWriter.h>
+
 #include <cstdint>
 #include <opencv2/opencv.hpp>
 
 template <typename T>
-inline std::tuple<T, T> LuxFindMaxMin(const T *img, int length);
+inline std::tuple<T, T> LuxFindMaxMin(const T *img, uint64_t length);
 
 template <typename TSrc, typename TDst = uint8_t>
 inline TDst normlize255(TSrc src, TSrc max);
@@ -27,10 +44,10 @@ inline TDst normlize255(TSrc src, TSrc max) {
 };
 
 template <typename T>
-inline std::tuple<T, T> LuxFindMaxMin(const T *img, int length) {
+inline std::tuple<T, T> LuxFindMaxMin(const T *img, uint64_t length) {
     T max = img[0];
     T min = img[0];
-    for (int i = 0; i < length; ++i) {
+    for (uint64_t i = 0; i < length; ++i) {
         if (img[i] > max) {
             max = img[i];
         }
@@ -43,11 +60,12 @@ inline std::tuple<T, T> LuxFindMaxMin(const T *img, int length) {
 }
 
 template <typename TSrc, typename TDst>
-inline uint64_t LuxNormalize(TSrc *orgiImg, int orgiImgLen, TDst *outputImg) {
+inline uint64_t LuxNormalize(TSrc *orgiImg, uint64_t orgiImgLen,
+                             TDst *outputImg) {
     uint64_t k = 0;
     TSrc maxOfOrgiImg = std::get<0>(LuxFindMaxMin<TSrc>(orgiImg, orgiImgLen));
 
-    for (int i = 0; i < orgiImgLen; ++i) {
+    for (uint64_t i = 0; i < orgiImgLen; ++i) {
         outputImg[k++] = normlize255<TSrc, TDst>(orgiImg[i], maxOfOrgiImg);
     }
 
@@ -95,6 +113,16 @@ enum class ImageFileType { UnknowType = -1, raw = 0, tiff };
 
 void LuxEndianSwap(char *pData, uint64_t startIndex, uint64_t length);
 
+/// The int lengths below stop at 2 GB, the *64 entry points take any
+/// length; the int ones are shims of them.
+/// The parsers and kernels below run in the pool of LuxParallel.h, see
+/// LuxSetNumThreads().
+
+DLL_EXPORT
+unsigned long long LuxEndianRevert64(unsigned char *input, uint64_t length,
+                                     int bpp, unsigned char *output,
+                                     bool isBig2Little);
+
 DLL_EXPORT
 int LuxEndianRevert(unsigned char *input, int length, int bpp,
                     unsigned char *output, bool isBig2Little);
@@ -102,19 +130,36 @@ int LuxEndianRevert(unsigned char *input, int length, int bpp,
 DLL_EXPORT
 void LuxFlushStdOut();
 
-inline unsigned long long LuxParseImage(unsigned char *orgiImg, int length,
-                                        int bpp, bool highZero,
-                                        unsigned char *outputImg);
+DLL_EXPORT
+unsigned long long LuxParseImage64(unsigned char *orgiImg, uint64_t length,
+                                   int bpp, bool highZero,
+                                   unsigned char *outputImg);
+
+DLL_EXPORT
+unsigned long long LuxParseImage(unsigned char *orgiImg, int length, int bpp,
+                                 bool highZero, unsigned char *outputImg);
+
+DLL_EXPORT
+unsigned long long LuxParseImage64ExtendTo16(unsigned char *orgiImg,
+                                             uint64_t length, int bpp,
+                                             bool highZero,
+                                             uint16_t *outputImg);
 
-inline unsigned long long LuxParseImageExtendTo16(unsigned char *orgiImg,
-                                                  int length, int bpp,
-                                                  bool highZero,
-                                                  uint16_t *outputImg);
+DLL_EXPORT
+unsigned long long LuxParseImageExtendTo16(unsigned char *orgiImg, int length,
+                                           int bpp, bool highZero,
+                                           uint16_t *outputImg);
 
-inline unsigned long long LuxParseImageStretchTo16(unsigned char *orgiImg,
-                                                   int length, int bpp,
-                                                   bool highZero,
-                                                   uint16_t *outputImg);
+DLL_EXPORT
+unsigned long long LuxParseImage64StretchTo16(unsigned char *orgiImg,
+                                              uint64_t length, int bpp,
+                                              bool highZero,
+                                              uint16_t *outputImg);
+
+DLL_EXPORT
+unsigned long long LuxParseImageStretchTo16(unsigned char *orgiImg, int length,
+                                            int bpp, bool highZero,
+                                            uint16_t *outputImg);
 
 inline decltype(CV_8UC1) LuxGetImageType(int dataFormat, int bpp, int channels);
 
@@ -175,9 +220,15 @@ long long LuxSaveImgDatExtTo16(unsigned char *imgData,
                                const char *outRawFileName, bool isBigEndian,
                                bool highZero);
 
-inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int bytes,
-                                       int bpp, bool highZero,
-                                       unsigned char *outputImg, int mode = 0);
+DLL_EXPORT
+long long LuxParseImage64Enhanced(unsigned char *orgiImg, uint64_t length,
+                                  int bpp, bool highZero,
+                                  unsigned char *outputImg, int mode = 0);
+
+DLL_EXPORT
+long long LuxParseImageEnhanced(unsigned char *orgiImg, int bytes, int bpp,
+                                bool highZero, unsigned char *outputImg,
+                                int mode = 0);
 
 DLL_EXPORT
 long long LuxLoadImageDataEnhanced(unsigned char *imgData,
@@ -220,6 +271,29 @@ long long LuxLoadImageDataEnhanced2(unsigned char *imgData,
                                     int code, bool eaf, int bayerType, float r,
                                     float g, float b);
 
+DLL_EXPORT
+long long LuxLoadImageDataFromFileChecked(
+    const char *inputFileName, int dataFormat, int width, int height, int bpp,
+    int channels, const char *outputRawFileName, const char *outputTiffFileName,
+    bool isBigEndian, bool highZero, bool saveTiff, int mode, int code,
+    const LuxCheckConf *checkConf, int *badLines, int badLinesCap,
+    int *badCount);
+
+DLL_EXPORT
+long long LuxLoadImageDataStrided(const unsigned char *imgData,
+                                  unsigned long long length, int dataFormat,
+                                  int width, int height, int bpp,
+                                  int inChannels, unsigned char *outData,
+                                  bool isBigEndian, bool highZero, int mode,
+                                  int code, const LuxFrameLayout *layout);
+
+DLL_EXPORT
+long long LuxLoadImageDataFromFileStrided(
+    const char *inputFileName, int dataFormat, int width, int height, int bpp,
+    int channels, const char *outputRawFileName, const char *outputTiffFileName,
+    bool isBigEndian, bool highZero, bool saveTiff, int mode, int code,
+    const LuxFrameLayout *layout);
+
 #ifdef __cplusplus
 }
 #endif  /// __cplusplus
@@ -0,0 +1,199 @@
+/**
+ * @file LuxDecode.h
+ * @brief Decode one frame into several outputs in a single pass.
+ *
+ * The 8-bit display window, the 16-bit extended / stretched frames, the Bayer
+ * planes and the statistics used to come from separate calls, each of them
+ * validating, endian swapping and parsing the same input again. Here every
+ * row of the input is unpacked once and all requested outputs are written
+ * from it, the rows in parallel. The input is never modified.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXDECODE_H
+#define LUXDECODE_H
+
+#include <imgCore/LuxUnpack.h>
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+enum LuxDecodeOutput {
+    LUX_DECODE_DISPLAY8 = 1 << 0,   ///< 8-bit window, see LuxDecodeRequest
+    LUX_DECODE_EXTEND16 = 1 << 1,   ///< Sample values, 0000AAAA AAAAAAAA
+    LUX_DECODE_STRETCH16 = 1 << 2,  ///< Samples scaled to the full 16 bit
+    LUX_DECODE_PLANES = 1 << 3,     ///< 4 Bayer planes of sample values
+    LUX_DECODE_STATS = 1 << 4,      ///< LuxDecodeStats
+};
+
+/// Bit 0 - 5 of the mode mask of LuxDecodeModes()
+#define LUX_DECODE_MODE(mode) (1u << (mode))
+#define LUX_DECODE_ALL_MODES 0x3Fu
+
+struct LuxDecodeStats {
+    int significantBits;      ///< 8, 12 or 16
+    uint16_t min;
+    uint16_t max;
+    double mean;
+    /// Per Bayer site, in the order (0, 0), (0, 1), (1, 0), (1, 1)
+    uint16_t siteMin[4];
+    uint16_t siteMax[4];
+    double siteMean[4];
+    /// The 8 most significant bits of the samples
+    uint32_t histogram[256];
+};
+
+struct LuxDecodeRequest {
+    unsigned int outputs;      ///< LuxDecodeOutput flags
+    int mode;                  ///< Window of display8, see below
+    unsigned char *display8;   ///< width x height
+    uint16_t *extend16;        ///< width x height
+    uint16_t *stretch16;       ///< width x height
+    uint16_t *planes[4];       ///< (width / 2) x (height / 2) each, site order
+    LuxDecodeStats *stats;
+    /// Optional: stretch16 is queued on LuxWriter as a 16-bit TIFF
+    const char *tiffFileName;
+};
+
+/// Range of mode 5 ("all in 8"), for every decoder of the library
+struct LuxNormalizeConf {
+    /// Black point percentile, 0: black at 0 (default)
+    double lowPercentile;
+    /// White point percentile, 100: white at the frame maximum (default)
+    double highPercentile;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Replace the range of mode 5. The defaults, 0 and 100, scale by the
+ * frame maximum: one hot pixel darkens the whole frame. E.g. 0.1 and 99.9
+ * ignore the outliers. The percentiles come from a 4096-bin histogram.
+ *
+ * @return 0, or -1 if @c conf is nullptr or its percentiles are not
+ * 0 <= low < high <= 100.
+ */
+DLL_EXPORT
+int LuxSetNormalizeConf(const LuxNormalizeConf *conf);
+
+DLL_EXPORT
+void LuxGetNormalizeConf(LuxNormalizeConf *conf);
+
+/**
+ * @brief Mode 5 of @c count samples of @c bits significant bits: one pass
+ * for the histogram, one through a LUT of every sample value.
+ *
+ * @return long long
+ * @c count if success, -1 if a pointer is nullptr or @c bits not in [8, 16].
+ */
+DLL_EXPORT
+long long LuxNormalizeTo8(const uint16_t *samples, unsigned long long count,
+                          int bits, unsigned char *output);
+
+/**
+ * @brief Decode @c imgData into the outputs of @c request.
+ *
+ * Sample layouts as for LuxLoadImageDataEnhanced(): 8-bit, 12-bit packed
+ * (AAAAAAAA AAAABBBB BBBBBBBB), 16-bit, 16-bit with 12 significant bits
+ * (@c highZero, 0000AAAA AAAAAAAA).
+ *
+ * display8 follows LuxParseImageEnhanced(): mode [0, 4] takes 8 bits
+ * starting @c mode bits below the most significant one, mode 5 scales the
+ * range of LuxNormalizeConf to [0, 255]. Mode 5 needs the range first: the
+ * pass builds its histogram, the window is built from extend16 (a scratch
+ * frame if it was not requested) through a LUT afterwards.
+ *
+ * @param width Samples per row (width x channels)
+ * @param isBigEndian Byte order of the 16-bit samples
+ * @return long long
+ * The number of samples if success.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -4 : width or height or bpp or length are wrong.
+ *  -6 : The request is wrong (mode, missing buffer, planes of an odd
+ *       geometry, TIFF without stretch16).
+ */
+DLL_EXPORT
+long long LuxDecodeMulti(const unsigned char *imgData,
+                         unsigned long long length, int width, int height,
+                         int bpp, bool isBigEndian, bool highZero,
+                         LuxDecodeRequest *request);
+
+/**
+ * @brief LuxDecodeMulti() of a frame with line padding and embedded data
+ * lines, read in place: no repack, @c imgData is not modified.
+ *
+ * @param length Bytes of the whole capture, (topLines + height +
+ * bottomLines) x inStride
+ * @param layout nullptr: packed rows. Its @c outStride applies to display8,
+ * extend16 and stretch16, in samples; the planes stay packed, a TIFF needs
+ * packed stretch16 rows.
+ */
+DLL_EXPORT
+long long LuxDecodeMultiStrided(const unsigned char *imgData,
+                                unsigned long long length, int width,
+                                int height, int bpp, bool isBigEndian,
+                                bool highZero, const LuxFrameLayout *layout,
+                                LuxDecodeRequest *request);
+
+/**
+ * @brief Every bit-window mode of LuxParseImageEnhanced() in one pass: each
+ * sample is unpacked once and windowed into all the modes of @c modeMask,
+ * e.g. to pick the "第N高八位" side by side.
+ *
+ * @param modeMask LUX_DECODE_MODE(m) of the wanted modes, LUX_DECODE_ALL_MODES
+ * @param outputs outputs[m] receives width x height bytes of mode m, it may
+ * be nullptr for modes not in @c modeMask
+ * @return long long
+ * The number of samples if success, otherwise as LuxDecodeMulti().
+ */
+DLL_EXPORT
+long long LuxDecodeModes(const unsigned char *imgData,
+                         unsigned long long length, int width, int height,
+                         int bpp, bool isBigEndian, bool highZero,
+                         unsigned int modeMask, unsigned char *const *outputs);
+
+/// @brief LuxDecodeModes() of a frame laid out as @c layout, every output
+/// row @c outStride bytes apart. See LuxDecodeMultiStrided().
+DLL_EXPORT
+long long LuxDecodeModesStrided(const unsigned char *imgData,
+                                unsigned long long length, int width,
+                                int height, int bpp, bool isBigEndian,
+                                bool highZero, const LuxFrameLayout *layout,
+                                unsigned int modeMask,
+                                unsigned char *const *outputs);
+
+/// @brief Bytes of a capture of @c height rows of @c rowBytes laid out as
+/// @c layout (its outStride is not used), 0 if the layout does not fit.
+DLL_EXPORT
+uint64_t LuxFrameLayoutBytes(const LuxFrameLayout *layout, uint64_t rowBytes,
+                             int height);
+
+/**
+ * @brief Copy the rows of a capture laid out as @c layout into the packed
+ * frame @c output, for the consumers which need one (CRC, codec, repack).
+ *
+ * @param rowBytes Bytes of the samples of a row, as LuxPackedBytes() or
+ * LuxPackingRowBytes()
+ * @return long long
+ * rowBytes x height if success.
+ *  -4 : The length does not match the layout.
+ */
+DLL_EXPORT
+long long LuxFrameCompact(const unsigned char *imgData,
+                          unsigned long long length, uint64_t rowBytes,
+                          int height, const LuxFrameLayout *layout,
+                          unsigned char *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
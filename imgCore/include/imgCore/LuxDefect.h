@@ -0,0 +1,131 @@
+/**
+ * @file LuxDefect.h
+ * @brief Hot / dead / stuck pixel correction, fused into the row unpacking.
+ *
+ * The decoders (LuxDecode.h), the statistics (LuxStats.h) and the raw
+ * loaders correct the defects of the active map while they unpack a row:
+ * a defect gets the median of its same-color Bayer neighbours, two samples
+ * left, right, above and below, the defects among them left out. The rows
+ * above and below are unpacked only for the rows holding defects, so the
+ * cost follows the number of defects, not the frame size.
+ *
+ * The map is a list of (x, y) coordinates or a bitmap, for frames of one
+ * geometry (samples per row x rows); frames of another geometry are not
+ * touched. The optional dynamic detector also corrects the isolated samples
+ * standing out of all their same-color neighbours in every frame.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXDEFECT_H
+#define LUXDEFECT_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+struct LuxDefectConf {
+    /// 1: detect isolated defects in every frame as well, 0 (default): the
+    /// map only
+    int dynamic;
+    /// Dynamic: a defect stands out of all its same-color neighbours by more
+    /// than this part of the full scale, (0, 1], default 0.25
+    double threshold;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Replace the defect map by @c count (x, y) pairs of @c xy, for
+ * frames of @c width samples per row x @c height rows. Duplicates are
+ * merged; a count of 0 clears the map.
+ * @return The number of defects, or -1 (logged) if the geometry or a
+ * coordinate is wrong, the map is then unchanged.
+ */
+DLL_EXPORT
+int LuxSetDefectMap(const int *xy, int count, int width, int height);
+
+/// @brief LuxSetDefectMap() of a bitmap of width x height bytes, defects
+/// non-zero.
+DLL_EXPORT
+int LuxSetDefectBitmap(const unsigned char *bitmap, int width, int height);
+
+/**
+ * @brief Read the defect map of a file: a bitmap of exactly width x height
+ * bytes holding zeros, otherwise text, one "x y" (or "x,y") per line, '#'
+ * comments.
+ * @return The number of defects, -1 if the file can't be opened, -3
+ * (logged) if it is wrong.
+ */
+DLL_EXPORT
+int LuxLoadDefectMap(const char *fileName, int width, int height);
+
+DLL_EXPORT
+void LuxClearDefectMap();
+
+/// @brief Defects of the map, 0 without one.
+DLL_EXPORT
+int LuxGetDefectCount();
+
+/// @return 0, or -1 if @c conf is nullptr or its threshold not in (0, 1].
+DLL_EXPORT
+int LuxSetDefectConf(const LuxDefectConf *conf);
+
+DLL_EXPORT
+void LuxGetDefectConf(LuxDefectConf *conf);
+
+#ifdef __cplusplus
+}
+#endif
+
+struct LuxDefectMapData;
+
+/// @brief The correction of one decode: the map and the detector of the
+/// library when it starts, for frames of @c width samples x @c height rows
+/// of @c bits significant bits. Its rows may be corrected concurrently.
+class LuxDefectPass {
+public:
+    /// Unpack the same span of row @c y into @c dst
+    using RowSource = std::function<void(int64_t y, uint16_t *dst)>;
+
+    /// Buffers of one band of rows
+    struct Scratch {
+        std::vector<uint16_t> above;
+        std::vector<uint16_t> below;
+        std::vector<int> fixes;
+        std::vector<uint16_t> values;
+    };
+
+    LuxDefectPass(int width, int height, int bits);
+
+    /// False if nothing applies to the frame: skip correctRow()
+    bool active() const { return map_ != nullptr || threshold_ > 0; }
+
+    /**
+     * @brief Correct the defects of row @c y in place.
+     * @param v The unpacked samples [x0, x0 + count) of the row
+     * @param unpack Called for the rows y - 2 and y + 2 only when row @c y
+     * holds defects
+     */
+    void correctRow(int64_t y, uint16_t *v, int x0, int count,
+                    const RowSource &unpack, Scratch *scratch) const;
+
+private:
+    bool isMapped(int64_t y, int x) const;
+
+    std::shared_ptr<const LuxDefectMapData> map_;
+    int height_;
+    /// Dynamic detector, 0: off
+    uint32_t threshold_;
+};
+
+#endif
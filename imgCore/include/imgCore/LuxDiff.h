@@ -0,0 +1,78 @@
+/**
+ * @file LuxDiff.h
+ * @brief Per-sample difference of two raw frames of the same format, e.g.
+ * the outputs of two firmware versions: summary statistics and a heatmap.
+ *
+ * Both frames are unpacked row by row to 16 bits (no calibration nor defect
+ * correction: the samples as captured) and subtracted 8 samples at a time
+ * with SSE2, the rows in parallel. The heatmap reads the color of every
+ * difference from a table of all the differences of the significant bits,
+ * no arithmetic per sample:
+ *  - LUX_DIFF_ABS: |a - b|, black if equal, then from dark red (1) through
+ *    red and yellow to white (>= range);
+ *  - LUX_DIFF_SIGNED: a - b, black if equal, a > b from dark red to yellow,
+ *    a < b from dark blue to cyan.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXDIFF_H
+#define LUXDIFF_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+enum LuxDiffMode {
+    LUX_DIFF_ABS = 0,
+    LUX_DIFF_SIGNED = 1,
+};
+
+struct LuxDiffResult {
+    int width;  ///< Samples per row
+    int height;
+    int maxAbs;     ///< Largest |a - b|
+    int minSigned;  ///< Smallest a - b
+    int maxSigned;  ///< Largest a - b
+    double meanAbs;
+    unsigned long long differing;      ///< Samples with a != b
+    unsigned long long overThreshold;  ///< Samples with |a - b| > threshold
+    int range;  ///< The difference of the brightest color of the heatmap
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Difference of the raws @c frameA and @c frameB, layouts and
+ * parameters as for LuxDecodeMulti().
+ *
+ * @param mode LuxDiffMode of the heatmap
+ * @param threshold >= 0, counted in LuxDiffResult::overThreshold
+ * @param range Differences >= range get the brightest color, <= 0: the
+ * largest difference of the frames (one more pass)
+ * @param heatmap width x height RGB888 pixels, or nullptr
+ * @param result Output, may be nullptr
+ * @return long long
+ * The number of samples if success.
+ *  -1 : mode unknown.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -4 : width or height or bpp or length are wrong.
+ */
+DLL_EXPORT
+long long LuxComputeDiff(const unsigned char *frameA,
+                         const unsigned char *frameB, unsigned long long length,
+                         int width, int height, int bpp, bool isBigEndian,
+                         bool highZero, int mode, int threshold, int range,
+                         unsigned char *heatmap, LuxDiffResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
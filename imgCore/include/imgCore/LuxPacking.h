@@ -0,0 +1,144 @@
+/**
+ * @file LuxPacking.h
+ * @brief Declarative sample packings: a new sensor layout is a descriptor,
+ * not another branch of the parsers.
+ *
+ * A group of @c group samples is packed into whole bytes. The bytes of a
+ * group are read as one word in @c byteOrder; each sample takes
+ * @c containerBits of the word, the first sample at the most (MSB first) or
+ * the least (LSB first) significant end, and holds @c bits of them, the
+ * padding above (@c LUX_PAD_HIGH) or below (@c LUX_PAD_LOW) the value.
+ * LUX_BITS_MIPI is the CSI-2 split layout: the high 8 bits of every sample
+ * of the group, then their low bits LSB first.
+ *
+ * As text, for para.ini ([packing] section) or a sidecar next to the raw
+ * (<raw>.pack), separated by new lines, ';' or ',':
+ *
+ *     bits=10 container=16 group=1 byteOrder=little bitOrder=msb pad=high
+ *     linePadding=0
+ *
+ * Only @c bits is required. Descriptors of a layout with a bpp of its own
+ * (8, 12, 16, highZero, MIPI RAW10 / RAW12 / RAW14) run the specialized
+ * kernels of that bpp, see LuxPackingToBpp().
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXPACKING_H
+#define LUXPACKING_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+/// Order of the bytes of a group word
+enum LuxByteOrder {
+    LUX_BYTES_BIG = 0,
+    LUX_BYTES_LITTLE = 1,
+};
+
+/// Where the first sample of a group sits
+enum LuxBitOrder {
+    LUX_BITS_MSB_FIRST = 0,  ///< Most significant end of the word
+    LUX_BITS_LSB_FIRST = 1,  ///< Least significant end of the word
+    LUX_BITS_MIPI = 2,       ///< High bytes, then the low bits LSB first
+};
+
+/// Where the containerBits - bits padding bits of a sample sit
+enum LuxPadPosition {
+    LUX_PAD_HIGH = 0,  ///< 0000AAAA AAAAAAAA
+    LUX_PAD_LOW = 1,   ///< AAAAAAAA AAAA0000
+};
+
+struct LuxPackingDesc {
+    int bits;           ///< Significant bits of a sample, [1, 16]
+    int containerBits;  ///< Bits a sample takes in the group, [bits, 16]
+    int group;          ///< Samples per group, the group fills whole bytes
+    int byteOrder;      ///< LuxByteOrder
+    int bitOrder;       ///< LuxBitOrder
+    int padPosition;    ///< LuxPadPosition
+    int linePadding;    ///< Bytes after the samples of every line
+};
+
+/// Flags of LuxPackingUnpack()
+enum LuxUnpackFlags {
+    LUX_UNPACK_STRETCH16 = 1 << 0,    ///< Scale the samples to 16 bits
+    LUX_UNPACK_BIG_ENDIAN = 1 << 1,   ///< Store big endian, as the raw loaders
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief 1 if @c desc describes a layout the unpacker reads, else 0.
+DLL_EXPORT
+int LuxPackingValid(const LuxPackingDesc *desc);
+
+/**
+ * @brief Parse the text form of a descriptor, the missing keys get their
+ * defaults: container = bits, the smallest group filling whole bytes, big
+ * endian, MSB first, padding high, no line padding.
+ * @return 0, or -1 (logged) if a key or a value is wrong.
+ */
+DLL_EXPORT
+int LuxPackingParse(const char *text, LuxPackingDesc *desc);
+
+/**
+ * @brief Read a descriptor from a sidecar file, or from the [packing]
+ * section of an ini file such as para.ini.
+ * @return 0, -1 if the file can't be opened, -2 if it has no descriptor,
+ * -3 (logged) if the descriptor is wrong.
+ */
+DLL_EXPORT
+int LuxPackingLoad(const char *fileName, LuxPackingDesc *desc);
+
+/// @brief Text form of @c desc into @c text, as read by LuxPackingParse().
+/// @return The length of the text, -1 if @c size is too small.
+DLL_EXPORT
+int LuxPackingFormat(const LuxPackingDesc *desc, char *text, int size);
+
+/**
+ * @brief The bpp (and endianness, highZero) of the raw loaders with the
+ * same layout as @c desc, which then take the frame as is.
+ * @return 0, or -1 if the layout has no bpp of its own or line padding.
+ */
+DLL_EXPORT
+int LuxPackingToBpp(const LuxPackingDesc *desc, int *bpp, bool *isBigEndian,
+                    bool *highZero);
+
+/// @brief Bytes of a line of @c samples samples with its padding, 0 if the
+/// samples do not fill whole groups.
+DLL_EXPORT
+uint64_t LuxPackingRowBytes(const LuxPackingDesc *desc, uint64_t samples);
+
+/**
+ * @brief Unpack the samples of @c imgData into 16-bit, the rows in parallel.
+ *
+ * Layouts with a bpp of their own use its kernels, the others a generic
+ * group-word unpacker.
+ *
+ * @param width Samples per row (width x channels), whole groups
+ * @param flags LuxUnpackFlags. With LUX_UNPACK_STRETCH16 and
+ * LUX_UNPACK_BIG_ENDIAN, @c out is a 16-bit big endian frame for the raw
+ * loaders, with the same windows (modes) as the packed samples.
+ * @param out width x height samples
+ * @return long long
+ * The number of samples if success.
+ *  -1 : The descriptor is wrong.
+ *  -4 : width or height or length are wrong.
+ */
+DLL_EXPORT
+long long LuxPackingUnpack(const LuxPackingDesc *desc,
+                           const unsigned char *imgData,
+                           unsigned long long length, int width, int height,
+                           unsigned int flags, uint16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
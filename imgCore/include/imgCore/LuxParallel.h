@@ -0,0 +1,85 @@
+/**
+ * @file LuxParallel.h
+ * @brief The thread pool shared by the imgCore kernels.
+ *
+ * One work-stealing pool for the whole library: LuxParallelFor() bands, the
+ * OpenCV kernels (cvtColor, ...) run by the loaders, and the nested calls
+ * between them. Every worker owns a deque per priority: the bands of a call
+ * made on a worker go to its own deque, those of any other thread to a shared
+ * queue, and idle workers steal from the others. Interactive bands are always
+ * taken before background ones, so a preview is not queued behind a batch.
+ *
+ * @version 1.1
+ */
+
+#ifndef LUXPARALLEL_H
+#define LUXPARALLEL_H
+
+#include <cstdint>
+#include <functional>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+/// Priority of the bands of LuxParallelFor()
+enum LuxTaskPriority {
+    LUX_PRIORITY_INTERACTIVE = 0,  ///< What is on screen, the default
+    LUX_PRIORITY_BACKGROUND = 1,   ///< Prefetch, batch conversion
+};
+
+/// @brief Split [begin, end) into bands of at least @c grain items and run
+/// @c body(bandBegin, bandEnd) on them in the pool, at the priority of the
+/// calling thread. The calling thread takes part in the work and the call
+/// returns when every band is done; an exception of @c body is rethrown.
+void LuxParallelFor(int64_t begin, int64_t end, int64_t grain,
+                    const std::function<void(int64_t, int64_t)> &body);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Threads running the kernels, the calling thread included.
+ * @param threads 1 runs everything on the calling thread, 0 (the default)
+ * one per core.
+ * @return The number of threads now in use.
+ */
+DLL_EXPORT
+int LuxSetNumThreads(int threads);
+
+/// @brief Threads running the kernels, the calling thread included.
+DLL_EXPORT
+int LuxGetNumThreads();
+
+/// @brief Priority (LuxTaskPriority) of the calls made on the calling thread
+/// from now on. Bands run in the pool keep the priority of their call.
+DLL_EXPORT
+void LuxSetTaskPriority(int priority);
+
+/// @brief Priority (LuxTaskPriority) of the calls of the calling thread.
+DLL_EXPORT
+int LuxGetTaskPriority();
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @brief LuxSetTaskPriority() for the lifetime of the object.
+class LuxPriorityScope {
+public:
+    explicit LuxPriorityScope(int priority) : saved_(LuxGetTaskPriority()) {
+        LuxSetTaskPriority(priority);
+    }
+    ~LuxPriorityScope() { LuxSetTaskPriority(saved_); }
+
+    LuxPriorityScope(const LuxPriorityScope &) = delete;
+    LuxPriorityScope &operator=(const LuxPriorityScope &) = delete;
+
+private:
+    int saved_;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file LuxProfile.h
+ * @brief Row and column mean profiles of each Bayer channel: the fixed
+ * pattern noise of a sensor, banding along the rows or the columns.
+ *
+ * One pass over the frame: every row is unpacked (calibrated and defect
+ * corrected as in LuxStats.h), summed per site and added to the column sums
+ * of its parity, 8 samples at a time with SSE2, the rows in parallel. The
+ * profiles of a single frame mix the temporal noise in; those of a mean map
+ * (LuxTemporal.h) show the fixed pattern alone.
+ *
+ * Layout of the profiles, the site of (x, y) being ((y & 1) << 1) | (x & 1):
+ *  - rowMeans[2 * y + k]: the mean of the samples x = k, k + 2, ... of row y;
+ *  - columnMeans[2 * x + r]: the mean of the samples y = r, r + 2, ... of
+ *    column x.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXPROFILE_H
+#define LUXPROFILE_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+struct LuxFpnResult {
+    int width;  ///< Samples per row
+    int height;
+    /// Per Bayer site of the frame, in the order (0, 0), (0, 1), (1, 0),
+    /// (1, 1): R, Gr, Gb, B for RGGB
+    double mean[4];
+    double rowNoise[4];     ///< Standard deviation of the row means
+    double columnNoise[4];  ///< Standard deviation of the column means
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Profiles of the raw @c imgData, layouts and parameters as for
+ * LuxDecodeMulti().
+ *
+ * @param rowMeans 2 x height floats, or nullptr
+ * @param columnMeans 2 x width floats, or nullptr
+ * @param result Output, may be nullptr
+ * @return long long
+ * The number of samples if success.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -4 : width or height or bpp or length are wrong.
+ */
+DLL_EXPORT
+long long LuxComputeFpnProfiles(const unsigned char *imgData,
+                                unsigned long long length, int width,
+                                int height, int bpp, bool isBigEndian,
+                                bool highZero, float *rowMeans,
+                                float *columnMeans, LuxFpnResult *result);
+
+/// @brief LuxComputeFpnProfiles() of @c width x @c height float samples,
+/// e.g. the mean map of LuxTemporalFromFiles(). -4 if the geometry is wrong.
+DLL_EXPORT
+long long LuxComputeFpnProfilesF(const float *image, int width, int height,
+                                 float *rowMeans, float *columnMeans,
+                                 LuxFpnResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
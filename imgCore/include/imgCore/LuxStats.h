@@ -0,0 +1,89 @@
+/**
+ * @file LuxStats.h
+ * @brief Per Bayer channel statistics of a raw frame in one pass.
+ *
+ * Count, sum, sum of squares, min and max are accumulated while the rows are
+ * unpacked, together with a histogram at the full bit depth of the samples,
+ * so the percentiles are exact. Over the full frame or a region of interest,
+ * the rows in parallel.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXSTATS_H
+#define LUXSTATS_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+/// Percentiles of one LuxComputeBayerStats() call, at most
+#define LUX_STATS_MAX_PERCENTILES 8
+
+/// Region of interest in samples, (x, y) the top left corner
+struct LuxRoi {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+struct LuxChannelStats {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t sumSquares;
+    uint16_t min;
+    uint16_t max;
+    double mean;
+    double stddev;  ///< Population standard deviation
+    /// Sample value of LuxBayerStats::percentileRanks[i], nearest rank
+    uint16_t percentiles[LUX_STATS_MAX_PERCENTILES];
+};
+
+struct LuxBayerStats {
+    int significantBits;  ///< 8, 12 or 16
+    LuxRoi roi;           ///< The region used, the full frame by default
+    int percentileCount;
+    double percentileRanks[LUX_STATS_MAX_PERCENTILES];  ///< [0, 100]
+    /// Per Bayer site of the frame, in the order (0, 0), (0, 1), (1, 0),
+    /// (1, 1): R, Gr, Gb, B for RGGB. The site follows the frame, not the ROI.
+    LuxChannelStats channels[4];
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Statistics of each Bayer channel of @c imgData.
+ *
+ * Sample layouts as for LuxDecodeMulti().
+ *
+ * @param width Samples per row (width x channels)
+ * @param roi The region, nullptr for the full frame
+ * @param percentileRanks @c percentileCount ranks in [0, 100], e.g. {1, 50,
+ * 99}; may be nullptr if @c percentileCount is 0
+ * @param stats Output
+ * @return long long
+ * The number of samples in the region if success.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -4 : width or height or bpp or length are wrong.
+ *  -6 : The ROI or the percentiles are wrong, or @c stats is nullptr.
+ */
+DLL_EXPORT
+long long LuxComputeBayerStats(const unsigned char *imgData,
+                               unsigned long long length, int width,
+                               int height, int bpp, bool isBigEndian,
+                               bool highZero, const LuxRoi *roi,
+                               const double *percentileRanks,
+                               int percentileCount, LuxBayerStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file LuxTemporal.h
+ * @brief Per-pixel mean and temporal noise of a stack of raw frames.
+ *
+ * The frames stream through a running mean and sum of squared deviations
+ * per pixel (Welford), two 32-bit floats per sample, 4 samples at a time
+ * with SSE2: the memory is two planes of the frame whatever the number of
+ * frames. Every row is accumulated right after it is unpacked (calibrated
+ * and defect corrected as in LuxStats.h), the rows in parallel, while the
+ * next frame is read from its file.
+ *
+ * The result is a mean map, a noise map (the standard deviation of every
+ * pixel over the frames) and per Bayer channel summaries.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXTEMPORAL_H
+#define LUXTEMPORAL_H
+
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+struct LuxTemporalChannel {
+    uint64_t count;        ///< Pixels of the site
+    double mean;           ///< Mean of the mean map
+    /// RMS temporal noise: the square root of the mean per-pixel variance
+    double temporalNoise;
+    /// Standard deviation of the mean map: the fixed pattern noise left
+    /// after averaging (temporalNoise / sqrt(frames) of it is residual
+    /// temporal noise)
+    double spatialNoise;
+    float maxNoise;  ///< Noisiest pixel, standard deviation
+};
+
+struct LuxTemporalResult {
+    int frames;
+    int significantBits;
+    int width;   ///< Samples per row
+    int height;
+    /// Per Bayer site of the frame, in the order (0, 0), (0, 1), (1, 0),
+    /// (1, 1): R, Gr, Gb, B for RGGB
+    LuxTemporalChannel channels[4];
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Mean and noise of the frames of @c count files, each read as
+ * LuxReadFrameFromFile(): headerless raws, LuxCodec streams or containers.
+ * Layouts and parameters as for LuxDecodeMulti().
+ *
+ * @param meanMap width x height floats, or nullptr
+ * @param noiseMap width x height floats (standard deviation over the
+ * frames, 0 with one frame), or nullptr
+ * @param result Output, may be nullptr
+ * @return long long
+ * The number of frames if success.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -3 : A file can not be opened.
+ *  -4 : width or height or bpp are wrong, or a frame has another length.
+ *  -6 : No file.
+ */
+DLL_EXPORT
+long long LuxTemporalFromFiles(const char *const *fileNames, int count,
+                               int width, int height, int bpp,
+                               bool isBigEndian, bool highZero, float *meanMap,
+                               float *noiseMap, LuxTemporalResult *result);
+
+/**
+ * @brief LuxTemporalFromFiles() of one headerless capture holding frames
+ * back to back, its size a multiple of the frame.
+ * @param maxFrames The first frames only, <= 0: all of them
+ */
+DLL_EXPORT
+long long LuxTemporalFromSequence(const char *fileName, int maxFrames,
+                                  int width, int height, int bpp,
+                                  bool isBigEndian, bool highZero,
+                                  float *meanMap, float *noiseMap,
+                                  LuxTemporalResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @brief The running mean and variance of frames of @c width samples x
+/// @c height rows, added one at a time from memory. Exported whole: the
+/// viewer and the bench link it from the library.
+class DLL_EXPORT LuxTemporalAccumulator {
+public:
+    LuxTemporalAccumulator(int width, int height, int bpp, bool isBigEndian,
+                           bool highZero);
+
+    /**
+     * @brief Accumulate the frame @c imgData.
+     * @return The number of frames so far, or as LuxTemporalFromFiles() if
+     * the frame is wrong (not accumulated).
+     */
+    long long add(const unsigned char *imgData, unsigned long long length);
+
+    int frames() const { return frames_; }
+
+    /// @brief The maps and the summaries of the frames so far, see
+    /// LuxTemporalFromFiles(). @return The number of frames, -6 without.
+    long long finish(float *meanMap, float *noiseMap,
+                     LuxTemporalResult *result) const;
+
+    void reset();
+
+private:
+    std::vector<float> mean_;
+    std::vector<float> m2_;  ///< Sum of the squared deviations
+    int width_;
+    int height_;
+    int bpp_;
+    int bits_;
+    bool isBigEndian_;
+    int frames_;
+};
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file LuxTrace.h
+ * @brief Scoped stage timers for the load / display pipeline.
+ *
+ * Wrap a stage with LUX_TRACE_SCOPE("parse"). The timers only exist when the
+ * tree is configured with -DZIWI_ENABLE_TRACE=ON (LUX_ENABLE_TRACE defined),
+ * otherwise the macro expands to nothing. The recorded events can be dumped
+ * as Chrome trace-event JSON (chrome://tracing, Perfetto) and aggregated into
+ * per-stage percentiles for the whole session.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXTRACE_H
+#define LUXTRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+/// Per-stage aggregate, times in microseconds
+struct LuxTraceStat {
+    std::string name;
+    uint64_t count;
+    double total;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Nanoseconds since the first trace call, steady clock.
+DLL_EXPORT
+uint64_t LuxTraceNow();
+
+/// @brief Record a finished stage. @c name must outlive the session, string
+/// literals are expected.
+DLL_EXPORT
+void LuxTraceRecord(const char *name, uint64_t beginNs, uint64_t endNs);
+
+/// @brief Turn recording on/off at runtime, on by default.
+DLL_EXPORT
+void LuxTraceEnable(bool enable);
+
+DLL_EXPORT
+bool LuxTraceEnabled();
+
+/// @brief Drop every recorded event.
+DLL_EXPORT
+void LuxTraceReset();
+
+/**
+ * @brief Write the recorded events as Chrome trace-event JSON.
+ * @return The number of events written, -3 if the file can not be opened.
+ */
+DLL_EXPORT
+long long LuxTraceDump(const char *fileName);
+
+/**
+ * @brief Write the per-stage percentile table, to stderr if @c fileName is
+ * nullptr.
+ * @return The number of stages, -3 if the file can not be opened.
+ */
+DLL_EXPORT
+int LuxTraceWriteSummary(const char *fileName);
+
+#ifdef __cplusplus
+}
+#endif
+
+/// @brief Per-stage aggregate of the session, sorted by total time.
+std::vector<LuxTraceStat> LuxTraceStats();
+
+class LuxTraceScope {
+public:
+    explicit LuxTraceScope(const char *name)
+        : name_(LuxTraceEnabled() ? name : nullptr),
+          begin_(name_ ? LuxTraceNow() : 0) {}
+    ~LuxTraceScope() {
+        if (name_) LuxTraceRecord(name_, begin_, LuxTraceNow());
+    }
+
+    LuxTraceScope(const LuxTraceScope &) = delete;
+    LuxTraceScope &operator=(const LuxTraceScope &) = delete;
+
+private:
+    const char *name_;
+    uint64_t begin_;
+};
+
+#define LUX_TRACE_CONCAT_(a, b) a##b
+#define LUX_TRACE_CONCAT(a, b) LUX_TRACE_CONCAT_(a, b)
+
+#ifdef LUX_ENABLE_TRACE
+#define LUX_TRACE_SCOPE(name) \
+    LuxTraceScope LUX_TRACE_CONCAT(luxTraceScope_, __LINE__)(name)
+#else
+#define LUX_TRACE_SCOPE(name) \
+    do {                      \
+    } while (0)
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file LuxUnpack.h
+ * @brief Sample packings and the row unpacking shared by the single-pass
+ * imgCore kernels.
+ *
+ * The @c bpp argument of the library selects the packing:
+ *  - 8, 16: one sample per byte / per 2 bytes (16-bit with @c highZero:
+ *    0000AAAA AAAAAAAA);
+ *  - 12: 2 samples in 3 bytes, AAAAAAAA AAAABBBB BBBBBBBB;
+ *  - LUX_BPP_RAW10 / RAW12 / RAW14: MIPI CSI-2, the most significant 8 bits
+ *    of each sample of a group first, then the low bits of the group.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXUNPACK_H
+#define LUXUNPACK_H
+
+#include <cstdint>
+
+/// bpp values of the MIPI CSI-2 packings. Bytes carry no endianness there,
+/// @c isBigEndian is ignored.
+enum LuxMipiBpp {
+    LUX_BPP_MIPI = 0x100,               ///< Flag of the CSI-2 packings
+    LUX_BPP_RAW10 = LUX_BPP_MIPI | 10,  ///< 4 samples in 5 bytes
+    LUX_BPP_RAW12 = LUX_BPP_MIPI | 12,  ///< 2 samples in 3 bytes
+    LUX_BPP_RAW14 = LUX_BPP_MIPI | 14,  ///< 4 samples in 7 bytes
+};
+
+/// @brief Samples of one packing group, 0 if @c bpp is not supported.
+inline int LuxPackingGroup(int bpp) {
+    switch (bpp) {
+        case 8:
+        case 16:
+            return 1;
+        case 12:
+        case LUX_BPP_RAW12:
+            return 2;
+        case LUX_BPP_RAW10:
+        case LUX_BPP_RAW14:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+/// @brief Bytes of @c samples packed samples, 0 if @c bpp is not supported
+/// or the samples do not fill whole groups. Integer math: no rounding on
+/// any frame size.
+inline uint64_t LuxPackedBytes(uint64_t samples, int bpp) {
+    const int group = LuxPackingGroup(bpp);
+    if (group == 0 || samples % group != 0) return 0;
+    return samples / group * (group * (bpp & 0xFF) / 8);
+}
+
+/// @brief Bits of a sample: 16-bit frames with @c highZero hold 12 bits.
+inline int LuxSignificantBits(int bpp, bool highZero) {
+    return bpp == 16 && highZero ? 12 : bpp & 0xFF;
+}
+
+/// Where the rows of a frame sit in their buffers, for captures with line
+/// padding and embedded data lines. All 0: tightly packed rows.
+struct LuxFrameLayout {
+    uint64_t inStride;   ///< Bytes from an input row to the next, 0: packed
+    int topLines;        ///< Lines of @c inStride bytes before the first row
+    int bottomLines;     ///< Lines of @c inStride bytes after the last row
+    uint64_t outStride;  ///< Samples from an output row to the next, 0: width
+};
+
+/// @brief Bytes from an input row to the next, 0 if @c inStride is shorter
+/// than the @c rowBytes of the samples of a row.
+inline uint64_t LuxLayoutInStride(const LuxFrameLayout *layout,
+                                  uint64_t rowBytes) {
+    if (layout == nullptr || layout->inStride == 0) return rowBytes;
+    return layout->inStride >= rowBytes ? layout->inStride : 0;
+}
+
+/// @brief Samples from an output row to the next, 0 if @c outStride is
+/// shorter than @c width.
+inline uint64_t LuxLayoutOutStride(const LuxFrameLayout *layout, int width) {
+    if (layout == nullptr || layout->outStride == 0) return width;
+    return layout->outStride >= static_cast<uint64_t>(width)
+               ? layout->outStride
+               : 0;
+}
+
+/// @brief Check a frame of @c width samples per row before unpacking it.
+/// @return 0, -2 (bpp not supported) or -4 (geometry / length wrong), the
+/// message is logged.
+int LuxCheckFrame(const unsigned char *imgData, unsigned long long length,
+                  int width, int height, int bpp);
+
+/// @brief LuxCheckFrame() of a frame laid out as @c layout (nullptr: packed),
+/// the length includes the embedded data lines.
+int LuxCheckFrameLayout(const unsigned char *imgData,
+                        unsigned long long length, int width, int height,
+                        int bpp, const LuxFrameLayout *layout);
+
+/// @brief Sample values of @c width samples (whole groups) of any packing,
+/// 16-bit samples masked by @c mask. RAW10 and RAW12 use SSSE3 when the CPU
+/// has it.
+void LuxUnpackRow(const uint8_t *src, uint16_t *dst, int width, int bpp,
+                  bool bigEndian, uint16_t mask);
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file LuxWriter.h
+ * @brief Bounded background queue for the TIFF / PNG encodes of the loaders.
+ *
+ * LuxWriterSubmit() copies the pixels and returns at once (it only blocks
+ * while the queue is full), so decoding the next frame overlaps with encoding
+ * the previous one. LuxWriterWait() / LuxWriterFlush() join the encodes,
+ * LuxWriterShutdown() joins them and the workers before the program exits;
+ * it runs at exit() too, so the files of the loaders (saveTiff) are written
+ * even if the caller never waits.
+ *
+ * @version 1.0
+ */
+
+#ifndef LUXWRITER_H
+#define LUXWRITER_H
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define DLL_EXPORT __declspec(dllexport)
+#else
+#define DLL_EXPORT
+#endif
+
+enum LuxWriterCodec {
+    LUX_WRITER_TIFF_NONE = 0,
+    LUX_WRITER_TIFF_LZW,
+    LUX_WRITER_TIFF_DEFLATE,
+    LUX_WRITER_PNG,
+    LUX_WRITER_CODEC_COUNT
+};
+
+struct LuxWriterConf {
+    int codec;       ///< LuxWriterCodec
+    int level;       ///< PNG compression level [0, 9], ignored by TIFF
+    int queueDepth;  ///< Encodes waiting at most, Submit blocks beyond that
+    int threads;     ///< Encoder threads
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Replace the writer configuration. Pending encodes are flushed first.
+ * Default: TIFF / LZW, queue depth 4, 2 threads.
+ * @return 0 if success, -1 if the configuration is wrong or the writer is
+ * shut down.
+ */
+DLL_EXPORT
+int LuxWriterConfigure(const LuxWriterConf *conf);
+
+DLL_EXPORT
+void LuxWriterGetConf(LuxWriterConf *conf);
+
+/**
+ * @brief Queue an encode of @c imgData, the pixels are copied.
+ *
+ * @param type CV_8UC1, CV_8UC3, CV_16UC1 or CV_16UC3
+ * @param outFileName ".tiff" or ".png" is appended if missing, a ".tif",
+ * ".tiff" or ".png" suffix of the other codec replaced
+ * @param isRGB 3-channel data is RGB (converted to BGR for OpenCV)
+ * @return long long
+ *  > 0 : Ticket of the encode, see LuxWriterWait().
+ *  -1 : Type Don't Supported.
+ *  -2 : The writer is shut down.
+ */
+DLL_EXPORT
+long long LuxWriterSubmit(const void *imgData, int width, int height, int type,
+                          const char *outFileName, bool isRGB);
+
+/**
+ * @brief Wait for the encode of @c ticket.
+ * @return 0 if the file was written, -1 if the encode failed. Only the last
+ * 256 failed tickets are remembered, LuxWriterFlush() forgets them.
+ */
+DLL_EXPORT
+int LuxWriterWait(long long ticket);
+
+/**
+ * @brief Wait for every queued encode.
+ * @return The number of encodes failed since the last flush.
+ */
+DLL_EXPORT
+int LuxWriterFlush();
+
+/**
+ * @brief Wait for every queued encode and stop the encoder threads; later
+ * submits fail. It is registered with std::atexit(); call it before
+ * main() returns all the same where the exit order matters, e.g. from a
+ * DLL unloaded at exit.
+ * @return The number of encodes failed since the last flush.
+ */
+DLL_EXPORT
+int LuxWriterShutdown();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
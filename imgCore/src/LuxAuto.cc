@@ -0,0 +1,195 @@
+/**
+ * @file LuxAuto.cc
+ */
+
+#include <imgCore/LuxAuto.h>
+#include <imgCore/LuxCalib.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+/// Quads of the subsample when the step is automatic
+constexpr double kAutoQuads = 32768.0;
+/// Bits of the histogram bins, at most
+constexpr int kHistBits = 10;
+/// Bound of the factors of LuxSetChannelFactors()
+constexpr float kMaxFactor = 10.0f;
+
+/// Color (0 R, 1 G, 2 B) of the Bayer sites (0, 0), (0, 1), (1, 0), (1, 1)
+constexpr int kSiteColor[4][4] = {
+    {1, 2, 0, 1},  // GBRG
+    {1, 0, 2, 1},  // GRBG
+    {2, 1, 1, 0},  // BGGR
+    {0, 1, 1, 2},  // RGGB
+};
+
+/// Samples x and x + 1 (x even) of a row, read in place
+inline void samplePair(const uint8_t *row, int x, int bpp, bool bigEndian,
+                       uint16_t mask, uint16_t *v) {
+    if (bpp == 8) {
+        v[0] = row[x];
+        v[1] = row[x + 1];
+    } else if (bpp == 12) {
+        /// AAAAAAAA AAAABBBB BBBBBBBB
+        const uint8_t *p = row + x / 2 * 3;
+        v[0] = static_cast<uint16_t>((p[0] << 4) | (p[1] >> 4));
+        v[1] = static_cast<uint16_t>(((p[1] & 0x0F) << 8) | p[2]);
+    } else if (bpp & LUX_BPP_MIPI) {
+        /// Unpack the group holding the pair
+        const int group = LuxPackingGroup(bpp);
+        uint16_t g[4];
+        LuxUnpackRow(row + LuxPackedBytes(x / group * group, bpp), g, group,
+                     bpp, bigEndian, mask);
+        v[0] = g[x % group];
+        v[1] = g[x % group + 1];
+    } else {
+        const uint8_t *p = row + 2 * x;
+        for (int k = 0; k < 2; ++k, p += 2)
+            v[k] = static_cast<uint16_t>(bigEndian ? (p[0] << 8) | p[1]
+                                                   : p[0] | (p[1] << 8)) &
+                   mask;
+    }
+}
+
+/// First bin whose cumulative count reaches @c rank percent
+int percentileBin(const uint32_t *histogram, int bins, uint64_t count,
+                  double rank) {
+    uint64_t target = static_cast<uint64_t>(std::ceil(rank / 100.0 * count));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t cumulative = 0;
+    for (int i = 0; i < bins; ++i) {
+        cumulative += histogram[i];
+        if (cumulative >= target) return i;
+    }
+    return bins - 1;
+}
+
+bool validConf(const LuxAutoConf *c) {
+    return c != nullptr && c->awb >= LUX_AWB_NONE &&
+           c->awb <= LUX_AWB_WHITE_PATCH && c->mode >= 0 && c->mode <= 4 &&
+           c->bayerType >= 0 &&
+           c->bayerType <= 3 && c->lowPercentile >= 0 &&
+           c->lowPercentile <= c->highPercentile && c->highPercentile <= 100;
+}
+
+}  // namespace
+
+long long LuxAutoTune(const unsigned char *imgData, unsigned long long length,
+                      int width, int height, int bpp, bool isBigEndian,
+                      bool highZero, const LuxAutoConf *conf,
+                      LuxAutoResult *result) {
+    LUX_TRACE_SCOPE("auto_tune");
+    int ret = LuxCheckFrame(imgData, length, width, height, bpp);
+    if (ret < 0) return ret;
+    if (!validConf(conf) || result == nullptr || width < 2 || height < 2) {
+        std::cerr << "Auto tune request is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -6;
+    }
+
+    const int bits = LuxSignificantBits(bpp, highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << bits) - 1);
+    const int histShift = std::max(0, bits - kHistBits);
+    const int bins = 1 << (bits - histShift);
+    const uint64_t inRow = LuxPackedBytes(width, bpp);
+    const int quadsX = width / 2, quadsY = height / 2;
+    int step = conf->step;
+    if (step <= 0)
+        step = std::max(1, static_cast<int>(std::lround(std::sqrt(
+                               static_cast<double>(quadsX) * quadsY /
+                               kAutoQuads))));
+
+    /// Per color: R, G (both sites), B
+    uint32_t histogram[3][1 << kHistBits] = {};
+    uint64_t sum[3] = {0, 0, 0}, count[3] = {0, 0, 0};
+    uint16_t max = 0;
+    const int *color = kSiteColor[conf->bayerType];
+    const LuxCalibPass calib(width, height, bits);
+
+    for (int qy = 0; qy < quadsY; qy += step) {
+        const uint8_t *rows[2] = {imgData + 2 * qy * inRow,
+                                  imgData + (2 * qy + 1) * inRow};
+        for (int qx = 0; qx < quadsX; qx += step) {
+            for (int r = 0; r < 2; ++r) {
+                uint16_t v[2];
+                samplePair(rows[r], 2 * qx, bpp, isBigEndian, mask, v);
+                if (calib.active()) calib.apply(2 * qy + r, v, 2 * qx, 2);
+                for (int k = 0; k < 2; ++k) {
+                    const int c = color[(r << 1) | k];
+                    sum[c] += v[k];
+                    ++count[c];
+                    ++histogram[c][v[k] >> histShift];
+                    max = std::max(max, v[k]);
+                }
+            }
+        }
+    }
+
+    /// Black: lower edge of its bin, white: upper edge
+    uint16_t black[3], white[3];
+    for (int c = 0; c < 3; ++c) {
+        black[c] = static_cast<uint16_t>(
+            percentileBin(histogram[c], bins, count[c], conf->lowPercentile)
+            << histShift);
+        white[c] = static_cast<uint16_t>(
+            ((percentileBin(histogram[c], bins, count[c],
+                            conf->highPercentile) +
+              1)
+             << histShift) -
+            1);
+    }
+
+    float gains[3] = {1.0f, 1.0f, 1.0f};
+    if (conf->awb != LUX_AWB_NONE) {
+        double level[3];
+        for (int c = 0; c < 3; ++c)
+            level[c] = conf->awb == LUX_AWB_GRAY_WORLD
+                           ? static_cast<double>(sum[c]) / count[c]
+                           : white[c];
+        for (int c : {0, 2})
+            if (level[c] > 0)
+                gains[c] = static_cast<float>(level[1] / level[c]);
+    }
+
+    ::memset(result, 0, sizeof(*result));
+    int mode = conf->mode;
+    result->exposureGain = 1.0f;
+    result->black = *std::min_element(black, black + 3);
+    result->white = *std::max_element(white, white + 3);
+    result->step = step;
+
+    if (conf->autoLevels) {
+        /// The widest window that does not wrap the brightest sample, then
+        /// a gain taking the balanced white point to 255
+        mode = 0;
+        while (mode < 4 && bits - 8 - (mode + 1) >= 0 &&
+               (max >> (bits - 8 - (mode + 1))) <= UINT8_MAX)
+            ++mode;
+        const int shift = bits > 8 ? bits - 8 - mode : 0;
+        float white8 = 0;
+        for (int c = 0; c < 3; ++c)
+            white8 = std::max(white8, (white[c] >> shift) * gains[c]);
+        if (white8 > 0) result->exposureGain = UINT8_MAX / white8;
+    }
+    result->mode = mode;
+
+    /// The factors of LuxSetChannelFactors() are bounded: scale them down
+    /// together, the balance is kept
+    float factors[3];
+    for (int c = 0; c < 3; ++c)
+        factors[c] = gains[c] * result->exposureGain;
+    float top = *std::max_element(factors, factors + 3);
+    if (top > kMaxFactor)
+        for (auto &f : factors) f *= kMaxFactor / top;
+    result->r = factors[0];
+    result->g = factors[1];
+    result->b = factors[2];
+    return static_cast<long long>(count[0] + count[1] + count[2]);
+}
@@ -0,0 +1,300 @@
+/**
+ * @file LuxCalib.cc
+ */
+
+#include <imgCore/LuxCalib.h>
+#include <imgCore/LuxContainer.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LUX_HAVE_SSE2 1
+#endif
+
+/// Offset and gain of every sample of the frames of one geometry
+struct LuxCalibData {
+    int width;
+    int height;
+    int bits;
+    std::vector<uint16_t> offset;
+    std::vector<uint16_t> gain;
+};
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+/// Fixed point of the gains, 4.12: up to 16x
+constexpr int kGainBits = 12;
+constexpr double kUnity = 1 << kGainBits;
+
+/// A calibration frame, unpacked
+struct CalibFrame {
+    int width;
+    int height;
+    int bits;
+    std::vector<uint16_t> samples;
+};
+
+std::shared_ptr<const CalibFrame> gFrames[2];
+std::shared_ptr<const LuxCalibData> gData;
+LuxCalibConf gConf{{0, 0, 0, 0}, 1};
+std::mutex gMutex;
+
+inline uint16_t toGain(double gain) {
+    return static_cast<uint16_t>(
+        std::min(std::lround(gain * kUnity), static_cast<long>(UINT16_MAX)));
+}
+
+/// [black, mask] back to [0, mask]
+inline double rescaleGain(uint16_t mask, double black) {
+    return gConf.rescale ? mask / std::max(1.0, mask - black) : 1.0;
+}
+
+/// gData of the frames and the black level, under gMutex
+void rebuild() {
+    const CalibFrame *dark = gFrames[LUX_CALIB_DARK].get();
+    const CalibFrame *flat = gFrames[LUX_CALIB_FLAT].get();
+    const CalibFrame *any = dark != nullptr ? dark : flat;
+    if (any == nullptr) {
+        gData = nullptr;
+        return;
+    }
+    LUX_TRACE_SCOPE("calib_build");
+
+    auto data = std::make_shared<LuxCalibData>();
+    const int width = data->width = any->width;
+    const int height = data->height = any->height;
+    data->bits = any->bits;
+    const uint16_t mask = static_cast<uint16_t>((1u << any->bits) - 1);
+    const uint64_t samples = static_cast<uint64_t>(width) * height;
+    auto site = [](int64_t y, int x) { return ((y & 1) << 1) | (x & 1); };
+
+    /// The offset, and the mean of each Bayer site of the offset and of the
+    /// flat field over it
+    data->offset.resize(samples);
+    double black[4], level[4] = {0, 0, 0, 0};
+    uint64_t sum[4] = {0, 0, 0, 0}, flatSum[4] = {0, 0, 0, 0};
+    uint64_t count[4] = {0, 0, 0, 0};
+    for (int64_t y = 0; y < height; ++y) {
+        uint16_t *offset = data->offset.data() + y * width;
+        const uint16_t *d =
+            dark != nullptr ? dark->samples.data() + y * width : nullptr;
+        const uint16_t *f =
+            flat != nullptr ? flat->samples.data() + y * width : nullptr;
+        for (int x = 0; x < width; ++x) {
+            const int s = site(y, x);
+            offset[x] = d != nullptr
+                            ? d[x]
+                            : static_cast<uint16_t>(
+                                  std::min<int>(gConf.blackLevel[s], mask));
+            sum[s] += offset[x];
+            if (f != nullptr && f[x] > offset[x])
+                flatSum[s] += f[x] - offset[x];
+            ++count[s];
+        }
+    }
+    for (int s = 0; s < 4; ++s) {
+        black[s] = count[s] > 0 ? static_cast<double>(sum[s]) / count[s] : 0;
+        if (count[s] > 0)
+            level[s] = static_cast<double>(flatSum[s]) / count[s];
+    }
+
+    data->gain.resize(samples);
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        for (int64_t y = lo; y < hi; ++y) {
+            const uint16_t *offset = data->offset.data() + y * width;
+            uint16_t *gain = data->gain.data() + y * width;
+            const uint16_t *f =
+                flat != nullptr ? flat->samples.data() + y * width : nullptr;
+            for (int x = 0; x < width; ++x) {
+                const int s = site(y, x);
+                double g = rescaleGain(mask, black[s]);
+                /// A dead pixel of the flat field is left as it is
+                if (f != nullptr && f[x] > offset[x])
+                    g *= level[s] / (f[x] - offset[x]);
+                gain[x] = toGain(g);
+            }
+        }
+    });
+    gData = std::move(data);
+}
+
+/// v = min((max(v - offset, 0) * gain) >> 12, mask)
+void calibrate(uint16_t *v, const uint16_t *offset, const uint16_t *gain,
+               int count, uint16_t mask) {
+    int x = 0;
+#ifdef LUX_HAVE_SSE2
+    /// The 32-bit product from its halves, saturated to 16 bits, then to
+    /// the mask: min(a, mask) = (a +sat k) -sat k with k = 0xFFFF - mask
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+    const __m128i k = _mm_set1_epi16(static_cast<short>(UINT16_MAX - mask));
+    for (; x + 8 <= count; x += 8) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x));
+        __m128i o =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(offset + x));
+        __m128i g =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(gain + x));
+        __m128i d = _mm_subs_epu16(in, o);
+        __m128i lo = _mm_mullo_epi16(d, g);
+        __m128i hi = _mm_mulhi_epu16(d, g);
+        __m128i out = _mm_or_si128(_mm_slli_epi16(hi, 16 - kGainBits),
+                                   _mm_srli_epi16(lo, kGainBits));
+        __m128i fits = _mm_cmpeq_epi16(_mm_srli_epi16(hi, kGainBits), zero);
+        out = _mm_or_si128(_mm_and_si128(fits, out),
+                           _mm_andnot_si128(fits, ones));
+        out = _mm_subs_epu16(_mm_adds_epu16(out, k), k);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v + x), out);
+    }
+#endif
+    for (; x < count; ++x) {
+        const uint32_t d = v[x] > offset[x] ? v[x] - offset[x] : 0;
+        v[x] = static_cast<uint16_t>(
+            std::min<uint32_t>((d * gain[x]) >> kGainBits, mask));
+    }
+}
+
+}  // namespace
+
+int LuxSetCalibConf(const LuxCalibConf *conf) {
+    if (conf == nullptr) return -1;
+    for (int black : conf->blackLevel)
+        if (black < 0 || black > UINT16_MAX) return -1;
+    std::lock_guard<std::mutex> lock(gMutex);
+    gConf = *conf;
+    rebuild();
+    return 0;
+}
+
+void LuxGetCalibConf(LuxCalibConf *conf) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (conf != nullptr) *conf = gConf;
+}
+
+long long LuxSetCalibFrame(int kind, const unsigned char *imgData,
+                           unsigned long long length, int width, int height,
+                           int bpp, bool isBigEndian, bool highZero) {
+    LUX_TRACE_SCOPE("calib_frame");
+    if (kind != LUX_CALIB_DARK && kind != LUX_CALIB_FLAT) return -1;
+    int ret = LuxCheckFrame(imgData, length, width, height, bpp);
+    if (ret < 0) return ret;
+
+    auto frame = std::make_shared<CalibFrame>();
+    frame->width = width;
+    frame->height = height;
+    frame->bits = LuxSignificantBits(bpp, highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << frame->bits) - 1);
+    const uint64_t inRow = LuxPackedBytes(width, bpp);
+    frame->samples.resize(static_cast<uint64_t>(width) * height);
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        for (int64_t y = lo; y < hi; ++y)
+            LuxUnpackRow(imgData + y * inRow,
+                         frame->samples.data() + y * width, width, bpp,
+                         isBigEndian, mask);
+    });
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    /// The other frame goes if it describes other frames
+    auto &other = gFrames[1 - kind];
+    if (other != nullptr &&
+        (other->width != width || other->height != height ||
+         other->bits != frame->bits))
+        other = nullptr;
+    gFrames[kind] = std::move(frame);
+    rebuild();
+    return static_cast<long long>(width) * height;
+}
+
+long long LuxLoadCalibFrame(int kind, const char *fileName, int width,
+                            int height, int bpp, bool isBigEndian,
+                            bool highZero) {
+    const uint64_t length = LuxPackedBytes(width, bpp) * height;
+    if (width <= 0 || height <= 0 || length == 0) return -4;
+
+    /// A plain container payload is unpacked from its mapping, no copy
+    if (LuxZrawIsContainer(fileName) == 1) {
+        LuxZrawFile file;
+        if (LuxZrawOpen(fileName, &file) == 0) {
+            const unsigned char *payload = LuxZrawPayload(&file);
+            long long ret = -4;
+            if (payload != nullptr &&
+                LuxZrawFrameBytes(&file.header) ==
+                    static_cast<long long>(length))
+                ret = LuxSetCalibFrame(kind, payload, length, width, height,
+                                       bpp, isBigEndian, highZero);
+            LuxZrawClose(&file);
+            if (ret >= 0) return ret;
+        }
+    }
+
+    std::vector<unsigned char> frame(length);
+    long long ret = LuxReadFrameFromFile(fileName, frame.data(), length);
+    if (ret < 0) return ret;
+    return LuxSetCalibFrame(kind, frame.data(), length, width, height, bpp,
+                            isBigEndian, highZero);
+}
+
+void LuxClearCalibFrame(int kind) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    for (int k = 0; k < 2; ++k)
+        if (kind == k || kind == -1) gFrames[k] = nullptr;
+    rebuild();
+}
+
+int LuxHasCalibFrame(int kind) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return (kind == LUX_CALIB_DARK || kind == LUX_CALIB_FLAT) &&
+                   gFrames[kind] != nullptr
+               ? 1
+               : 0;
+}
+
+LuxCalibPass::LuxCalibPass(int width, int height, int bits)
+    : width_(width),
+      mask_(static_cast<uint16_t>((1u << bits) - 1)),
+      active_(false) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gData != nullptr && gData->width == width &&
+        gData->height == height && gData->bits == bits) {
+        data_ = gData;
+        active_ = true;
+        return;
+    }
+
+    /// The black level alone: a pattern of two rows
+    int black[4];
+    for (int s = 0; s < 4; ++s) {
+        black[s] = std::min<int>(gConf.blackLevel[s], mask_);
+        active_ = active_ || black[s] > 0;
+    }
+    if (!active_) return;
+    for (int r = 0; r < 2; ++r) {
+        offset_[r].resize(width);
+        gain_[r].resize(width);
+        for (int x = 0; x < width; ++x) {
+            const int s = (r << 1) | (x & 1);
+            offset_[r][x] = static_cast<uint16_t>(black[s]);
+            gain_[r][x] = toGain(rescaleGain(mask_, black[s]));
+        }
+    }
+}
+
+void LuxCalibPass::apply(int64_t y, uint16_t *v, int x0, int count) const {
+    if (data_ != nullptr) {
+        const uint64_t at = static_cast<uint64_t>(y) * width_ + x0;
+        calibrate(v, data_->offset.data() + at, data_->gain.data() + at,
+                  count, mask_);
+    } else {
+        calibrate(v, offset_[y & 1].data() + x0, gain_[y & 1].data() + x0,
+                  count, mask_);
+    }
+}
@@ -8,6 +8,17 @@
  */
 
 #include <imgCore/LuxCheck.h>
+#include <imgCore/LuxParallel.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <cstring>  /// memcpy
+#include <iostream>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
 
 /*************************************************************************************************/
@@ -533,15 +544,107 @@ uint32_t LuxCRC32_mpeg_2(uint8_t* data, uint16_t length) {
 /*                                   CHECK SUM Function                                          */
 /*************************************************************************************************/
 
+namespace {
+
+/// Buffers above this size are summed by several threads.
+constexpr int64_t kCheckSumParallelBytes = 4 << 20;
+
+uint64_t LuxSumBytesScalar(uint8_t const *data, int64_t data_len) {
+    uint64_t sum = 0;
+    while (data_len--)
+        sum += *data++;
+    return sum;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+/// psadbw against zero adds 8 bytes into each 64-bit lane.
+uint64_t LuxSumBytesSSE2(uint8_t const *data, int64_t data_len) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+
+    int64_t i = 0;
+    for (; i + 32 <= data_len; i += 32) {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i v1 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 16));
+        acc0 = _mm_add_epi64(acc0, _mm_sad_epu8(v0, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_sad_epu8(v1, zero));
+    }
+    for (; i + 16 <= data_len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        acc0 = _mm_add_epi64(acc0, _mm_sad_epu8(v, zero));
+    }
+
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes),
+                    _mm_add_epi64(acc0, acc1));
+    return lanes[0] + lanes[1] + LuxSumBytesScalar(data + i, data_len - i);
+}
+#endif
+
+/// The tail goes to the SSE2 kernel: not on an i386 build without SSE2
+#if defined(__GNUC__) && defined(__SSE2__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define LUX_HAVE_AVX2_DISPATCH 1
+__attribute__((target("avx2")))
+uint64_t LuxSumBytesAVX2(uint8_t const *data, int64_t data_len) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+
+    int64_t i = 0;
+    for (; i + 64 <= data_len; i += 64) {
+        __m256i v0 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        __m256i v1 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_sad_epu8(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_sad_epu8(v1, zero));
+    }
+
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes),
+                       _mm256_add_epi64(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           LuxSumBytesSSE2(data + i, data_len - i);
+}
+#endif
+
+/// Sum of all bytes with the widest kernel of this CPU.
+uint64_t LuxSumBytes(uint8_t const *data, int64_t data_len) {
+#ifdef LUX_HAVE_AVX2_DISPATCH
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    if (hasAVX2) return LuxSumBytesAVX2(data, data_len);
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    return LuxSumBytesSSE2(data, data_len);
+#else
+    return LuxSumBytesScalar(data, data_len);
+#endif
+}
+
+/// Sum of all bytes, large buffers are split over several threads.
+uint64_t LuxSumBytesParallel(uint8_t const *data, int64_t data_len) {
+    if (data_len < kCheckSumParallelBytes) return LuxSumBytes(data, data_len);
+
+    std::atomic<uint64_t> sum{0};
+    LuxParallelFor(0, data_len, kCheckSumParallelBytes / 4,
+                   [&](int64_t lo, int64_t hi) {
+                       sum += LuxSumBytes(data + lo, hi - lo);
+                   });
+    return sum;
+}
+
+}  // namespace
+
 /// @brief Calculate the check sum
 /// @return The value of low bits (16 bit)
 uint16_t
 LuxCalcCheckSum(uint8_t const *data, int64_t data_len)
 {
-    uint64_t sum = 0;
-    while (data_len--)
-        sum += *data++;
-    return static_cast<uint16_t>(sum & 0xFFFF);
+    if (data_len <= 0) return 0;
+    return static_cast<uint16_t>(LuxSumBytesParallel(data, data_len) & 0xFFFF);
 }
 
 
@@ -551,10 +654,218 @@ LuxCalcCheckSum(uint8_t const *data, int64_t data_len)
 uint32_t
 LuxCalcCheckSum32(uint8_t const *data, int64_t data_len)
 {
-    uint64_t sum = 0;
-    while (data_len--)
-        sum += *data++;
-    return static_cast<uint32_t>(sum & 0xFFFFFFFF);
+    if (data_len <= 0) return 0;
+    return static_cast<uint32_t>(LuxSumBytesParallel(data, data_len) &
+                                 0xFFFFFFFF);
 }
 
 
+
+/*************************************************************************************************/
+/*                                   Integrity Verification                                      */
+/*************************************************************************************************/
+
+namespace {
+
+/// Register form of a CRC variant. The register is max(width, 8) bits wide,
+/// non-reflected polynomials of width < 8 are left aligned like LuxCRC5_epc.
+struct LuxCRCParam {
+    int width;
+    uint32_t poly;      // reflected polynomial if refin
+    uint32_t init;
+    bool refin;
+    uint32_t xorout;
+};
+
+const LuxCRCParam kCRCParams[LUX_CRC_COUNT] = {
+    {0, 0, 0, false, 0},                            // NONE
+    {4, 0x0C, 0x00, true, 0x00},                    // CRC-4/ITU
+    {5, 0x09, 0x09, false, 0x00},                   // CRC-5/EPC
+    {5, 0x15, 0x00, true, 0x00},                    // CRC-5/ITU
+    {5, 0x14, 0x1F, true, 0x1F},                    // CRC-5/USB
+    {6, 0x30, 0x00, true, 0x00},                    // CRC-6/ITU
+    {7, 0x09, 0x00, false, 0x00},                   // CRC-7/MMC
+    {8, 0x07, 0x00, false, 0x00},                   // CRC-8
+    {8, 0x07, 0x00, false, 0x55},                   // CRC-8/ITU
+    {8, 0xE0, 0xFF, true, 0x00},                    // CRC-8/ROHC
+    {8, 0x8C, 0x00, true, 0x00},                    // CRC-8/MAXIM
+    {16, 0xA001, 0x0000, true, 0x0000},             // CRC-16/IBM
+    {16, 0xA001, 0x0000, true, 0xFFFF},             // CRC-16/MAXIM
+    {16, 0xA001, 0xFFFF, true, 0xFFFF},             // CRC-16/USB
+    {16, 0xA001, 0xFFFF, true, 0x0000},             // CRC-16/MODBUS
+    {16, 0x8408, 0x0000, true, 0x0000},             // CRC-16/CCITT
+    {16, 0x1021, 0xFFFF, false, 0x0000},            // CRC-16/CCITT-FALSE
+    {16, 0x8408, 0xFFFF, true, 0xFFFF},             // CRC-16/X25
+    {16, 0x1021, 0x0000, false, 0x0000},            // CRC-16/XMODEM
+    {16, 0xA6BC, 0x0000, true, 0xFFFF},             // CRC-16/DNP
+    {32, 0xEDB88320, 0xFFFFFFFF, true, 0xFFFFFFFF}, // CRC-32
+    {32, 0x04C11DB7, 0xFFFFFFFF, false, 0x00000000} // CRC-32/MPEG-2
+};
+
+/// Byte-wise lookup tables, built once for every variant.
+struct LuxCRCTables {
+    uint32_t table[LUX_CRC_COUNT][256];
+
+    LuxCRCTables() {
+        for (int t = 1; t < LUX_CRC_COUNT; ++t) {
+            const LuxCRCParam &p = kCRCParams[t];
+            int regBits = p.width < 8 ? 8 : p.width;
+            uint32_t mask = regBits == 32 ? 0xFFFFFFFFu : ((1u << regBits) - 1);
+            uint32_t poly = p.refin ? p.poly : p.poly << (regBits - p.width);
+            uint32_t top = 1u << (regBits - 1);
+
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc;
+                if (p.refin) {
+                    crc = i;
+                    for (int k = 0; k < 8; ++k)
+                        crc = (crc & 1) ? (crc >> 1) ^ poly : (crc >> 1);
+                } else {
+                    crc = i << (regBits - 8);
+                    for (int k = 0; k < 8; ++k)
+                        crc = (crc & top) ? (crc << 1) ^ poly : (crc << 1);
+                }
+                table[t][i] = crc & mask;
+            }
+        }
+    }
+};
+
+const LuxCRCTables &LuxGetCRCTables() {
+    static const LuxCRCTables tables;
+    return tables;
+}
+
+}  // namespace
+
+/// @brief Table driven CRC of @c length bytes with the parameters of @c crcType
+/// @return The CRC value, 0 if @c crcType is not supported
+uint32_t LuxCalcCRC(int crcType, uint8_t const *data, uint64_t length) {
+    if (crcType <= LUX_CRC_NONE || crcType >= LUX_CRC_COUNT) return 0;
+
+    const LuxCRCParam &p = kCRCParams[crcType];
+    const uint32_t *table = LuxGetCRCTables().table[crcType];
+    int regBits = p.width < 8 ? 8 : p.width;
+    uint32_t mask = regBits == 32 ? 0xFFFFFFFFu : ((1u << regBits) - 1);
+
+    uint32_t crc;
+    if (p.refin) {
+        crc = p.init;
+        while (length--)
+            crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    } else {
+        crc = p.init << (regBits - p.width);
+        while (length--)
+            crc = ((crc << 8) ^
+                   table[((crc >> (regBits - 8)) ^ *data++) & 0xFF]) & mask;
+        crc >>= regBits - p.width;
+    }
+    return crc ^ p.xorout;
+}
+
+/// @brief Bytes of the CRC field of @c crcType in a record
+int LuxCRCBytes(int crcType) {
+    if (crcType <= LUX_CRC_NONE || crcType >= LUX_CRC_COUNT) return 0;
+    return (kCRCParams[crcType].width + 7) / 8;
+}
+
+/// @brief Bytes of a CRC protected frame of @c lines lines with @c lineBytes
+/// payload bytes each
+/// @return The number of bytes, or the bare payload size if the stage is off
+uint64_t LuxCheckFrameBytes(const LuxCheckConf *conf, uint64_t lineBytes,
+                            int lines) {
+    uint64_t payload = lineBytes * static_cast<uint64_t>(lines);
+    if (conf == nullptr || LuxCRCBytes(conf->crcType) == 0) return payload;
+
+    uint64_t extra = static_cast<uint64_t>(LuxCRCBytes(conf->crcType)) +
+                     conf->headerBytes + conf->paddingBytes;
+    if (conf->scope == LUX_CHECK_FRAME) return payload + extra;
+    return payload + extra * static_cast<uint64_t>(lines);
+}
+
+/**
+ * @brief Verify the CRC of every record in @c input and copy the bare payload
+ * into @c payloadOut. Lines are checked in parallel.
+ *
+ * @param input The frame as received from the link
+ * @param inLength The bytes number of @c input
+ * @param lineBytes The payload bytes of one line
+ * @param lines The number of lines
+ * @param conf The layout of the records
+ * @param payloadOut lineBytes * lines bytes, may be nullptr to verify only
+ * @param badLines Receives the indices of the corrupted lines, may be nullptr
+ * @param badLinesCap The capacity of @c badLines
+ * @return long long
+ *  The number of corrupted lines (a bad frame CRC marks every line) if success.
+ *  -1 : The configuration is wrong.
+ *  -2 : The length of input don't match the configuration.
+ */
+long long LuxCheckVerify(uint8_t const *input, uint64_t inLength,
+                         uint64_t lineBytes, int lines,
+                         const LuxCheckConf *conf, uint8_t *payloadOut,
+                         int *badLines, int badLinesCap) {
+    int crcBytes = conf == nullptr ? 0 : LuxCRCBytes(conf->crcType);
+    if (crcBytes == 0 || lines <= 0 || conf->headerBytes < 0 ||
+        conf->paddingBytes < 0) {
+        std::cerr << "Check configuration is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+
+    if (inLength != LuxCheckFrameBytes(conf, lineBytes, lines)) {
+        std::cerr << "The length of input don't match the check configuration."
+                  << "\nTarget length: "
+                  << LuxCheckFrameBytes(conf, lineBytes, lines)
+                  << " Input length: " << inLength << std::endl;
+        ::fflush(stderr);
+        return -2;
+    }
+
+    bool frameScope = conf->scope == LUX_CHECK_FRAME;
+    uint64_t payloadBytes = frameScope ? lineBytes * lines : lineBytes;
+    uint64_t recordBytes =
+        crcBytes + conf->headerBytes + payloadBytes + conf->paddingBytes;
+    int64_t records = frameScope ? 1 : lines;
+
+    auto readCRC = [&](uint8_t const *p) {
+        uint32_t v = 0;
+        for (int i = 0; i < crcBytes; ++i) {
+            int shift = conf->crcBigEndian ? 8 * (crcBytes - 1 - i) : 8 * i;
+            v |= static_cast<uint32_t>(p[i]) << shift;
+        }
+        return v;
+    };
+
+    std::vector<uint8_t> bad(records, 0);
+    LuxParallelFor(0, records, 16, [&](int64_t lo, int64_t hi) {
+        for (int64_t r = lo; r < hi; ++r) {
+            uint8_t const *rec = input + r * recordBytes;
+            uint8_t const *crcField = rec;
+            uint8_t const *header = rec;
+            if (conf->position == LUX_CHECK_HEAD)
+                header += crcBytes;
+            else
+                crcField += conf->headerBytes + payloadBytes +
+                            conf->paddingBytes;
+            uint8_t const *payload = header + conf->headerBytes;
+
+            uint8_t const *covered = conf->coverHeader ? header : payload;
+            uint64_t coveredBytes =
+                payloadBytes + (conf->coverHeader ? conf->headerBytes : 0);
+            bad[r] = LuxCalcCRC(conf->crcType, covered, coveredBytes) !=
+                     readCRC(crcField);
+
+            if (payloadOut != nullptr)
+                ::memcpy(payloadOut + r * payloadBytes, payload, payloadBytes);
+        }
+    });
+
+    long long badCount = 0;
+    for (int line = 0; line < lines; ++line) {
+        if (!bad[frameScope ? 0 : line]) continue;
+        if (badLines != nullptr && badCount < badLinesCap)
+            badLines[badCount] = line;
+        ++badCount;
+    }
+    return badCount;
+}
@@ -0,0 +1,427 @@
+/**
+ * @file LuxCodec.cc
+ */
+
+#include <imgCore/LuxCodec.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTrace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+/// Residuals above this many quotient bits are stored verbatim
+constexpr int kEscapeBits = 24;
+
+inline int countLeadingZeros(uint64_t v) {
+    if (v == 0) return 64;
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(v);
+#endif
+}
+
+bool validGeometry(int width, int height, int bpp) {
+    if (width <= 0 || height <= 0) return false;
+    if (bpp != 8 && bpp != 12 && bpp != 16) return false;
+    return bpp != 12 || width % 2 == 0;
+}
+
+uint64_t rowBytes(int width, int bpp) {
+    return static_cast<uint64_t>(width) * bpp / 8;
+}
+
+void unpackRow(const uint8_t *src, uint16_t *dst, int width, int bpp,
+               bool bigEndian) {
+    if (bpp == 8) {
+        for (int x = 0; x < width; ++x) dst[x] = src[x];
+    } else if (bpp == 12) {
+        /// AAAAAAAA AAAABBBB BBBBBBBB
+        for (int x = 0; x < width; x += 2, src += 3) {
+            dst[x] = static_cast<uint16_t>((src[0] << 4) | (src[1] >> 4));
+            dst[x + 1] = static_cast<uint16_t>(((src[1] & 0x0F) << 8) | src[2]);
+        }
+    } else if (bigEndian) {
+        for (int x = 0; x < width; ++x)
+            dst[x] = static_cast<uint16_t>((src[2 * x] << 8) | src[2 * x + 1]);
+    } else {
+        for (int x = 0; x < width; ++x)
+            dst[x] = static_cast<uint16_t>(src[2 * x] | (src[2 * x + 1] << 8));
+    }
+}
+
+void packRow(const uint16_t *src, uint8_t *dst, int width, int bpp,
+             bool bigEndian) {
+    if (bpp == 8) {
+        for (int x = 0; x < width; ++x) dst[x] = static_cast<uint8_t>(src[x]);
+    } else if (bpp == 12) {
+        for (int x = 0; x < width; x += 2, dst += 3) {
+            dst[0] = static_cast<uint8_t>(src[x] >> 4);
+            dst[1] = static_cast<uint8_t>(((src[x] & 0x0F) << 4) |
+                                          (src[x + 1] >> 8));
+            dst[2] = static_cast<uint8_t>(src[x + 1]);
+        }
+    } else if (bigEndian) {
+        for (int x = 0; x < width; ++x) {
+            dst[2 * x] = static_cast<uint8_t>(src[x] >> 8);
+            dst[2 * x + 1] = static_cast<uint8_t>(src[x]);
+        }
+    } else {
+        for (int x = 0; x < width; ++x) {
+            dst[2 * x] = static_cast<uint8_t>(src[x]);
+            dst[2 * x + 1] = static_cast<uint8_t>(src[x] >> 8);
+        }
+    }
+}
+
+/// MED (LOCO-I) predictor, without branches
+inline int med(int a, int b, int c) {
+    int mx = std::max(a, b), mn = std::min(a, b);
+    int p = a + b - c;
+    p = c >= mx ? mn : p;
+    p = c <= mn ? mx : p;
+    return p;
+}
+
+/**
+ * @brief Call @c code(x, prediction) for every sample of a row, left to
+ * right. The prediction uses the same-colour neighbours of the Bayer lattice:
+ * a = (x - 2, y), b = (x, y - 2), c = (x - 2, y - 2). @c up2 is nullptr for
+ * the first two rows of a strip, strips never reference each other.
+ */
+template <typename Code>
+inline void forEachSample(const uint16_t *cur, const uint16_t *up2, int width,
+                          int mid, Code code) {
+    if (up2 == nullptr) {
+        for (int x = 0; x < std::min(2, width); ++x) code(x, mid);
+        for (int x = 2; x < width; ++x) code(x, cur[x - 2]);
+    } else {
+        for (int x = 0; x < std::min(2, width); ++x) code(x, up2[x]);
+        for (int x = 2; x < width; ++x)
+            code(x, med(cur[x - 2], up2[x], up2[x - 2]));
+    }
+}
+
+/// Adaptive Rice parameter, one per Bayer channel
+struct RiceContext {
+    uint32_t sum;
+    uint32_t count;
+
+    explicit RiceContext(int bpp)
+        : sum(std::max(2, (1 << bpp) / 64)), count(1) {}
+
+    /// Smallest k with count << k >= sum
+    int k() const {
+        int k = countLeadingZeros(count) - countLeadingZeros(sum);
+        if (k < 0) return 0;
+        if ((static_cast<uint64_t>(count) << k) < sum) ++k;
+        return std::min(k, 16);
+    }
+
+    void update(uint32_t u) {
+        sum += u;
+        if (++count == 64) {
+            sum >>= 1;
+            count >>= 1;
+        }
+    }
+};
+
+/// MSB first, the caller sizes the buffer for the worst case
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t *out) : begin_(out), p_(out) {}
+
+    /// @c bits <= 32
+    void put(uint32_t value, int bits) {
+        acc_ = (acc_ << bits) | value;
+        n_ += bits;
+        if (n_ >= 32) {
+            n_ -= 32;
+            uint32_t word = static_cast<uint32_t>(acc_ >> n_);
+            p_[0] = static_cast<uint8_t>(word >> 24);
+            p_[1] = static_cast<uint8_t>(word >> 16);
+            p_[2] = static_cast<uint8_t>(word >> 8);
+            p_[3] = static_cast<uint8_t>(word);
+            p_ += 4;
+        }
+    }
+
+    /// Pad to a byte, return the bytes written
+    size_t finish() {
+        if (n_ % 8) put(0, 8 - n_ % 8);
+        while (n_ > 0) {
+            n_ -= 8;
+            *p_++ = static_cast<uint8_t>(acc_ >> n_);
+        }
+        return p_ - begin_;
+    }
+
+private:
+    uint8_t *begin_;
+    uint8_t *p_;
+    uint64_t acc_ = 0;
+    int n_ = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t *begin, const uint8_t *end)
+        : p_(begin), end_(end) {}
+
+    /// At least 57 valid bits afterwards, zeros past the end
+    void refill() {
+        if (n_ <= 56 && p_ + 8 <= end_) {
+            uint64_t word = 0;
+            for (int i = 0; i < 8; ++i) word = (word << 8) | p_[i];
+            // Whole bytes that fit below the valid bits
+            int bytes = (64 - n_) >> 3;
+            bits_ |= (word >> (64 - bytes * 8)) << (64 - n_ - bytes * 8);
+            p_ += bytes;
+            n_ += bytes * 8;
+            return;
+        }
+        while (n_ <= 56) {
+            uint64_t byte = p_ < end_ ? *p_ : 0;
+            ++p_;
+            bits_ |= byte << (56 - n_);
+            n_ += 8;
+        }
+    }
+
+    uint64_t peek() const { return bits_; }
+
+    void skip(int bits) {
+        bits_ <<= bits;
+        n_ -= bits;
+    }
+
+    uint32_t take(int bits) {
+        if (bits == 0) return 0;
+        uint32_t v = static_cast<uint32_t>(bits_ >> (64 - bits));
+        skip(bits);
+        return v;
+    }
+
+    bool overrun() const { return p_ > end_ + 8; }
+
+private:
+    const uint8_t *p_;
+    const uint8_t *end_;
+    uint64_t bits_ = 0;
+    int n_ = 0;
+};
+
+/// Worst case of a strip: every sample escaped
+size_t stripMaxBytes(int width, int rows, int bpp) {
+    return static_cast<size_t>(width) * rows * (kEscapeBits + bpp) / 8 + 8;
+}
+
+void encodeStrip(const uint8_t *input, int width, int rows, int bpp,
+                 bool bigEndian, std::vector<uint8_t> &out) {
+    const int mid = 1 << (bpp - 1);
+    const int signShift = 32 - bpp;
+    const uint64_t inRow = rowBytes(width, bpp);
+
+    std::vector<uint16_t> samples(static_cast<size_t>(width) * rows);
+    RiceContext ctx[4] = {RiceContext(bpp), RiceContext(bpp), RiceContext(bpp),
+                          RiceContext(bpp)};
+    out.resize(stripMaxBytes(width, rows, bpp));
+    BitWriter writer(out.data());
+
+    for (int r = 0; r < rows; ++r) {
+        uint16_t *cur = samples.data() + static_cast<size_t>(r) * width;
+        const uint16_t *up2 = r >= 2 ? cur - 2 * width : nullptr;
+        RiceContext *rowCtx = ctx + ((r & 1) << 1);
+        unpackRow(input + r * inRow, cur, width, bpp, bigEndian);
+
+        forEachSample(cur, up2, width, mid, [&](int x, int pred) {
+            RiceContext &c = rowCtx[x & 1];
+            // Residual modulo 2^bpp, sign extended and zigzag mapped
+            int e = static_cast<int>(static_cast<uint32_t>(cur[x] - pred)
+                                     << signShift) >>
+                    signShift;
+            uint32_t u = (static_cast<uint32_t>(e) << 1) ^
+                         static_cast<uint32_t>(e >> 31);
+
+            int k = c.k();
+            uint32_t q = u >> k;
+            if (q < kEscapeBits) {
+                writer.put(1, q + 1);
+                writer.put(u & ((1u << k) - 1), k);
+            } else {
+                writer.put(0, kEscapeBits);
+                writer.put(u, bpp);
+            }
+            c.update(u);
+        });
+    }
+    out.resize(writer.finish());
+}
+
+bool decodeStrip(const uint8_t *begin, const uint8_t *end, int width,
+                 int rows, int bpp, bool bigEndian, uint8_t *output) {
+    const uint32_t mask = (1u << bpp) - 1;
+    const int mid = 1 << (bpp - 1);
+    const uint64_t outRow = rowBytes(width, bpp);
+
+    std::vector<uint16_t> samples(static_cast<size_t>(width) * rows);
+    RiceContext ctx[4] = {RiceContext(bpp), RiceContext(bpp), RiceContext(bpp),
+                          RiceContext(bpp)};
+    BitReader reader(begin, end);
+
+    for (int r = 0; r < rows; ++r) {
+        uint16_t *cur = samples.data() + static_cast<size_t>(r) * width;
+        const uint16_t *up2 = r >= 2 ? cur - 2 * width : nullptr;
+        RiceContext *rowCtx = ctx + ((r & 1) << 1);
+
+        forEachSample(cur, up2, width, mid, [&](int x, int pred) {
+            RiceContext &c = rowCtx[x & 1];
+            reader.refill();
+            int q = countLeadingZeros(reader.peek());
+            uint32_t u;
+            if (q >= kEscapeBits) {
+                reader.skip(kEscapeBits);
+                u = reader.take(bpp);
+            } else {
+                reader.skip(q + 1);
+                int k = c.k();
+                u = (static_cast<uint32_t>(q) << k) | reader.take(k);
+            }
+            c.update(u);
+
+            int e = static_cast<int>((u >> 1) ^ (0u - (u & 1)));
+            cur[x] = static_cast<uint16_t>((pred + e) & mask);
+        });
+        if (reader.overrun()) return false;
+        packRow(cur, output + r * outRow, width, bpp, bigEndian);
+    }
+    return true;
+}
+
+}  // namespace
+
+long long LuxCodecMaxBytes(int width, int height, int bpp) {
+    if (!validGeometry(width, height, bpp)) return -1;
+    int strips = (height + LUX_CODEC_STRIP_ROWS - 1) / LUX_CODEC_STRIP_ROWS;
+    // Worst case: every sample escaped, plus padding of every strip
+    uint64_t bits = static_cast<uint64_t>(width) * height * (kEscapeBits + bpp);
+    return static_cast<long long>(sizeof(LuxCodecHeader) +
+                                  (strips + 1) * sizeof(uint64_t) + bits / 8 +
+                                  strips);
+}
+
+long long LuxCodecEncode(const unsigned char *input, unsigned long long length,
+                         int width, int height, int bpp, bool isBigEndian,
+                         unsigned char *output, unsigned long long outCap) {
+    LUX_TRACE_SCOPE("codec_encode");
+    if (input == nullptr || output == nullptr ||
+        !validGeometry(width, height, bpp) ||
+        length != rowBytes(width, bpp) * height)
+        return -1;
+
+    const int stripRows = LUX_CODEC_STRIP_ROWS;
+    const int strips = (height + stripRows - 1) / stripRows;
+    std::vector<std::vector<uint8_t>> encoded(strips);
+
+    LuxParallelFor(0, strips, 1, [&](int64_t lo, int64_t hi) {
+        for (int64_t s = lo; s < hi; ++s) {
+            int y = static_cast<int>(s) * stripRows;
+            int rows = std::min(stripRows, height - y);
+            encodeStrip(input + y * rowBytes(width, bpp), width, rows, bpp,
+                        isBigEndian, encoded[s]);
+        }
+    });
+
+    uint64_t tableBytes = (strips + 1) * sizeof(uint64_t);
+    uint64_t total = sizeof(LuxCodecHeader) + tableBytes;
+    for (auto &e : encoded) total += e.size();
+    if (total > outCap) return -2;
+
+    LuxCodecHeader header;
+    ::memset(&header, 0, sizeof(header));
+    ::memcpy(header.magic, LUX_CODEC_MAGIC, sizeof(header.magic));
+    header.bpp = static_cast<uint16_t>(bpp);
+    header.bigEndian = isBigEndian ? 1 : 0;
+    header.width = width;
+    header.height = height;
+    header.stripRows = stripRows;
+    header.strips = strips;
+    header.rawBytes = length;
+    ::memcpy(output, &header, sizeof(header));
+
+    auto *offsets = output + sizeof(header);
+    auto *data = offsets + tableBytes;
+    uint64_t offset = 0;
+    for (int s = 0; s <= strips; ++s) {
+        ::memcpy(offsets + s * sizeof(uint64_t), &offset, sizeof(offset));
+        if (s == strips) break;
+        ::memcpy(data + offset, encoded[s].data(), encoded[s].size());
+        offset += encoded[s].size();
+    }
+    return static_cast<long long>(total);
+}
+
+int LuxCodecInfo(const unsigned char *input, unsigned long long length,
+                 LuxCodecHeader *header) {
+    if (input == nullptr || header == nullptr ||
+        length < sizeof(LuxCodecHeader))
+        return -1;
+    ::memcpy(header, input, sizeof(LuxCodecHeader));
+    if (::memcmp(header->magic, LUX_CODEC_MAGIC, sizeof(header->magic)) != 0 ||
+        header->width > INT32_MAX || header->height > INT32_MAX ||
+        !validGeometry(header->width, header->height, header->bpp) ||
+        header->stripRows == 0 || header->stripRows % 2 != 0 ||
+        header->strips != (header->height + header->stripRows - 1) /
+                              header->stripRows ||
+        header->rawBytes != rowBytes(header->width, header->bpp) *
+                                header->height ||
+        length < sizeof(LuxCodecHeader) +
+                     (header->strips + 1ull) * sizeof(uint64_t))
+        return -1;
+    return 0;
+}
+
+long long LuxCodecDecode(const unsigned char *input, unsigned long long length,
+                         unsigned char *output, unsigned long long outCap) {
+    LUX_TRACE_SCOPE("codec_decode");
+    LuxCodecHeader h;
+    if (LuxCodecInfo(input, length, &h) != 0 || output == nullptr) return -1;
+    if (h.rawBytes > outCap) return -2;
+
+    const auto *table = input + sizeof(h);
+    const uint64_t tableBytes = (h.strips + 1ull) * sizeof(uint64_t);
+    const auto *data = table + tableBytes;
+    const uint64_t dataBytes = length - sizeof(h) - tableBytes;
+
+    std::vector<uint64_t> offsets(h.strips + 1);
+    ::memcpy(offsets.data(), table, tableBytes);
+    for (uint32_t s = 0; s < h.strips; ++s)
+        if (offsets[s] > offsets[s + 1] || offsets[s + 1] > dataBytes)
+            return -1;
+
+    const int width = h.width, height = h.height, bpp = h.bpp;
+    const int stripRows = h.stripRows;
+    std::atomic<bool> corrupt{false};
+    LuxParallelFor(0, h.strips, 1, [&](int64_t lo, int64_t hi) {
+        for (int64_t s = lo; s < hi; ++s) {
+            int y = static_cast<int>(s) * stripRows;
+            int rows = std::min(stripRows, height - y);
+            if (!decodeStrip(data + offsets[s], data + offsets[s + 1], width,
+                             rows, bpp, h.bigEndian != 0,
+                             output + y * rowBytes(width, bpp)))
+                corrupt = true;
+        }
+    });
+    return corrupt ? -1 : static_cast<long long>(h.rawBytes);
+}
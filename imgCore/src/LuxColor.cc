@@ -0,0 +1,276 @@
+/**
+ * @file LuxColor.cc
+ */
+
+#include <imgCore/LuxColor.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTrace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LUX_HAVE_SSE2 1
+#endif
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 32;
+/// Rows demosaiced above and below a band: the neighbourhood of the
+/// bilinear, VNG and edge-aware Bayer filters, even to keep the pattern
+constexpr int kMarginRows = 4;
+/// Fixed point of the 8-bit matrix, 4.12
+constexpr int kCoefBits = 12;
+
+/// The stage of one conf
+struct ColorTables {
+    LuxColorConf conf;
+    bool identity;         ///< The matrix does nothing: the curve only
+    int16_t coef[9];       ///< ccm in 4.12
+    uint8_t lut8[256];     ///< The curve of the 8-bit values
+    std::vector<uint16_t> lut16;
+};
+
+/// nullptr: the stage is off
+std::shared_ptr<const ColorTables> gTables;
+LuxColorConf gConf{{1, 0, 0, 0, 1, 0, 0, 0, 1}, LUX_GAMMA_NONE, 2.2};
+std::mutex gMutex;
+
+bool isValid(const LuxColorConf *conf) {
+    if (conf == nullptr) return false;
+    for (float c : conf->ccm)
+        if (!(c > -8 && c < 8)) return false;
+    if (conf->gamma == LUX_GAMMA_POWER) return conf->power > 0;
+    return conf->gamma == LUX_GAMMA_NONE || conf->gamma == LUX_GAMMA_SRGB;
+}
+
+/// The curve of x in [0, 1]
+double curve(const LuxColorConf &conf, double x) {
+    switch (conf.gamma) {
+        case LUX_GAMMA_SRGB:
+            return x <= 0.0031308 ? 12.92 * x
+                                  : 1.055 * std::pow(x, 1 / 2.4) - 0.055;
+        case LUX_GAMMA_POWER:
+            return std::pow(x, 1 / conf.power);
+        default:
+            return x;
+    }
+}
+
+/// The tables of a valid @c conf, nullptr if it does nothing
+std::shared_ptr<const ColorTables> makeTables(const LuxColorConf &conf) {
+    bool identity = true;
+    for (int i = 0; i < 9; ++i)
+        identity = identity && conf.ccm[i] == (i % 4 == 0 ? 1.0f : 0.0f);
+    if (identity && conf.gamma == LUX_GAMMA_NONE) return nullptr;
+
+    auto t = std::make_shared<ColorTables>();
+    t->conf = conf;
+    t->identity = identity;
+    for (int i = 0; i < 9; ++i)
+        t->coef[i] = static_cast<int16_t>(std::max<long>(
+            -INT16_MAX,
+            std::min<long>(std::lround(conf.ccm[i] * (1 << kCoefBits)),
+                           INT16_MAX)));
+    for (int v = 0; v < 256; ++v)
+        t->lut8[v] =
+            static_cast<uint8_t>(std::lround(curve(conf, v / 255.0) * 255));
+    t->lut16.resize(UINT16_MAX + 1);
+    for (int v = 0; v <= UINT16_MAX; ++v)
+        t->lut16[v] = static_cast<uint16_t>(
+            std::lround(curve(conf, v / 65535.0) * 65535));
+    return t;
+}
+
+std::shared_ptr<const ColorTables> current() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gTables;
+}
+
+/// The 8-bit planes of one row
+struct Scratch8 {
+    std::vector<int16_t> in;
+    std::vector<uint8_t> out;
+};
+
+/// @c width RGB pixels of @c src through the stage into @c dst, which may
+/// be @c src
+void colorRow8(const uint8_t *src, uint8_t *dst, int width,
+               const ColorTables &t, Scratch8 *scratch) {
+    const uint8_t *lut = t.lut8;
+    if (t.identity) {
+        for (int i = 0; i < 3 * width; ++i) dst[i] = lut[src[i]];
+        return;
+    }
+
+    /// Planar R, G, B in, then planar R', G', B' out
+    scratch->in.resize(3 * static_cast<size_t>(width));
+    scratch->out.resize(3 * static_cast<size_t>(width));
+    int16_t *in[3] = {scratch->in.data(), scratch->in.data() + width,
+                      scratch->in.data() + 2 * width};
+    uint8_t *out[3] = {scratch->out.data(), scratch->out.data() + width,
+                       scratch->out.data() + 2 * width};
+    for (int x = 0; x < width; ++x)
+        for (int c = 0; c < 3; ++c) in[c][x] = src[3 * x + c];
+
+    const int16_t *m = t.coef;
+    constexpr int kRound = 1 << (kCoefBits - 1);
+    int x = 0;
+#ifdef LUX_HAVE_SSE2
+    /// (r, g) . (m0, m1) + (b, 1) . (m2, round): two madds per 4 pixels
+    __m128i rg[3], b1[3];
+    for (int c = 0; c < 3; ++c) {
+        rg[c] = _mm_setr_epi16(m[3 * c], m[3 * c + 1], m[3 * c], m[3 * c + 1],
+                               m[3 * c], m[3 * c + 1], m[3 * c], m[3 * c + 1]);
+        b1[c] = _mm_setr_epi16(m[3 * c + 2], kRound, m[3 * c + 2], kRound,
+                               m[3 * c + 2], kRound, m[3 * c + 2], kRound);
+    }
+    const __m128i one = _mm_set1_epi16(1);
+    auto load = [](const int16_t *p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    };
+    for (; x + 8 <= width; x += 8) {
+        __m128i r = load(in[0] + x), g = load(in[1] + x), b = load(in[2] + x);
+        __m128i rgLo = _mm_unpacklo_epi16(r, g);
+        __m128i rgHi = _mm_unpackhi_epi16(r, g);
+        __m128i bLo = _mm_unpacklo_epi16(b, one);
+        __m128i bHi = _mm_unpackhi_epi16(b, one);
+        for (int c = 0; c < 3; ++c) {
+            __m128i lo = _mm_add_epi32(_mm_madd_epi16(rgLo, rg[c]),
+                                       _mm_madd_epi16(bLo, b1[c]));
+            __m128i hi = _mm_add_epi32(_mm_madd_epi16(rgHi, rg[c]),
+                                       _mm_madd_epi16(bHi, b1[c]));
+            __m128i v = _mm_packs_epi32(_mm_srai_epi32(lo, kCoefBits),
+                                        _mm_srai_epi32(hi, kCoefBits));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out[c] + x),
+                             _mm_packus_epi16(v, v));
+        }
+    }
+#endif
+    for (; x < width; ++x)
+        for (int c = 0; c < 3; ++c) {
+            const int v = (m[3 * c] * in[0][x] + m[3 * c + 1] * in[1][x] +
+                           m[3 * c + 2] * in[2][x] + kRound) >>
+                          kCoefBits;
+            out[c][x] = static_cast<uint8_t>(std::min(std::max(v, 0), 255));
+        }
+
+    for (x = 0; x < width; ++x)
+        for (int c = 0; c < 3; ++c) dst[3 * x + c] = lut[out[c][x]];
+}
+
+/// colorRow8() of 16-bit pixels, in float
+void colorRow16(const uint16_t *src, uint16_t *dst, int width,
+                const ColorTables &t) {
+    const uint16_t *lut = t.lut16.data();
+    if (t.identity) {
+        for (int i = 0; i < 3 * width; ++i) dst[i] = lut[src[i]];
+        return;
+    }
+    const float *m = t.conf.ccm;
+    for (int x = 0; x < width; ++x) {
+        const float r = src[3 * x], g = src[3 * x + 1], b = src[3 * x + 2];
+        for (int c = 0; c < 3; ++c) {
+            const float v = m[3 * c] * r + m[3 * c + 1] * g + m[3 * c + 2] * b;
+            dst[3 * x + c] =
+                lut[static_cast<int>(std::min(std::max(v, 0.0f), 65535.0f) +
+                                     0.5f)];
+        }
+    }
+}
+
+}  // namespace
+
+int LuxSetColorConf(const LuxColorConf *conf) {
+    if (!isValid(conf)) return -1;
+    auto tables = makeTables(*conf);
+    std::lock_guard<std::mutex> lock(gMutex);
+    gConf = *conf;
+    gTables = std::move(tables);
+    return 0;
+}
+
+void LuxGetColorConf(LuxColorConf *conf) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (conf != nullptr) *conf = gConf;
+}
+
+int LuxColorActive() { return current() != nullptr ? 1 : 0; }
+
+long long LuxApplyColor(unsigned char *rgb, int width, int height,
+                        unsigned long long stride, const LuxColorConf *conf) {
+    if (conf != nullptr && !isValid(conf)) return -1;
+    if (rgb == nullptr || width <= 0 || height <= 0 ||
+        (stride != 0 && stride < 3ull * width))
+        return -4;
+    auto tables = conf != nullptr ? makeTables(*conf) : current();
+    const long long pixels = static_cast<long long>(width) * height;
+    if (tables == nullptr) return pixels;
+    if (stride == 0) stride = 3ull * width;
+
+    LUX_TRACE_SCOPE("color");
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        Scratch8 scratch;
+        for (int64_t y = lo; y < hi; ++y)
+            colorRow8(rgb + y * stride, rgb + y * stride, width, *tables,
+                      &scratch);
+    });
+    return pixels;
+}
+
+long long LuxApplyColor16(uint16_t *rgb, int width, int height,
+                          unsigned long long stride,
+                          const LuxColorConf *conf) {
+    if (conf != nullptr && !isValid(conf)) return -1;
+    if (rgb == nullptr || width <= 0 || height <= 0 ||
+        (stride != 0 && stride < 3ull * width))
+        return -4;
+    auto tables = conf != nullptr ? makeTables(*conf) : current();
+    const long long pixels = static_cast<long long>(width) * height;
+    if (tables == nullptr) return pixels;
+    if (stride == 0) stride = 3ull * width;
+
+    LUX_TRACE_SCOPE("color");
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        for (int64_t y = lo; y < hi; ++y)
+            colorRow16(rgb + y * stride, rgb + y * stride, width, *tables);
+    });
+    return pixels;
+}
+
+void LuxDemosaic(const cv::Mat &bayer, cv::Mat &rgb, int code) {
+    auto tables = current();
+    const bool is8 = rgb.type() == CV_8UC3, is16 = rgb.type() == CV_16UC3;
+    if (tables == nullptr || !(is8 || is16) || rgb.rows != bayer.rows) {
+        cv::cvtColor(bayer, rgb, code);
+        return;
+    }
+
+    /// Bands of whole Bayer row pairs, each demosaiced with its margin:
+    /// the rows of the band come out as from the whole frame
+    LUX_TRACE_SCOPE("demosaic_color");
+    const int height = bayer.rows, width = bayer.cols;
+    const int64_t pairs = (height + 1) / 2;
+    LuxParallelFor(0, pairs, kGrainRows / 2, [&](int64_t lo, int64_t hi) {
+        const int y0 = static_cast<int>(2 * lo);
+        const int y1 = static_cast<int>(std::min<int64_t>(2 * hi, height));
+        const int r0 = std::max(0, y0 - kMarginRows);
+        const int r1 = std::min(height, y1 + kMarginRows);
+        cv::Mat band;
+        cv::cvtColor(bayer.rowRange(r0, r1), band, code);
+        Scratch8 scratch;
+        for (int y = y0; y < y1; ++y) {
+            if (is8)
+                colorRow8(band.ptr<uint8_t>(y - r0), rgb.ptr<uint8_t>(y),
+                          width, *tables, &scratch);
+            else
+                colorRow16(band.ptr<uint16_t>(y - r0), rgb.ptr<uint16_t>(y),
+                           width, *tables);
+        }
+    });
+}
@@ -0,0 +1,486 @@
+/**
+ * @file LuxContainer.cc
+ */
+
+#include <imgCore/LuxCheck.h>
+#include <imgCore/LuxCodec.h>
+#include <imgCore/LuxContainer.h>
+#include <imgCore/LuxDLL.h>
+#include <imgCore/LuxTrace.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+uint64_t alignUp(uint64_t v) {
+    return (v + LUX_ZRAW_ALIGN - 1) / LUX_ZRAW_ALIGN * LUX_ZRAW_ALIGN;
+}
+
+/// [offset, offset + bytes) lies in a file of @c size bytes; the fields come
+/// from the header, their sum may wrap
+bool inFile(uint64_t offset, uint64_t bytes, uint64_t size) {
+    return offset <= size && bytes <= size - offset;
+}
+
+/// a * b into @c product, false if it wraps
+bool multiply(uint64_t a, uint64_t b, uint64_t *product) {
+    if (b != 0 && a > UINT64_MAX / b) return false;
+    *product = a * b;
+    return true;
+}
+
+/// Bytes of one row of @c pixels, -1 if it is not a whole number of bytes
+long long rowBytes(const LuxZrawHeader *h, uint64_t pixels) {
+    uint64_t bits = pixels * h->bpp * h->channels;
+    if (bits % 8 != 0) return -1;
+    return static_cast<long long>(bits / 8);
+}
+
+bool tiled(const LuxZrawHeader *h) {
+    return (h->flags & LUX_ZRAW_TILED) != 0;
+}
+
+bool compressed(const LuxZrawHeader *h) {
+    return (h->flags & LUX_ZRAW_COMPRESSED) != 0;
+}
+
+/// The codec works on samples: a row holds width * channels of them
+bool codecMatches(const LuxZrawHeader *h, const LuxCodecHeader &c) {
+    return c.width == static_cast<uint64_t>(h->width) * h->channels &&
+           c.height == h->height && c.bpp == h->bpp &&
+           c.bigEndian == (h->bigEndian != 0);
+}
+
+/// Geometry of the tiles, false if they do not divide the frame
+bool tileGeometry(const LuxZrawHeader *h, long long *tileRowBytes) {
+    if (h->tileWidth == 0 || h->tileHeight == 0 ||
+        h->width % h->tileWidth != 0 || h->height % h->tileHeight != 0)
+        return false;
+    *tileRowBytes = rowBytes(h, h->tileWidth);
+    return *tileRowBytes > 0;
+}
+
+/**
+ * @brief Copy between the row-major frame and the tiled layout: tiles are
+ * stored row-major, each tile row-major.
+ */
+void copyTiles(const LuxZrawHeader *h, long long tileRowBytes,
+               const unsigned char *src, unsigned char *dst, bool toTiles) {
+    uint64_t frameRowBytes = rowBytes(h, h->width);
+    uint64_t tilesX = h->width / h->tileWidth;
+    uint64_t tileBytes = tileRowBytes * h->tileHeight;
+
+    uint64_t tile = 0;
+    for (uint64_t ty = 0; ty < h->height / h->tileHeight; ++ty) {
+        for (uint64_t tx = 0; tx < tilesX; ++tx, ++tile) {
+            for (uint64_t r = 0; r < h->tileHeight; ++r) {
+                uint64_t linear = (ty * h->tileHeight + r) * frameRowBytes +
+                                  tx * tileRowBytes;
+                uint64_t packed = tile * tileBytes + r * tileRowBytes;
+                if (toTiles)
+                    ::memcpy(dst + packed, src + linear, tileRowBytes);
+                else
+                    ::memcpy(dst + linear, src + packed, tileRowBytes);
+            }
+        }
+    }
+}
+
+/// 0 if the preview geometry is wrong or its size wraps
+uint64_t previewBytes(const LuxZrawHeader *h) {
+    int channels = h->previewType == CV_8UC3 ? 3 : 1;
+    uint64_t bytes;
+    if (h->previewWidth > INT_MAX || h->previewHeight > INT_MAX ||
+        !multiply(static_cast<uint64_t>(h->previewWidth) * channels,
+                  h->previewHeight, &bytes))
+        return 0;
+    return bytes;
+}
+
+}  // namespace
+
+long long LuxZrawFrameBytes(const LuxZrawHeader *header) {
+    if (header == nullptr || header->width == 0 || header->height == 0 ||
+        header->channels == 0 ||
+        (header->bpp != 8 && header->bpp != 12 && header->bpp != 16))
+        return -1;
+    /// The fields may come from an untrusted file: the loaders take the
+    /// geometry as int, and no product may wrap
+    const uint64_t samples =
+        static_cast<uint64_t>(header->width) * header->channels;
+    uint64_t bits;
+    if (header->height > INT_MAX || samples > INT_MAX ||
+        !multiply(samples * header->bpp, header->height, &bits) ||
+        bits / 8 > static_cast<uint64_t>(LLONG_MAX))
+        return -1;
+    return bits % 8 ? -1 : static_cast<long long>(bits / 8);
+}
+
+int LuxZrawIsContainer(const char *fileName) {
+    std::ifstream fin(fileName, std::ios_base::binary);
+    if (!fin.is_open()) return -3;
+    char magic[8] = {0};
+    fin.read(magic, sizeof(magic));
+    return fin.gcount() == sizeof(magic) &&
+           ::memcmp(magic, LUX_ZRAW_MAGIC, sizeof(magic)) == 0;
+}
+
+long long LuxZrawWrite(const char *fileName, const LuxZrawHeader *info,
+                       const unsigned char *payload,
+                       const unsigned char *preview) {
+    LUX_TRACE_SCOPE("zraw_write");
+    long long frameBytes = LuxZrawFrameBytes(info);
+    if (frameBytes < 0 || payload == nullptr) {
+        std::cerr << "Container header is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+
+    LuxZrawHeader header = *info;
+    ::memset(header.magic, 0, sizeof(header.magic));
+    ::memcpy(header.magic, LUX_ZRAW_MAGIC, sizeof(LUX_ZRAW_MAGIC));
+    header.version = LUX_ZRAW_VERSION;
+    header.headerBytes = LUX_ZRAW_HEADER_BYTES;
+    header.payloadOffset = alignUp(LUX_ZRAW_HEADER_BYTES);
+    header.payloadBytes = frameBytes;
+
+    /// Tiles, row-major -> tiled; or row-major -> LuxCodec stream
+    std::vector<unsigned char> tiles;
+    const unsigned char *stored = payload;
+    if (compressed(&header)) {
+        int samples = header.width * header.channels;
+        long long maxBytes = LuxCodecMaxBytes(samples, header.height,
+                                              header.bpp);
+        if (tiled(&header) || maxBytes < 0) {
+            std::cerr << "The frame can not be compressed!!!" << std::endl;
+            ::fflush(stderr);
+            return -1;
+        }
+        tiles.resize(maxBytes);
+        long long n = LuxCodecEncode(payload, frameBytes, samples,
+                                     header.height, header.bpp,
+                                     header.bigEndian != 0, tiles.data(),
+                                     tiles.size());
+        if (n < 0) return -1;
+        header.tileWidth = header.tileHeight = 0;
+        header.payloadBytes = n;
+        stored = tiles.data();
+    } else if (tiled(&header)) {
+        long long tileRowBytes = 0;
+        if (!tileGeometry(&header, &tileRowBytes)) {
+            std::cerr << "Tiles must divide the frame!!!" << std::endl;
+            ::fflush(stderr);
+            return -1;
+        }
+        tiles.resize(frameBytes);
+        copyTiles(&header, tileRowBytes, payload, tiles.data(), true);
+        stored = tiles.data();
+    } else {
+        header.tileWidth = header.tileHeight = 0;
+    }
+
+    header.flags |= LUX_ZRAW_CRC;
+    header.payloadCRC32 =
+        LuxCalcCRC(LUX_CRC32, stored, header.payloadBytes);
+
+    if ((header.flags & LUX_ZRAW_PREVIEW) && preview != nullptr &&
+        previewBytes(&header) > 0) {
+        header.previewOffset =
+            alignUp(header.payloadOffset + header.payloadBytes);
+        header.previewBytes = previewBytes(&header);
+    } else {
+        header.flags &= ~LUX_ZRAW_PREVIEW;
+        header.previewOffset = header.previewBytes = 0;
+        header.previewWidth = header.previewHeight = header.previewType = 0;
+    }
+
+    std::ofstream fout(fileName, std::ios_base::binary);
+    if (!fout.is_open()) {
+        std::cerr << "Fail to open file: " << fileName << std::endl;
+        ::fflush(stderr);
+        return -3;
+    }
+
+    const char zeros[LUX_ZRAW_ALIGN] = {0};
+    fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    fout.write(zeros, header.payloadOffset - sizeof(header));
+    fout.write(reinterpret_cast<const char *>(stored), header.payloadBytes);
+    uint64_t end = header.payloadOffset + header.payloadBytes;
+    if (header.previewBytes) {
+        fout.write(zeros, header.previewOffset - end);
+        fout.write(reinterpret_cast<const char *>(preview),
+                   header.previewBytes);
+        end = header.previewOffset + header.previewBytes;
+    }
+    if (fout.fail()) {
+        std::cerr << "Fail to write file: " << fileName << std::endl;
+        ::fflush(stderr);
+        return -3;
+    }
+    return static_cast<long long>(end);
+}
+
+int LuxZrawOpen(const char *fileName, LuxZrawFile *file) {
+    LUX_TRACE_SCOPE("zraw_open");
+    if (file == nullptr) return -3;
+    ::memset(file, 0, sizeof(*file));
+
+#ifdef _WIN32
+    HANDLE fh = ::CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) return -3;
+    LARGE_INTEGER size;
+    ::GetFileSizeEx(fh, &size);
+    HANDLE mapping =
+        ::CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    ::CloseHandle(fh);
+    if (mapping == nullptr) return -3;
+    void *base = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (base == nullptr) {
+        ::CloseHandle(mapping);
+        return -3;
+    }
+    file->handle = mapping;
+    file->size = static_cast<uint64_t>(size.QuadPart);
+#else
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0) return -3;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return -3;
+    }
+    void *base = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return -3;
+    file->size = static_cast<uint64_t>(st.st_size);
+#endif
+    file->base = static_cast<const unsigned char *>(base);
+
+    if (file->size < sizeof(LuxZrawHeader) ||
+        ::memcmp(file->base, LUX_ZRAW_MAGIC, sizeof(LUX_ZRAW_MAGIC)) != 0) {
+        LuxZrawClose(file);
+        return -4;
+    }
+    ::memcpy(&file->header, file->base, sizeof(LuxZrawHeader));
+    auto &h = file->header;
+    if (h.version != LUX_ZRAW_VERSION || h.headerBytes != sizeof(h)) {
+        LuxZrawClose(file);
+        return -4;
+    }
+
+    /// A compressed payload must describe the same frame as the header. The
+    /// payload is read through 16-bit views, its offset kept aligned.
+    long long tileRowBytes = 0;
+    bool payloadOk = false;
+    if (h.payloadOffset >= sizeof(h) &&
+        h.payloadOffset % sizeof(uint16_t) == 0 &&
+        inFile(h.payloadOffset, h.payloadBytes, file->size)) {
+        const long long frameBytes = LuxZrawFrameBytes(&h);
+        if (compressed(&h)) {
+            /// The codec spends one bit per sample at least: the frame is
+            /// bounded by the file, not by the header alone
+            LuxCodecHeader c;
+            const uint64_t samples =
+                static_cast<uint64_t>(h.width) * h.channels * h.height;
+            payloadOk = !tiled(&h) && frameBytes > 0 &&
+                        samples / 8 <= h.payloadBytes &&
+                        LuxCodecInfo(file->base + h.payloadOffset,
+                                     h.payloadBytes, &c) == 0 &&
+                        codecMatches(&h, c);
+        } else {
+            payloadOk = frameBytes > 0 &&
+                        static_cast<uint64_t>(frameBytes) == h.payloadBytes;
+        }
+    }
+    if (!payloadOk ||
+        (tiled(&h) && !tileGeometry(&h, &tileRowBytes)) ||
+        ((h.flags & LUX_ZRAW_PREVIEW) &&
+         (h.previewBytes == 0 || h.previewBytes != previewBytes(&h) ||
+          !inFile(h.previewOffset, h.previewBytes, file->size)))) {
+        std::cerr << "Container " << fileName << " is truncated or corrupt"
+                  << std::endl;
+        ::fflush(stderr);
+        LuxZrawClose(file);
+        return -5;
+    }
+    return 0;
+}
+
+void LuxZrawClose(LuxZrawFile *file) {
+    if (file == nullptr || file->base == nullptr) return;
+#ifdef _WIN32
+    ::UnmapViewOfFile(file->base);
+    ::CloseHandle(static_cast<HANDLE>(file->handle));
+#else
+    ::munmap(const_cast<unsigned char *>(file->base), file->size);
+#endif
+    file->base = nullptr;
+    file->handle = nullptr;
+    file->size = 0;
+}
+
+const unsigned char *LuxZrawPayload(const LuxZrawFile *file) {
+    if (file == nullptr || file->base == nullptr || tiled(&file->header) ||
+        compressed(&file->header))
+        return nullptr;
+    return file->base + file->header.payloadOffset;
+}
+
+const unsigned char *LuxZrawPreview(const LuxZrawFile *file) {
+    if (file == nullptr || file->base == nullptr ||
+        !(file->header.flags & LUX_ZRAW_PREVIEW))
+        return nullptr;
+    return file->base + file->header.previewOffset;
+}
+
+long long LuxZrawReadFrame(const LuxZrawFile *file, unsigned char *output) {
+    if (file == nullptr || file->base == nullptr || output == nullptr)
+        return -1;
+    const auto &h = file->header;
+    const unsigned char *stored = file->base + h.payloadOffset;
+    long long frameBytes = LuxZrawFrameBytes(&h);
+    if (frameBytes < 0) return -1;
+    if (compressed(&h)) {
+        if (LuxCodecDecode(stored, h.payloadBytes, output, frameBytes) < 0)
+            return -1;
+    } else if (!tiled(&h)) {
+        ::memcpy(output, stored, frameBytes);
+    } else {
+        long long tileRowBytes = 0;
+        if (!tileGeometry(&h, &tileRowBytes)) return -1;
+        copyTiles(&h, tileRowBytes, stored, output, false);
+    }
+    return frameBytes;
+}
+
+int LuxZrawVerify(const LuxZrawFile *file) {
+    if (file == nullptr || file->base == nullptr ||
+        !(file->header.flags & LUX_ZRAW_CRC))
+        return -1;
+    return LuxCalcCRC(LUX_CRC32, file->base + file->header.payloadOffset,
+                      file->header.payloadBytes) ==
+           file->header.payloadCRC32;
+}
+
+long long LuxLoadImageDataFromZraw(const char *inputFileName,
+                                   const char *outputRawFileName,
+                                   const char *outputTiffFileName,
+                                   bool saveTiff, int mode, int code) {
+    LuxZrawFile file;
+    int ret = LuxZrawOpen(inputFileName, &file);
+    if (ret < 0) return ret == -3 ? -3 : -4;
+    const auto &h = file.header;
+
+    /// LuxLoadImageDataEnhanced() parses in place, work on a private copy
+    /// The sizes are bounded by LuxZrawOpen(), the memory may still lack:
+    /// no exception leaves the C interface
+    long long frameBytes = LuxZrawFrameBytes(&h);
+    auto *imgData = new (std::nothrow) unsigned char[frameBytes];
+    frameBytes = imgData != nullptr ? LuxZrawReadFrame(&file, imgData) : -1;
+    LuxZrawClose(&file);
+    if (frameBytes < 0) {
+        delete[] imgData;
+        return -4;
+    }
+
+    int dataFormat = h.dataFormat == 0 ? 1 : h.dataFormat;
+    int outChannels = dataFormat == 1 ? 1 : 3;
+    int cvType = outChannels == 1 ? CV_8UC1 : CV_8UC3;
+    auto *outData = new (std::nothrow) unsigned char[
+        static_cast<uint64_t>(h.width) * h.height * outChannels];
+    if (outData == nullptr) {
+        std::cerr << "No memory for " << inputFileName << std::endl;
+        ::fflush(stderr);
+        delete[] imgData;
+        return -4;
+    }
+
+    long long k = LuxLoadImageDataEnhanced(
+        imgData, frameBytes, dataFormat, h.width, h.height, h.bpp,
+        h.channels, outData, h.bigEndian != 0, h.highZero != 0, mode, code);
+
+    if (k > 0) {
+        unsigned long long _ret =
+            LuxWriteImageIntoFile(outData, outputRawFileName,
+                                  ImageFileType::raw, k, h.width, h.height,
+                                  cvType);
+        if (saveTiff)
+            LuxWriterSubmit(outData, h.width, h.height, cvType,
+                            outputTiffFileName, true);
+        k = _ret;
+    }
+
+    delete[] imgData;
+    delete[] outData;
+    return k;
+}
+
+long long LuxReadFrameFromFile(const char *fileName, unsigned char *output,
+                               unsigned long long length) {
+    LUX_TRACE_SCOPE("read_file");
+    std::ifstream fin(fileName, std::ios_base::binary);
+    if (!fin.is_open()) {
+        std::cerr << "Fail to read " << fileName << std::endl;
+        ::fflush(stderr);
+        return -3;
+    }
+    fin.seekg(0, fin.end);
+    unsigned long long size = fin.tellg();
+    fin.seekg(0, fin.beg);
+
+    char magic[8] = {0};
+    fin.read(magic, std::min<unsigned long long>(size, sizeof(magic)));
+    fin.seekg(0, fin.beg);
+
+    long long ret = -4;
+    if (::memcmp(magic, LUX_ZRAW_MAGIC, sizeof(LUX_ZRAW_MAGIC)) == 0) {
+        LuxZrawFile file;
+        if (LuxZrawOpen(fileName, &file) == 0) {
+            if (LuxZrawFrameBytes(&file.header) ==
+                static_cast<long long>(length))
+                ret = LuxZrawReadFrame(&file, output);
+            LuxZrawClose(&file);
+        }
+    } else if (::memcmp(magic, LUX_CODEC_MAGIC, 4) == 0) {
+        LUX_TRACE_SCOPE("decompress");
+        std::vector<unsigned char> stream(size);
+        fin.read(reinterpret_cast<char *>(stream.data()), size);
+        fin.seekg(0, fin.beg);
+        LuxCodecHeader c;
+        if (LuxCodecInfo(stream.data(), size, &c) == 0 &&
+            c.rawBytes == length)
+            ret = LuxCodecDecode(stream.data(), size, output, length);
+    }
+    /// Headerless raw, also when its first bytes happen to look like a magic
+    if (ret < 0 && size == length) {
+        fin.clear();
+        fin.read(reinterpret_cast<char *>(output), length);
+        ret = fin.fail() ? -3 : static_cast<long long>(length);
+    }
+
+    if (ret != static_cast<long long>(length)) {
+        std::cerr << "The length of file is NOT right." << std::endl
+                  << "Target length: " << length << " File length: " << size
+                  << std::endl;
+        ::fflush(stderr);
+        return ret == -3 ? -3 : -4;
+    }
+    return ret;
+}
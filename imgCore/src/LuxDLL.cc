@@ -3,8 +3,13 @@
  */
 
 #include <imgCore/LuxDLL.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxWriter.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>  /// memcpy
 #include <fstream>
@@ -12,6 +17,44 @@
 #include <iostream>  /// fflush stdout
 #include <ostream>
 #include <tuple>
+#include <vector>
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+/// Input bytes of a block of the parsers, every step of their loops (2, 3,
+/// 4, 6, 8 bytes) divides it
+constexpr uint64_t kParseBlock = 24;
+/// Blocks of one parallel band, at least
+constexpr int64_t kGrainBlocks = 4096;
+
+/// @brief Run the serial parser @c kernel(in, length, out) on bands of whole
+/// blocks in the pool. A band writes where the serial scan would have: at
+/// the output count of one block times the blocks before it. Kernels that
+/// count nothing for a block (memcpy, wrong parameters) run as is.
+/// @return The sum of the counts of the bands.
+template <typename TOut, typename Kernel>
+long long LuxParseInBands(unsigned char *in, uint64_t length, TOut *out,
+                          Kernel kernel) {
+    unsigned char probeIn[kParseBlock] = {0};
+    TOut probeOut[kParseBlock] = {};
+    const long long perBlock = kernel(probeIn, kParseBlock, probeOut);
+    const int64_t blocks = static_cast<int64_t>(length / kParseBlock);
+    if (perBlock <= 0 || blocks < 2 * kGrainBlocks)
+        return kernel(in, length, out);
+
+    std::atomic<long long> count{0};
+    LuxParallelFor(0, blocks, kGrainBlocks, [&](int64_t lo, int64_t hi) {
+        /// The last band takes the tail of a partial block
+        const uint64_t first = lo * kParseBlock;
+        const uint64_t last = hi == blocks ? length : hi * kParseBlock;
+        count += kernel(in + first, last - first, out + lo * perBlock);
+    });
+    return count;
+}
+
+}  // namespace
 
 template <typename T>
 inline unsigned char LuxBound255(T src) {
@@ -37,18 +80,77 @@ void LuxEndianSwap(unsigned char *pData, uint64_t startIndex, uint64_t length) {
 
 /// @brief EndianRevert from @c input to @c output
 /// @return The length of reverting bytes
-int LuxEndianRevert(unsigned char *input, int length, int bpp,
-                    unsigned char *output, bool isBig2Little) {
-    int bytes = bpp / 8;
-    if (input != output) {
-        ::memcpy(output, input, length);
-    }
-    for (int kI = 0; kI < length; kI += bytes) {
-        LuxEndianSwap(output, kI, bytes);
+unsigned long long LuxEndianRevert64(unsigned char *input, uint64_t length,
+                                     int bpp, unsigned char *output,
+                                     bool isBig2Little) {
+    const int bytes = bpp / 8;
+    if (bytes < 2) {
+        if (input != output) ::memcpy(output, input, length);
+        return length;
     }
+
+    const int64_t samples = static_cast<int64_t>((length + bytes - 1) / bytes);
+    LuxParallelFor(0, samples, kGrainBlocks * kParseBlock,
+                   [&](int64_t lo, int64_t hi) {
+                       const uint64_t first = lo * bytes;
+                       const uint64_t last =
+                           std::min<uint64_t>(hi * bytes, length);
+                       if (input != output)
+                           ::memcpy(output + first, input + first,
+                                    last - first);
+                       for (uint64_t kI = first; kI < last; kI += bytes)
+                           LuxEndianSwap(output, kI, bytes);
+                   });
     return length;
 }
 
+/// @brief LuxEndianRevert64() of an int length, kept for the existing callers
+int LuxEndianRevert(unsigned char *input, int length, int bpp,
+                    unsigned char *output, bool isBig2Little) {
+    return static_cast<int>(LuxEndianRevert64(
+        input, length < 0 ? 0 : length, bpp, output, isBig2Little));
+}
+
+/// @brief Bytes of a frame, with integer math. 0 if the samples do not fill
+/// whole groups of the packing, or a MIPI frame has several channels.
+inline uint64_t LuxFrameBytes(int width, int height, int channels, int bpp) {
+    if (width <= 0 || height <= 0 || channels <= 0 ||
+        ((bpp & LUX_BPP_MIPI) && channels != 1))
+        return 0;
+    return LuxPackedBytes(static_cast<uint64_t>(width) * height * channels,
+                          bpp);
+}
+
+/// @brief Whether the loaders parse a frame of @c width samples per row by
+/// rows, through LuxParseRows(): the MIPI packings, and every packing while
+/// a calibration (LuxCalib.h) or a defect correction (LuxDefect.h) applies
+/// to the frame.
+inline bool LuxParseByRows(int width, int height, int bpp, bool highZero) {
+    const int bits = LuxSignificantBits(bpp, highZero);
+    return (bpp & LUX_BPP_MIPI) ||
+           LuxCalibPass(width, height, bits).active() ||
+           LuxDefectPass(width, height, bits).active();
+}
+
+/// @brief The parse step of the loaders unpacking the rows in
+/// LuxDecodeMulti(), big endian samples: the 8-bit window of @c mode
+/// (LUX_DECODE_DISPLAY8), the sample values (LUX_DECODE_EXTEND16) or the
+/// stretched samples (LUX_DECODE_STRETCH16) into @c outputImg.
+/// @return The number of samples, 0 if the frame is wrong.
+uint64_t LuxParseRows(const unsigned char *imgData, unsigned long long length,
+                      int width, int height, int bpp, bool highZero,
+                      unsigned int output, int mode, void *outputImg) {
+    LuxDecodeRequest request = {};
+    request.outputs = output;
+    request.mode = mode;
+    request.display8 = static_cast<unsigned char *>(outputImg);
+    request.extend16 = static_cast<uint16_t *>(outputImg);
+    request.stretch16 = static_cast<uint16_t *>(outputImg);
+    long long ret = LuxDecodeMulti(imgData, length, width, height, bpp, true,
+                                   highZero, &request);
+    return ret < 0 ? 0 : static_cast<uint64_t>(ret);
+}
+
 /// @brief clear (or flush) the output buffer and move the buffered data
 ///     to console (in case of stdout) or disk (in case of file output stream)
 void LuxFlushStdOut() { ::fflush(stdout); }
@@ -61,9 +163,10 @@ void LuxFlushStdOut() { ::fflush(stdout); }
 /// @param highZero 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB ?
 /// @param outputImg The pointor of image data in memory after parsing.
 /// @return unsigned long long. The number of image bytes
-inline unsigned long long LuxParseImage(unsigned char *orgiImg, int length,
-                                        int bpp, bool highZero,
-                                        unsigned char *outputImg) {
+static unsigned long long LuxParseImage64Serial(unsigned char *orgiImg,
+                                                uint64_t length, int bpp,
+                                                bool highZero,
+                                                unsigned char *outputImg) {
     uint64_t k = 0;
     switch (bpp) {
         case 8:
@@ -79,7 +182,7 @@ inline unsigned long long LuxParseImage(unsigned char *orgiImg, int length,
             try {
                 /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                 if (highZero) {
-                    for (int i = 0; i < length; i += 8) {
+                    for (uint64_t i = 0; i < length; i += 8) {
                         outputImg[k] =
                             (orgiImg[i] << 4u) + (orgiImg[i + 1] >> 4u);
                         outputImg[k + 1] =
@@ -93,7 +196,7 @@ inline unsigned long long LuxParseImage(unsigned char *orgiImg, int length,
                 }
                 /// AAAAAAAA AAAABBBB BBBBBBBB
                 else {
-                    for (int i = 0; i < length; i += 3) {
+                    for (uint64_t i = 0; i < length; i += 3) {
                         outputImg[k++] = orgiImg[i];
                         outputImg[k++] = ((orgiImg[i + 1] << 4u) & 0xFF) +
                                          (orgiImg[i + 2] >> 4u);
@@ -128,7 +231,7 @@ inline unsigned long long LuxParseImage(unsigned char *orgiImg, int length,
                 }
 
                 /// Set the higt 8 bit into outptImg
-                for (int i = 0; i < length; i += 8) {
+                for (uint64_t i = 0; i < length; i += 8) {
                     outputImg[k++] = orgiImg[i + 0];
                     outputImg[k++] = orgiImg[i + 2];
                     outputImg[k++] = orgiImg[i + 4];
@@ -150,6 +253,28 @@ inline unsigned long long LuxParseImage(unsigned char *orgiImg, int length,
     return k;
 }
 
+/// @brief LuxParseImage64Serial() on bands of the frame in the pool
+unsigned long long LuxParseImage64(unsigned char *orgiImg, uint64_t length,
+                                   int bpp, bool highZero,
+                                   unsigned char *outputImg) {
+    if (bpp == 16 && highZero)
+        return LuxParseImage64Serial(orgiImg, length, bpp, highZero,
+                                     outputImg);
+    return LuxParseInBands(
+        orgiImg, length, outputImg,
+        [bpp, highZero](unsigned char *in, uint64_t n, unsigned char *out) {
+            return static_cast<long long>(
+                LuxParseImage64Serial(in, n, bpp, highZero, out));
+        });
+}
+
+/// @brief LuxParseImage64() of an int length, kept for the existing callers
+unsigned long long LuxParseImage(unsigned char *orgiImg, int length, int bpp,
+                                 bool highZero, unsigned char *outputImg) {
+    return LuxParseImage64(orgiImg, length < 0 ? 0 : length, bpp, highZero,
+                           outputImg);
+}
+
 /**
  * @brief Get type of image: CV_8UC1, CV_8UC3, ...
  *
@@ -235,12 +360,15 @@ long long LuxWriteImageIntoFile(unsigned char *imgData, const char *outFileName,
         // else {
         // }
 
-        /// XXX Ensure .raw and .tiff are same
-        if (CV_8UC3 == type)
-            cv::cvtColor(cv::Mat(height, width, type, imgData),
-                         cv::Mat(height, width, type, imgData),
+        /// Convert into a copy, imgData stays RGB for the caller
+        if (CV_8UC3 == type) {
+            cv::Mat ret(height, width, type);
+            cv::cvtColor(cv::Mat(height, width, type, imgData), ret,
                          cv::COLOR_RGB2BGR);
-        cv::imwrite(outFileStr, cv::Mat(height, width, type, imgData));
+            cv::imwrite(outFileStr, ret);
+        } else {
+            cv::imwrite(outFileStr, cv::Mat(height, width, type, imgData));
+        }
         return length;
     } else {
         std::cout << "Don't support file type!" << std::endl;
@@ -375,7 +503,7 @@ inline long long LuxWriteImageIntoFileExternTo16(
  * @param dataFormat 1: raw, 2: bayer, 3: others
  * @param width Width
  * @param height Height
- * @param bpp (Bits Per Pixel)  8, 12, 16
+ * @param bpp (Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
  * @param inChannels inChannels
  * @param outData The poniter of image data in memory after parsing.
  * @param isBigEndian Big Endian(be) ?
@@ -412,27 +540,17 @@ long long LuxLoadImageData(unsigned char *imgData, unsigned long long length,
         return -1;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
     }
 
-    if (length !=
-        static_cast<unsigned long long>(
-            static_cast<float>(width * height * inChannels) * bytes)) {
+    if (length == 0 ||
+        length != LuxFrameBytes(width, height, inChannels, bpp)) {
         std::cerr << "width or height or bpp or channel are wrong!!!"
                   << "\nwidth: " << width << "\nheigth: " << height
                   << "\nbits per pixel: " << bpp
@@ -442,16 +560,21 @@ long long LuxLoadImageData(unsigned char *imgData, unsigned long long length,
     }
 
     // Only support big endian
-    if (!isBigEndian) {
-        LuxEndianRevert(imgData, length, bpp, imgData, true);
+    if (!isBigEndian && !(bpp & LUX_BPP_MIPI)) {
+        LuxEndianRevert64(imgData, length, bpp, imgData, true);
     }
 
     // TODO 代码优化： 加入 outChannels/types
     /* raw */
     if (dataFormat == 1) {
-        long long validLength = width * height;
+        uint64_t validLength = static_cast<uint64_t>(width) * height;
         auto *temp = new unsigned char[validLength];
-        uint64_t k = LuxParseImage(imgData, length, bpp, highZero, temp);
+        uint64_t k =
+            LuxParseByRows(width * inChannels, height, bpp, highZero)
+                ? LuxParseRows(imgData, length, width * inChannels, height,
+                               bpp, highZero, LUX_DECODE_DISPLAY8, 0,
+                               temp)
+                : LuxParseImage64(imgData, length, bpp, highZero, temp);
         (void)k;
 
         cv::Mat bayer8BitMat(height, width, CV_8UC1, temp);
@@ -460,26 +583,32 @@ long long LuxLoadImageData(unsigned char *imgData, unsigned long long length,
 
         delete[] temp;
         /* 图片大小 （字节数） */
-        return outputImg.size().width * outputImg.size().height *
-               outputImg.channels();
+        return static_cast<long long>(outputImg.size().width) *
+               outputImg.size().height * outputImg.channels();
     }
 
     /* Bayer */
     else if (dataFormat == 2) {
         int outChannels = 3;
-        long long validLength = width * height * outChannels;
+        uint64_t validLength =
+            static_cast<uint64_t>(width) * height * outChannels;
         auto *temp = new unsigned char[validLength];
-        uint64_t k = LuxParseImage(imgData, length, bpp, highZero, temp);
+        uint64_t k =
+            LuxParseByRows(width * inChannels, height, bpp, highZero)
+                ? LuxParseRows(imgData, length, width * inChannels, height,
+                               bpp, highZero, LUX_DECODE_DISPLAY8, 0,
+                               temp)
+                : LuxParseImage64(imgData, length, bpp, highZero, temp);
         (void)k;
 
         /// 16UC1 Bayer
         cv::Mat bayer8BitMat(height, width, CV_8UC1, temp);
         cv::Mat rgb8BitMat(height, width, CV_8UC3, outData);
-        cv::cvtColor(bayer8BitMat, rgb8BitMat, code);
+        LuxDemosaic(bayer8BitMat, rgb8BitMat, code);
 
         delete[] temp;
-        return rgb8BitMat.size().height * rgb8BitMat.size().width *
-               rgb8BitMat.channels();
+        return static_cast<long long>(rgb8BitMat.size().height) *
+               rgb8BitMat.size().width * rgb8BitMat.channels();
     }
 
     return -4;
@@ -488,17 +617,18 @@ long long LuxLoadImageData(unsigned char *imgData, unsigned long long length,
 /**
  * @brief Load image data from file.
  * @note When Python Call the Function, the ALL parameters must be SET.
- * @param inputFileName The file before parsing.
+ * @param inputFileName The file before parsing: a headerless raw, a LuxCodec
+ * stream or a container.
  * @param dataFormat 1: raw, 2: bayer, 3: others
  * @param width Width
  * @param height Height
- * @param bpp bpp(Bits Per Pixel)  8, 12, 16
+ * @param bpp bpp(Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
  * @param channels Channels
  * @param outputRawFileName The .raw file after parsing.
  * @param outputTiffFileName The .tiff file after parsing.
  * @param isBigEndian Big Endian(be) ?
  * @param highZero 0000AAAA AAAAAAAA ?
- * @param saveTiff Save tiff ?
+ * @param saveTiff Save tiff ? Encoded on the writer queue, see LuxWriterFlush()
  * @param code
  *  - CV_BayerBG2BGR =46,
  *  - CV_BayerGB2BGR =47,
@@ -535,59 +665,36 @@ long long LuxLoadImageDataFromFile(const char *inputFileName, int dataFormat,
         return 0;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return 0;
-    }
-
-    std::ifstream ifstrm(reinterpret_cast<const char *>(inputFileName),
-                         std::ios_base::binary);
-    if (ifstrm.is_open() == false) {
-        std::cerr << "Fail to read " << inputFileName << std::endl;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
         ::fflush(stderr);
-        return -1;
+        return 0;
     }
 
-    /// Check the length of file
-    unsigned long long length = static_cast<unsigned long long int>(
-        static_cast<float>(width * height * channels) * bytes);
-    ifstrm.seekg(0, ifstrm.end);
-    unsigned long long ret = ifstrm.tellg();
-    ifstrm.seekg(0, ifstrm.beg);
-    if (ret != length) {
-        std::cerr << "The length of file is NOT right." << std::endl;
-        ::fflush(stderr);
+    /// Read the frame into imgData: a headerless raw, a LuxCodec stream or
+    /// a container, checked by the length of the frame
+    unsigned long long length = LuxFrameBytes(width, height, channels, bpp);
+    auto *imgData = new unsigned char[length];
+    long long ret = LuxReadFrameFromFile(inputFileName, imgData, length);
+    if (ret < 0) {
+        delete[] imgData;
         return -1;
     }
 
-    /// Read bytes into imgData
-    auto *imgData = new unsigned char[length];
-    ifstrm.read((char *)imgData, length);
-
     /// According to the target, Set channels, Type of outputFile
     unsigned char *outData = nullptr;
     int cvType = CV_8UC1;
     /// raw
     if (dataFormat == 1) {
-        outData = new unsigned char[width * height * 1];
+        outData = new unsigned char[static_cast<uint64_t>(width) * height];
         cvType = CV_8UC1;
     }
     /// Bayer / others
     else {
-        outData = new unsigned char[width * height * 3];
+        outData = new unsigned char[static_cast<uint64_t>(width) * height * 3];
         cvType = CV_8UC3;
     }
 
@@ -604,9 +711,8 @@ long long LuxLoadImageDataFromFile(const char *inputFileName, int dataFormat,
 
         // TIFF
         if (saveTiff)
-            LuxWriteImageIntoFile(outData, outputTiffFileName,
-                                  ImageFileType::tiff, k, width, height,
-                                  cvType);
+            LuxWriterSubmit(outData, width, height, cvType, outputTiffFileName,
+                            true);
 
         delete[] imgData;
         delete[] outData;
@@ -637,7 +743,7 @@ int LuxAdjustBrightness(unsigned char *src, long long length, int width,
         return -1;
     }
 
-    if (length != static_cast<long long int>(width * height * channel)) {
+    if (length != static_cast<long long int>(width) * height * channel) {
         perror("width or height or channel are wrong!!!");
         return -1;
     }
@@ -650,12 +756,14 @@ int LuxAdjustBrightness(unsigned char *src, long long length, int width,
         int rowNum = img_src.rows;
         int colNum = img_src.cols * img_src.channels();
 
-        for (int i = 0; i < rowNum; ++i) {
-            auto *data = img_dst.ptr<uint8_t>(i);
-            for (int j = 0; j < colNum; ++j) {
-                data[j] = cv::saturate_cast<uint8_t>(data[j] + beta);
+        LuxParallelFor(0, rowNum, kGrainRows, [&](int64_t lo, int64_t hi) {
+            for (int64_t i = lo; i < hi; ++i) {
+                auto *data = img_dst.ptr<uint8_t>(i);
+                for (int j = 0; j < colNum; ++j) {
+                    data[j] = cv::saturate_cast<uint8_t>(data[j] + beta);
+                }
             }
-        }
+        });
         dst = reinterpret_cast<unsigned char *>(img_dst.data);
         return length;
     } else if (channel == 3) {
@@ -666,12 +774,14 @@ int LuxAdjustBrightness(unsigned char *src, long long length, int width,
         int rowNum = img_src.rows;
         int colNum = img_src.cols * img_src.channels();
 
-        for (int i = 0; i < rowNum; ++i) {
-            auto *data = img_dst.ptr<uint8_t>(i);
-            for (int j = 0; j < colNum; ++j) {
-                data[j] = cv::saturate_cast<uint8_t>(data[j] + beta);
+        LuxParallelFor(0, rowNum, kGrainRows, [&](int64_t lo, int64_t hi) {
+            for (int64_t i = lo; i < hi; ++i) {
+                auto *data = img_dst.ptr<uint8_t>(i);
+                for (int j = 0; j < colNum; ++j) {
+                    data[j] = cv::saturate_cast<uint8_t>(data[j] + beta);
+                }
             }
-        }
+        });
         dst = reinterpret_cast<unsigned char *>(img_dst.data);
         return length;
     } else {
@@ -699,7 +809,7 @@ int LuxAdjustContrast(unsigned char *src, long long length, int width,
         return -1;
     }
 
-    if (length != static_cast<long long int>(width * height * channel)) {
+    if (length != static_cast<long long int>(width) * height * channel) {
         std::cout << "width or height or bpp or channel are wrong!!!"
                   << std::endl;
         return -1;
@@ -719,12 +829,15 @@ int LuxAdjustContrast(unsigned char *src, long long length, int width,
         int rowNum = img_src.rows;
         int colNum = img_src.cols * img_src.channels();
 
-        for (int i = 0; i < rowNum; ++i) {
-            auto *data = img_dst.ptr<uint8_t>(i);
-            for (int j = 0; j < colNum; ++j) {
-                data[j] = cv::saturate_cast<uint8_t>(data[j] * 0.01 * alpha);
+        LuxParallelFor(0, rowNum, kGrainRows, [&](int64_t lo, int64_t hi) {
+            for (int64_t i = lo; i < hi; ++i) {
+                auto *data = img_dst.ptr<uint8_t>(i);
+                for (int j = 0; j < colNum; ++j) {
+                    data[j] =
+                        cv::saturate_cast<uint8_t>(data[j] * 0.01 * alpha);
+                }
             }
-        }
+        });
         dst = reinterpret_cast<unsigned char *>(img_dst.data);
         return length;
     } else if (channel == 3) {
@@ -735,12 +848,14 @@ int LuxAdjustContrast(unsigned char *src, long long length, int width,
         int rowNum = img_src.rows;
         int colNum = img_src.cols * img_src.channels();
 
-        for (int i = 0; i < rowNum; ++i) {
-            auto *data = img_dst.ptr<uint8_t>(i);
-            for (int j = 0; j < colNum; ++j) {
-                data[j] = cv::saturate_cast<uint8_t>(data[j] * alpha);
+        LuxParallelFor(0, rowNum, kGrainRows, [&](int64_t lo, int64_t hi) {
+            for (int64_t i = lo; i < hi; ++i) {
+                auto *data = img_dst.ptr<uint8_t>(i);
+                for (int j = 0; j < colNum; ++j) {
+                    data[j] = cv::saturate_cast<uint8_t>(data[j] * alpha);
+                }
             }
-        }
+        });
         dst = reinterpret_cast<unsigned char *>(img_dst.data);
         return length;
     } else {
@@ -785,10 +900,10 @@ long long int LuxDrawHist(const char *inputFileName_, int width, int height,
         }
 
         fin.seekg(0, fin.end);
-        int length = fin.tellg();
+        long long length = fin.tellg();
 
         if (imReadType == 0) {
-            if (width * height != length) {
+            if (static_cast<long long>(width) * height != length) {
                 std::cerr << "width or height are wrong."
                           << "\r\n"
                           << " width: " << width << ", height: " << height
@@ -810,7 +925,7 @@ long long int LuxDrawHist(const char *inputFileName_, int width, int height,
         }
 
         else {
-            if (width * height * 3 != length) {
+            if (static_cast<long long>(width) * height * 3 != length) {
                 std::cerr << "width or height are wrong."
                           << "\r\n"
                           << " width: " << width << ", height: " << height
@@ -994,16 +1109,15 @@ long long int LuxDrawHist(const char *inputFileName_, int width, int height,
  * @param outputImg The pointor of image data in memory after parsing.
  * @return unsigned long long. The number of image bytes.
  */
-inline unsigned long long LuxParseImageExtendTo16(unsigned char *orgiImg,
-                                                  int length, int bpp,
-                                                  bool highZero,
-                                                  uint16_t *outputImg) {
+static unsigned long long LuxParseImage64ExtendTo16Serial(
+    unsigned char *orgiImg, uint64_t length, int bpp, bool highZero,
+    uint16_t *outputImg) {
     uint64_t k = 0;
     switch (bpp) {
         case 8:
             try {
                 /// AAAAAAAA
-                for (int i = 0; i < length; i += 4) {
+                for (uint64_t i = 0; i < length; i += 4) {
                     outputImg[k++] = orgiImg[i] & 0x00FF;
                     outputImg[k++] = orgiImg[i + 1] & 0x00FF;
 
@@ -1019,7 +1133,7 @@ inline unsigned long long LuxParseImageExtendTo16(unsigned char *orgiImg,
             try {
                 /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                 if (highZero) {
-                    for (int i = 0; i < length; i += 8) {
+                    for (uint64_t i = 0; i < length; i += 8) {
                         outputImg[k++] = ((orgiImg[i] << 8) & 0xFF00) +
                                          (orgiImg[i + 1] & 0x00FF);
                         outputImg[k++] = ((orgiImg[i + 2] << 8) & 0xFF00) +
@@ -1033,7 +1147,7 @@ inline unsigned long long LuxParseImageExtendTo16(unsigned char *orgiImg,
                 }
                 /// AAAAAAAA AAAABBBB BBBBBBBB
                 else {
-                    for (int i = 0; i < length; i += 6) {
+                    for (uint64_t i = 0; i < length; i += 6) {
                         outputImg[k++] =
                             (((orgiImg[i] >> 4) << 8) & 0xFF00) +
                             (((orgiImg[i] << 4) + (orgiImg[i + 1] >> 4)) &
@@ -1075,6 +1189,29 @@ inline unsigned long long LuxParseImageExtendTo16(unsigned char *orgiImg,
     return k;
 }
 
+/// @brief LuxParseImage64ExtendTo16Serial() on bands of the frame in the
+/// pool
+unsigned long long LuxParseImage64ExtendTo16(unsigned char *orgiImg,
+                                             uint64_t length, int bpp,
+                                             bool highZero,
+                                             uint16_t *outputImg) {
+    return LuxParseInBands(
+        orgiImg, length, outputImg,
+        [bpp, highZero](unsigned char *in, uint64_t n, uint16_t *out) {
+            return static_cast<long long>(
+                LuxParseImage64ExtendTo16Serial(in, n, bpp, highZero, out));
+        });
+}
+
+/// @brief LuxParseImage64ExtendTo16() of an int length, kept for the
+/// existing callers
+unsigned long long LuxParseImageExtendTo16(unsigned char *orgiImg, int length,
+                                           int bpp, bool highZero,
+                                           uint16_t *outputImg) {
+    return LuxParseImage64ExtendTo16(orgiImg, length < 0 ? 0 : length, bpp,
+                                     highZero, outputImg);
+}
+
 /**
  * @brief Save image data with extern 16-bit to @c outRawFileName.
  *
@@ -1098,27 +1235,17 @@ long long LuxSaveImgDatExtTo16(unsigned char *imgData,
                                int bpp, int inChannels,
                                const char *outRawFileName, bool isBigEndian,
                                bool highZero) {
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
     }
 
-    if (length !=
-        static_cast<unsigned long long>(
-            static_cast<float>(width * height * inChannels) * bytes)) {
+    if (length == 0 ||
+        length != LuxFrameBytes(width, height, inChannels, bpp)) {
         std::cerr << "width or height or bpp or channel are wrong!!!"
                   << "\nwidth: " << width << "\nheigth: " << height
                   << "\nbits per pixel: " << bpp
@@ -1129,15 +1256,20 @@ long long LuxSaveImgDatExtTo16(unsigned char *imgData,
 
     // std::cout << imgData[0] << " , " << imgData[1] << std::endl;
     // Only support big endian
-    if (!isBigEndian) {
-        LuxEndianRevert(imgData, length, bpp, imgData, true);
+    if (!isBigEndian && !(bpp & LUX_BPP_MIPI)) {
+        LuxEndianRevert64(imgData, length, bpp, imgData, true);
     }
 
-    if (bpp == 8 || bpp == 12 || bpp == 16) {
-        long long validLength = width * height;
+    if (bpp == 8 || bpp == 12 || bpp == 16 || (bpp & LUX_BPP_MIPI)) {
+        uint64_t validLength = static_cast<uint64_t>(width) * height;
         auto *temp = new uint16_t[validLength];
         uint64_t k =
-            LuxParseImageExtendTo16(imgData, length, bpp, highZero, temp);
+            LuxParseByRows(width * inChannels, height, bpp, highZero)
+                ? LuxParseRows(imgData, length, width * inChannels, height,
+                               bpp, highZero, LUX_DECODE_EXTEND16, 0,
+                               temp)
+                : LuxParseImage64ExtendTo16(imgData, length, bpp, highZero,
+                                          temp);
 
         k = k > 0 ? LuxWriteImageIntoFileExternTo16(temp, outRawFileName,
                                                     ImageFileType::raw, k,
@@ -1164,16 +1296,15 @@ long long LuxSaveImgDatExtTo16(unsigned char *imgData,
  * @param outputImg
  * @return unsigned long long
  */
-inline unsigned long long LuxParseImageStretchTo16(unsigned char *orgiImg,
-                                                   int length, int bpp,
-                                                   bool highZero,
-                                                   uint16_t *outputImg) {
+static unsigned long long LuxParseImage64StretchTo16Serial(
+    unsigned char *orgiImg, uint64_t length, int bpp, bool highZero,
+    uint16_t *outputImg) {
     uint64_t k = 0;
     switch (bpp) {
         case 8:
             try {
                 /// AAAAAAAA
-                for (int i = 0; i < length; i += 3) {
+                for (uint64_t i = 0; i < length; i += 3) {
                     // orgiImg[i][j] / 2^8 * 2^16
                     outputImg[k] = orgiImg[i] * 256;
                     outputImg[k + 1] = orgiImg[i + 1] * 256;
@@ -1189,7 +1320,7 @@ inline unsigned long long LuxParseImageStretchTo16(unsigned char *orgiImg,
             try {
                 /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                 if (highZero) {
-                    for (int i = 0; i < length; i += 4) {
+                    for (uint64_t i = 0; i < length; i += 4) {
                         // orgiImg[i][j] / 2^12 * 2^16
                         outputImg[k] =
                             ((orgiImg[i] << 8) + orgiImg[i + 1]) * 16;
@@ -1200,7 +1331,7 @@ inline unsigned long long LuxParseImageStretchTo16(unsigned char *orgiImg,
                 }
                 /// AAAAAAAA AAAABBBB BBBBBBBB
                 else {
-                    for (int i = 0; i < length; i += 3) {
+                    for (uint64_t i = 0; i < length; i += 3) {
                         // orgiImg[i][j] / 2^12 * 2^16
                         outputImg[k] =
                             (((orgiImg[i] >> 4) << 8) +
@@ -1239,6 +1370,29 @@ inline unsigned long long LuxParseImageStretchTo16(unsigned char *orgiImg,
     return k;
 }
 
+/// @brief LuxParseImage64StretchTo16Serial() on bands of the frame in the
+/// pool
+unsigned long long LuxParseImage64StretchTo16(unsigned char *orgiImg,
+                                              uint64_t length, int bpp,
+                                              bool highZero,
+                                              uint16_t *outputImg) {
+    return LuxParseInBands(
+        orgiImg, length, outputImg,
+        [bpp, highZero](unsigned char *in, uint64_t n, uint16_t *out) {
+            return static_cast<long long>(
+                LuxParseImage64StretchTo16Serial(in, n, bpp, highZero, out));
+        });
+}
+
+/// @brief LuxParseImage64StretchTo16() of an int length, kept for the
+/// existing callers
+unsigned long long LuxParseImageStretchTo16(unsigned char *orgiImg, int length,
+                                            int bpp, bool highZero,
+                                            uint16_t *outputImg) {
+    return LuxParseImage64StretchTo16(orgiImg, length < 0 ? 0 : length, bpp,
+                                      highZero, outputImg);
+}
+
 /**
  * @brief
  *
@@ -1269,27 +1423,17 @@ long long LuxLoadImageDataStretchTo16(unsigned char *imgData,
         return -1;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
     }
 
-    if (length !=
-        static_cast<unsigned long long>(
-            static_cast<float>(width * height * inChannels) * bytes)) {
+    if (length == 0 ||
+        length != LuxFrameBytes(width, height, inChannels, bpp)) {
         std::cerr << "width or height or bpp or channel are wrong!!!"
                   << "\nwidth: " << width << "\nheigth: " << height
                   << "\nbits per pixel: " << bpp
@@ -1299,17 +1443,22 @@ long long LuxLoadImageDataStretchTo16(unsigned char *imgData,
     }
 
     // Only support big endian
-    if (!isBigEndian) {
-        LuxEndianRevert(imgData, length, bpp, imgData, true);
+    if (!isBigEndian && !(bpp & LUX_BPP_MIPI)) {
+        LuxEndianRevert64(imgData, length, bpp, imgData, true);
     }
 
     /* raw */
     if (dataFormat == 1) {
-        if (bpp == 8 || bpp == 12 || bpp == 16) {
-            long long validLength = width * height;
+        if (bpp == 8 || bpp == 12 || bpp == 16 || (bpp & LUX_BPP_MIPI)) {
+            uint64_t validLength = static_cast<uint64_t>(width) * height;
             auto *temp = new uint16_t[validLength];
             uint64_t k =
-                LuxParseImageStretchTo16(imgData, length, bpp, highZero, temp);
+                LuxParseByRows(width * inChannels, height, bpp, highZero)
+                    ? LuxParseRows(imgData, length, width * inChannels, height,
+                                   bpp, highZero, LUX_DECODE_STRETCH16, 0,
+                                   temp)
+                    : LuxParseImage64StretchTo16(imgData, length, bpp, highZero,
+                                               temp);
             (void)k;
 
             // uint64_t k =
@@ -1333,21 +1482,26 @@ long long LuxLoadImageDataStretchTo16(unsigned char *imgData,
 
     /* Bayer */
     else if (dataFormat == 2) {
-        if (bpp == 8 || bpp == 12 || bpp == 16) {
-            long long validLength = width * height;
+        if (bpp == 8 || bpp == 12 || bpp == 16 || (bpp & LUX_BPP_MIPI)) {
+            uint64_t validLength = static_cast<uint64_t>(width) * height;
             auto *temp = new uint16_t[validLength];
             uint64_t k =
-                LuxParseImageStretchTo16(imgData, length, bpp, highZero, temp);
+                LuxParseByRows(width * inChannels, height, bpp, highZero)
+                    ? LuxParseRows(imgData, length, width * inChannels, height,
+                                   bpp, highZero, LUX_DECODE_STRETCH16, 0,
+                                   temp)
+                    : LuxParseImage64StretchTo16(imgData, length, bpp, highZero,
+                                               temp);
             (void)k;
 
             /// 16UC1 Bayer
             cv::Mat bayer16BitMat(height, width, CV_16UC1, temp);
             cv::Mat rgb16BitMat(height, width, CV_16UC3, outData);
-            cv::cvtColor(bayer16BitMat, rgb16BitMat, code);
+            LuxDemosaic(bayer16BitMat, rgb16BitMat, code);
 
             delete[] temp;
-            return rgb16BitMat.size().height * rgb16BitMat.size().width *
-                   rgb16BitMat.channels();
+            return static_cast<long long>(rgb16BitMat.size().height) *
+                   rgb16BitMat.size().width * rgb16BitMat.channels();
         } else {
             std::cerr << "bpp Error!" << std::endl;
             fflush(stderr);
@@ -1361,17 +1515,18 @@ long long LuxLoadImageDataStretchTo16(unsigned char *imgData,
 /**
  * @brief Load image data (Stretch to 16-bit) from file.
  * @note When Python Call the Function, the ALL parameters must be SET.
- * @param inputFileName The file before parsing.
+ * @param inputFileName The file before parsing: a headerless raw, a LuxCodec
+ * stream or a container.
  * @param dataFormat 1: raw, 2: bayer, 3: others
  * @param width Width
  * @param height Height
- * @param bpp bpp(Bits Per Pixel)  8, 12, 16
+ * @param bpp bpp(Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
  * @param channels Channels
  * @param outputRawFileName The .raw file after parsing.
  * @param outputTiffFileName The .tiff file after parsing.
  * @param isBigEndian Big Endian(be) ?
  * @param highZero 0000AAAA AAAAAAAA ?
- * @param saveTiff Save tiff ?
+ * @param saveTiff Save tiff ? Encoded on the writer queue, see LuxWriterFlush()
  * @param code
  *  - CV_BayerBG2BGR =46,
  *  - CV_BayerGB2BGR =47,
@@ -1407,59 +1562,38 @@ long long LuxLoadImageDataFromFileStretchTo16(
         return -1;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
-    }
-
-    std::ifstream ifstrm(reinterpret_cast<const char *>(inputFileName),
-                         std::ios_base::binary);
-    if (ifstrm.is_open() == false) {
-        std::cerr << "Fail to read " << inputFileName << std::endl;
-        ::fflush(stderr);
-        return -4;
-    }
-
-    /// Check the length of file
-    unsigned long long length = static_cast<unsigned long long int>(
-        static_cast<float>(width * height * inChannels) * bytes);
-    ifstrm.seekg(0, ifstrm.end);
-    unsigned long long ret = ifstrm.tellg();
-    ifstrm.seekg(0, ifstrm.beg);
-    if (ret != length) {
-        std::cerr << "The length of file is NOT right." << std::endl;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
         ::fflush(stderr);
-        return -3;
+        return -2;
     }
 
-    /// Read bytes into imgData
+    /// Read the frame into imgData: a headerless raw, a LuxCodec stream or
+    /// a container, checked by the length of the frame
+    unsigned long long length = LuxFrameBytes(width, height, inChannels, bpp);
     auto *imgData = new unsigned char[length];
-    ifstrm.read((char *)imgData, length);
+    long long ret = LuxReadFrameFromFile(inputFileName, imgData, length);
+    if (ret < 0) {
+        delete[] imgData;
+        return ret == -3 ? -4 : -3;
+    }
 
     /// According to the target, Set channels, Type of outputFile
     uint16_t *outData = nullptr;
     int cvType = CV_16UC1;
     /// raw
     if (dataFormat == 1) {
-        outData = new uint16_t[width * height * outChannels];
+        outData = new uint16_t[static_cast<uint64_t>(width) * height *
+                               outChannels];
         cvType = CV_16UC1;
     }
     /// Bayer / others
     else {
-        outData = new uint16_t[width * height * outChannels];
+        outData = new uint16_t[static_cast<uint64_t>(width) * height *
+                               outChannels];
         cvType = CV_16UC3;
     }
 
@@ -1476,9 +1610,8 @@ long long LuxLoadImageDataFromFileStretchTo16(
 
         // TIFF
         if (saveTiff)
-            LuxWriteImageIntoFile(outData, outputTiffFileName,
-                                  ImageFileType::tiff, k, width, height,
-                                  cvType);
+            LuxWriterSubmit(outData, width, height, cvType, outputTiffFileName,
+                            true);
 
         delete[] imgData;
         delete[] outData;
@@ -1513,12 +1646,14 @@ long long LuxLoadImageDataFromFileStretchTo16(
  * Q3Q4Q5Q6Q7Q8Q9Qa
  *  - 4: P0P1P2P3P4P5P6P7 P8P9PaPbQ0Q1Q2Q3 Q4Q5Q6Q7Q8Q9QaQb -> P4P5P6P7P8P9PaPb
  * Q4Q5Q6Q7Q8Q9QaQb
- *  - 5: all in 8
+ *  - 5: all in 8, the range of LuxNormalizeConf, see LuxNormalizeTo8()
  * @return long long. The number of image bytes
  */
-inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
-                                       int bpp, bool highZero,
-                                       unsigned char *outputImg, int mode) {
+static long long LuxParseImage64EnhancedSerial(unsigned char *orgiImg,
+                                               uint64_t length, int bpp,
+                                               bool highZero,
+                                               unsigned char *outputImg,
+                                               int mode) {
     if (bpp != 8 && bpp != 12 && bpp != 16) {
         std::cerr << "bpp is wrong! It only support [8, 12, 16]" << std::endl;
         ::fflush(stderr);
@@ -1556,7 +1691,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] << 4u) & 0xFF) +
                                                  (orgiImg[i + 1] >> 4u);
                                 outputImg[k++] =
@@ -1567,7 +1702,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// AAAAAAAA AAAABBBB BBBBBBBB
                         else {
                             // DONE 已测试
-                            for (int i = 0; i < length; i += 3) {
+                            for (uint64_t i = 0; i < length; i += 3) {
                                 outputImg[k++] = orgiImg[i];
                                 outputImg[k++] =
                                     ((orgiImg[i + 1] << 4u) & 0xFF) +
@@ -1588,7 +1723,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// 0000AAAA AAAAAAAA
                         // DONE Tested
                         if (highZero) {
-                            for (int i = 0; i < length; i += 2) {
+                            for (uint64_t i = 0; i < length; i += 2) {
                                 outputImg[k++] = ((orgiImg[i] << 4) & 0xFF) +
                                                  (orgiImg[i + 1] >> 4);
                             }
@@ -1597,7 +1732,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         // DONE Tested
                         else {
                             /// Set the higt 8 bit into outptImg
-                            for (int i = 0; i < length; i += 2) {
+                            for (uint64_t i = 0; i < length; i += 2) {
                                 outputImg[k++] = orgiImg[i];
                             }
                         }
@@ -1638,7 +1773,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x07) << 5) +
                                                  ((orgiImg[i + 1] & 0xF8) >> 3);
                                 outputImg[k++] =
@@ -1649,7 +1784,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// AAAAAAAA AAAABBBB BBBBBBBB
                         else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 3) {
+                            for (uint64_t i = 0; i < length; i += 3) {
                                 outputImg[k++] = ((orgiImg[i] & 0x7F) << 1) +
                                                  ((orgiImg[i + 1] & 0x80) >> 7);
                                 outputImg[k++] =
@@ -1669,7 +1804,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                     try {
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x07) << 5) +
                                                  ((orgiImg[i + 1] & 0xF8) >> 3);
                                 outputImg[k++] =
@@ -1678,7 +1813,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                             }
                         } else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x7F) << 1) +
                                                  ((orgiImg[i + 1] & 0x80) >> 7);
                                 outputImg[k++] =
@@ -1722,7 +1857,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x03) << 6) +
                                                  ((orgiImg[i + 1] & 0xFC) >> 2);
                                 outputImg[k++] =
@@ -1733,7 +1868,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// AAAAAAAA AAAABBBB BBBBBBBB
                         else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 3) {
+                            for (uint64_t i = 0; i < length; i += 3) {
                                 outputImg[k++] = ((orgiImg[i] & 0x3F) << 2) +
                                                  ((orgiImg[i + 1] & 0xC0) >> 6);
                                 //                 000000BB BBBBBB00
@@ -1754,7 +1889,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                     try {
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x03) << 6) +
                                                  ((orgiImg[i + 1] & 0xFC) >> 2);
                                 outputImg[k++] =
@@ -1763,7 +1898,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                             }
                         } else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x3F) << 2) +
                                                  ((orgiImg[i + 1] & 0xC0) >> 6);
                                 outputImg[k++] =
@@ -1808,7 +1943,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x01) << 7) +
                                                  ((orgiImg[i + 1] & 0xFE) >> 1);
                                 outputImg[k++] =
@@ -1819,7 +1954,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// AAAAAAAA AAAABBBB BBBBBBBB
                         else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 3) {
+                            for (uint64_t i = 0; i < length; i += 3) {
                                 outputImg[k++] = ((orgiImg[i] & 0x1F) << 3) +
                                                  ((orgiImg[i + 1] & 0xE0) >> 5);
                                 outputImg[k++] =
@@ -1840,7 +1975,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                     try {
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x01) << 7) +
                                                  ((orgiImg[i + 1] & 0xFE) >> 1);
                                 outputImg[k++] =
@@ -1851,7 +1986,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
 
                         else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x1F) << 3) +
                                                  ((orgiImg[i + 1] & 0xE0) >> 5);
                                 outputImg[k++] =
@@ -1896,7 +2031,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = orgiImg[i + 1];
                                 outputImg[k++] = orgiImg[i + 3];
                             }
@@ -1904,7 +2039,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         /// AAAAAAAA AAAABBBB BBBBBBBB
                         else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 3) {
+                            for (uint64_t i = 0; i < length; i += 3) {
                                 outputImg[k++] = ((orgiImg[i] & 0x0F) << 4) +
                                                  ((orgiImg[i + 1] & 0xF0) >> 4);
                                 outputImg[k++] = orgiImg[i + 2];
@@ -1923,13 +2058,13 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                     try {
                         if (highZero) {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = orgiImg[i + 1];
                                 outputImg[k++] = orgiImg[i + 3];
                             }
                         } else {
                             // DONE Tested
-                            for (int i = 0; i < length; i += 4) {
+                            for (uint64_t i = 0; i < length; i += 4) {
                                 outputImg[k++] = ((orgiImg[i] & 0x0F) << 4) +
                                                  ((orgiImg[i + 1] & 0xF0) >> 4);
                                 outputImg[k++] =
@@ -1970,10 +2105,10 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                     try {
                         /// 0000AAAA AAAAAAAA 0000BBBB BBBBBBBB
                         if (highZero) {
-                            int newLen = length / 2;
-                            k = LuxNormalize<uint16_t, uint8_t>(
+                            uint64_t newLen = length / 2;
+                            k = LuxNormalizeTo8(
                                 reinterpret_cast<uint16_t *>(orgiImg), newLen,
-                                (uint8_t *)outputImg);
+                                16, outputImg);
 
                             // auto max = std::get<0>(LuxFindMaxMin<uint16_t>(
                             //     reinterpret_cast<uint16_t*>(orgiImg), length
@@ -1991,12 +2126,11 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                         else {
                             uint64_t newLen = length / 3 * 4 / 2;
                             auto *temp = new uint16_t[newLen];
-                            auto len = LuxParseImageExtendTo16(orgiImg, length,
-                                                               12, false, temp);
+                            auto len = LuxParseImage64ExtendTo16(
+                                orgiImg, length, 12, false, temp);
                             assert(newLen == len);
 
-                            k = LuxNormalize<uint16_t, uint8_t>(temp, newLen,
-                                                                outputImg);
+                            k = LuxNormalizeTo8(temp, newLen, 12, outputImg);
 
                             // auto max = std::get<0>(LuxFindMaxMin<uint16_t>(
                             //     temp, newLen));
@@ -2019,9 +2153,9 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
                 ///
                 case 16: {
                     try {
-                        int newLen = length / 2;
-                        k = LuxNormalize<uint16_t, uint8_t>(
-                            reinterpret_cast<uint16_t *>(orgiImg), newLen,
+                        uint64_t newLen = length / 2;
+                        k = LuxNormalizeTo8(
+                            reinterpret_cast<uint16_t *>(orgiImg), newLen, 16,
                             outputImg);
                         break;
                     } catch (const std::exception &e) {
@@ -2048,6 +2182,32 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
     return k;
 }
 
+/// @brief LuxParseImage64EnhancedSerial() on bands of the frame in the pool.
+/// Mode 5 normalizes over the whole frame, in parallel itself.
+long long LuxParseImage64Enhanced(unsigned char *orgiImg, uint64_t length,
+                                  int bpp, bool highZero,
+                                  unsigned char *outputImg, int mode) {
+    if (mode == 5 || (bpp != 8 && bpp != 12 && bpp != 16))
+        return LuxParseImage64EnhancedSerial(orgiImg, length, bpp, highZero,
+                                             outputImg, mode);
+    return LuxParseInBands(
+        orgiImg, length, outputImg,
+        [bpp, highZero, mode](unsigned char *in, uint64_t n,
+                              unsigned char *out) {
+            return LuxParseImage64EnhancedSerial(in, n, bpp, highZero, out,
+                                                 mode);
+        });
+}
+
+/// @brief LuxParseImage64Enhanced() of an int length, kept for the existing
+/// callers
+long long LuxParseImageEnhanced(unsigned char *orgiImg, int length, int bpp,
+                                bool highZero, unsigned char *outputImg,
+                                int mode) {
+    return LuxParseImage64Enhanced(orgiImg, length < 0 ? 0 : length, bpp,
+                                   highZero, outputImg, mode);
+}
+
 /**
  * @brief Load image data from memory
  * @note When Python Call the Function, the ALL parameters must be SET.
@@ -2056,7 +2216,7 @@ inline long long LuxParseImageEnhanced(unsigned char *orgiImg, int length,
  * @param dataFormat 1: raw, 2: bayer, 3: others
  * @param width Width
  * @param height Height
- * @param bpp (Bits Per Pixel)  8, 12, 16
+ * @param bpp (Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
  * @param inChannels inChannels
  * @param outData The poniter of image data in memory after parsing.
  * @param isBigEndian Big Endian(be) ?
@@ -2103,29 +2263,17 @@ long long LuxLoadImageDataEnhanced(unsigned char *imgData,
         return -1;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
     }
 
-    if (length !=
-        static_cast<unsigned long long>(
-            static_cast<float>(width * height * inChannels) * bytes)) {
+    if (length == 0 ||
+        length != LuxFrameBytes(width, height, inChannels, bpp)) {
         std::cerr << "width or height or bpp or channel are wrong!!!"
                   << "\nlenght: " << length << "\nwidth: " << width
                   << "\nheigth: " << height << "\nbits per pixel: " << bpp
@@ -2135,55 +2283,79 @@ long long LuxLoadImageDataEnhanced(unsigned char *imgData,
     }
 
     // Only support big endian
-    if (!isBigEndian) {
-        LuxEndianRevert(imgData, length, bpp, imgData, true);
+    if (!isBigEndian && !(bpp & LUX_BPP_MIPI)) {
+        LUX_TRACE_SCOPE("endian_revert");
+        LuxEndianRevert64(imgData, length, bpp, imgData, true);
     }
 
     /// bind mode
     auto parseImage =
-        std::bind(&LuxParseImageEnhanced, std::placeholders::_1,
+        std::bind(&LuxParseImage64Enhanced, std::placeholders::_1,
                   std::placeholders::_2, std::placeholders::_3,
                   std::placeholders::_4, std::placeholders::_5, mode);
 
     // TODO 代码优化： 加入 outChannels/types
     /* raw */
     if (dataFormat == 1) {
-        long long validLength = width * height;
+        uint64_t validLength = static_cast<uint64_t>(width) * height;
         auto *temp = new unsigned char[validLength];
         // uint64_t k = LuxParseImage(imgData, length, bpp, highZero, temp);
-        uint64_t k = parseImage(imgData, length, bpp, highZero, temp);
+        uint64_t k = 0;
+        {
+            LUX_TRACE_SCOPE("parse");
+            k = LuxParseByRows(width * inChannels, height, bpp, highZero)
+                    ? LuxParseRows(imgData, length, width * inChannels, height,
+                                   bpp, highZero, LUX_DECODE_DISPLAY8, mode,
+                                   temp)
+                    : parseImage(imgData, length, bpp, highZero, temp);
+        }
         (void)k;
 
         cv::Mat bayer8BitMat(height, width, CV_8UC1, temp);
         cv::Mat outputImg(height, width, CV_8UC1, outData);
-        cv::cvtColor(bayer8BitMat, outputImg, code);
+        {
+            LUX_TRACE_SCOPE("cvtColor");
+            cv::cvtColor(bayer8BitMat, outputImg, code);
+        }
 
         delete[] temp;
         /* 图片大小 （字节数） */
-        return outputImg.size().width * outputImg.size().height *
-               outputImg.channels();
+        return static_cast<long long>(outputImg.size().width) *
+               outputImg.size().height * outputImg.channels();
     }
 
     /* Bayer */
     else if (dataFormat == 2) {
         int outChannels = 3;
-        long long validLength = width * height * outChannels;
+        uint64_t validLength =
+            static_cast<uint64_t>(width) * height * outChannels;
         auto *temp = new unsigned char[validLength];
         // uint64_t k = LuxParseImage(imgData, length, bpp, highZero, temp);
-        uint64_t k = parseImage(imgData, length, bpp, highZero, temp);
+        uint64_t k = 0;
+        {
+            LUX_TRACE_SCOPE("parse");
+            k = LuxParseByRows(width * inChannels, height, bpp, highZero)
+                    ? LuxParseRows(imgData, length, width * inChannels, height,
+                                   bpp, highZero, LUX_DECODE_DISPLAY8, mode,
+                                   temp)
+                    : parseImage(imgData, length, bpp, highZero, temp);
+        }
         (void)k;
 
         /// 16UC1 Bayer
         cv::Mat bayer8BitMat(height, width, CV_8UC1, temp);
         cv::Mat rgb8BitMat(height, width, CV_8UC3, outData);
-        cv::cvtColor(bayer8BitMat, rgb8BitMat, code);
+        {
+            LUX_TRACE_SCOPE("cvtColor");
+            LuxDemosaic(bayer8BitMat, rgb8BitMat, code);
+        }
 
         // cv::imshow("LuxTW2", rgb8BitMat);
         // cv::waitKey();
 
         delete[] temp;
-        return rgb8BitMat.size().height * rgb8BitMat.size().width *
-               rgb8BitMat.channels();
+        return static_cast<long long>(rgb8BitMat.size().height) *
+               rgb8BitMat.size().width * rgb8BitMat.channels();
     }
 
     return -5;
@@ -2192,17 +2364,18 @@ long long LuxLoadImageDataEnhanced(unsigned char *imgData,
 /**
  * @brief Load image data from file.
  * @note When Python Call the Function, the ALL parameters must be SET.
- * @param inputFileName The file before parsing.
+ * @param inputFileName The file before parsing: a headerless raw, a LuxCodec
+ * stream or a container.
  * @param dataFormat 1: raw, 2: bayer, 3: others
  * @param width Width
  * @param height Height
- * @param bpp bpp(Bits Per Pixel)  8, 12, 16
+ * @param bpp bpp(Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
  * @param channels Channels
  * @param outputRawFileName The .raw file after parsing.
  * @param outputTiffFileName The .tiff file after parsing.
  * @param isBigEndian Big Endian(be) ?
  * @param highZero 0000AAAA AAAAAAAA ?
- * @param saveTiff Save tiff ?
+ * @param saveTiff Save tiff ? Encoded on the writer queue, see LuxWriterFlush()
  * @param mode [0, 1, 2, 3, 4]
  * 0 - P0P1P2P3P4P5P6P7 P8P9PaPbQ0Q1Q2Q3 Q4Q5Q6Q7Q8Q9QaQb -> P0P1P2P3P4P5P6P7
  * Q0Q1Q2Q3Q4Q5Q6Q7 1 - P0P1P2P3P4P5P6P7 P8P9PaPbQ0Q1Q2Q3 Q4Q5Q6Q7Q8Q9QaQb ->
@@ -2245,63 +2418,36 @@ long long LuxLoadImageDataFromFileEnhanced(
         return -1;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
-    }
-
-    std::ifstream ifstrm(reinterpret_cast<const char *>(inputFileName),
-                         std::ios_base::binary);
-    if (ifstrm.is_open() == false) {
-        std::cerr << "Fail to read " << inputFileName << std::endl;
-        ::fflush(stderr);
-        return -3;
-    }
-
-    /// Check the length of file
-    unsigned long long length = static_cast<unsigned long long int>(
-        static_cast<float>(width * height * channels) * bytes);
-    ifstrm.seekg(0, ifstrm.end);
-    unsigned long long ret = ifstrm.tellg();
-    ifstrm.seekg(0, ifstrm.beg);
-    if (ret != length) {
-        std::cerr << "The length of file is NOT right." << std::endl
-                  << "width: " << width << " height: " << height
-                  << " channels: " << channels << " bpp: " << bpp << std::endl
-                  << "Target length: " << length << " File length: " << ret
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
                   << std::endl;
         ::fflush(stderr);
-        return -4;
+        return -2;
     }
 
-    /// Read bytes into imgData
+    /// Read the frame into imgData: a headerless raw, a LuxCodec stream or
+    /// a container, checked by the length of the frame
+    unsigned long long length = LuxFrameBytes(width, height, channels, bpp);
     auto *imgData = new unsigned char[length];
-    ifstrm.read((char *)imgData, length);
+    long long ret = LuxReadFrameFromFile(inputFileName, imgData, length);
+    if (ret < 0) {
+        delete[] imgData;
+        return ret;
+    }
 
     /// According to the target, Set channels, Type of outputFile
     unsigned char *outData = nullptr;
     int cvType = CV_8UC1;
     /// raw
     if (dataFormat == 1) {
-        outData = new unsigned char[width * height * 1];
+        outData = new unsigned char[static_cast<uint64_t>(width) * height];
         cvType = CV_8UC1;
     }
     /// Bayer / others
     else {
-        outData = new unsigned char[width * height * 3];
+        outData = new unsigned char[static_cast<uint64_t>(width) * height * 3];
         cvType = CV_8UC3;
     }
 
@@ -2314,15 +2460,21 @@ long long LuxLoadImageDataFromFileEnhanced(
     /// k > 0 is ok
     if (k > 0) {
         // For display
-        unsigned long long _ret =
-            LuxWriteImageIntoFile(outData, outputRawFileName,
-                                  ImageFileType::raw, k, width, height, cvType);
+        unsigned long long _ret = 0;
+        {
+            LUX_TRACE_SCOPE("write_raw");
+            _ret = LuxWriteImageIntoFile(outData, outputRawFileName,
+                                         ImageFileType::raw, k, width, height,
+                                         cvType);
+        }
 
         // TIFF
-        if (saveTiff)
-            LuxWriteImageIntoFile(outData, outputTiffFileName,
-                                  ImageFileType::tiff, k, width, height,
-                                  cvType);
+        // Encoded in the background, see LuxWriterFlush()
+        if (saveTiff) {
+            LUX_TRACE_SCOPE("write_tiff");
+            LuxWriterSubmit(outData, width, height, cvType, outputTiffFileName,
+                            true);
+        }
 
         delete[] imgData;
         delete[] outData;
@@ -2379,113 +2531,122 @@ int LuxGetBayerRawChanenls(unsigned char *src, int width, int height,
         return -3;
     }
 
-    int row, col;
-    unsigned int runCount = width * height;
-    int step = 2;
-    int iOff = 0;
-
-    // Seclect byaer mode
-    switch (bayerMode) {
-        // GBRG
-        case 0: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    G1Dst[iOff] = src[rPtr];
-                    BDst[iOff] = src[rPtr + 1];
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    RDst[iOff] = src[rPtr];
-                    G2Dst[iOff] = src[rPtr + 1];
+    const uint64_t runCount = static_cast<uint64_t>(width) * height;
+    const int step = 2;
+
+    /// Bands of whole row pairs, each starts on an even pixel as the scan.
+    /// With an odd width the last pixels of a row pair land on the first
+    /// index of the next one: a single band keeps the order of the scan.
+    const int64_t pairs = (height + 1) / 2;
+    const int64_t grain = width % 2 == 0 ? kGrainRows / 2 : pairs;
+    LuxParallelFor(0, pairs, grain, [&](int64_t lo, int64_t hi) {
+        const uint64_t first = lo * 2 * width;
+        const uint64_t last = std::min<uint64_t>(hi * 2 * width, runCount);
+        int64_t row, col;
+        uint64_t iOff = 0;
+
+        switch (bayerMode) {
+            // GBRG
+            case 0: {
+                for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                    row = (rPtr * 2 / step) / width;
+                    col = (rPtr * 2 / step) - width * row;
+
+                    // Even
+                    if (row % 2 == 0) {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        G1Dst[iOff] = src[rPtr];
+                        BDst[iOff] = src[rPtr + 1];
+                        // Odd
+                    } else {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        RDst[iOff] = src[rPtr];
+                        G2Dst[iOff] = src[rPtr + 1];
+                    }
                 }
+                break;
             }
-            break;
-        }
 
-        // GRBG
-        case 1: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    G1Dst[iOff] = src[rPtr];
-                    RDst[iOff] = src[rPtr + 1];
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    BDst[iOff] = src[rPtr];
-                    G2Dst[iOff] = src[rPtr + 1];
+            // GRBG
+            case 1: {
+                for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                    row = (rPtr * 2 / step) / width;
+                    col = (rPtr * 2 / step) - width * row;
+
+                    // Even
+                    if (row % 2 == 0) {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        G1Dst[iOff] = src[rPtr];
+                        RDst[iOff] = src[rPtr + 1];
+                        // Odd
+                    } else {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        BDst[iOff] = src[rPtr];
+                        G2Dst[iOff] = src[rPtr + 1];
+                    }
                 }
+                break;
             }
-            break;
-        }
 
-        // BGGR
-        case 2: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    BDst[iOff] = src[rPtr];
-                    G1Dst[iOff] = src[rPtr + 1];
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    G2Dst[iOff] = src[rPtr];
-                    RDst[iOff] = src[rPtr + 1];
+            // BGGR
+            case 2: {
+                for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                    row = (rPtr * 2 / step) / width;
+                    col = (rPtr * 2 / step) - width * row;
+
+                    // Even
+                    if (row % 2 == 0) {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        BDst[iOff] = src[rPtr];
+                        G1Dst[iOff] = src[rPtr + 1];
+                        // Odd
+                    } else {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        G2Dst[iOff] = src[rPtr];
+                        RDst[iOff] = src[rPtr + 1];
+                    }
                 }
+                break;
             }
-            break;
-        }
 
-        // RGGB
-        case 3: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    RDst[iOff] = src[rPtr];
-                    G1Dst[iOff] = src[rPtr + 1];
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    iOff = row * (width / 2) + col;
-                    G2Dst[iOff] = src[rPtr];
-                    BDst[iOff] = src[rPtr + 1];
+            // RGGB
+            case 3: {
+                for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                    row = (rPtr * 2 / step) / width;
+                    col = (rPtr * 2 / step) - width * row;
+
+                    // Even
+                    if (row % 2 == 0) {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        RDst[iOff] = src[rPtr];
+                        G1Dst[iOff] = src[rPtr + 1];
+                        // Odd
+                    } else {
+                        row = row / 2;
+                        col = col / 2;
+                        iOff = row * (width / 2) + col;
+                        G2Dst[iOff] = src[rPtr];
+                        BDst[iOff] = src[rPtr + 1];
+                    }
                 }
+                break;
             }
-            break;
         }
-    }
+    });
 
     return 0;
 }
@@ -2535,121 +2696,138 @@ long long LuxSetChannelFactors(unsigned char *src, int width, int height,
         return -4;
     }
 
-    int row, col;
-    unsigned int runCount = width * height;
-    int step = 2;
-    int k = 0;
-
-    // Seclect byaer mode
-    switch (mode) {
-        // GBRG
-        case 0: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * g);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * b);
-                    k++;
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * r);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * g);
-                    k++;
+    const uint64_t runCount = static_cast<uint64_t>(width) * height;
+    const int step = 2;
+    std::atomic<long long> k{0};
+
+    /// Bands of whole row pairs, each starts on an even pixel as the scan
+    LuxParallelFor(
+        0, (height + 1) / 2, kGrainRows / 2, [&](int64_t lo, int64_t hi) {
+            const uint64_t first = lo * 2 * width;
+            const uint64_t last =
+                std::min<uint64_t>(hi * 2 * width, runCount);
+            int64_t row, col;
+            long long n = 0;
+
+            switch (mode) {
+                // GBRG
+                case 0: {
+                    for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                        row = (rPtr * 2 / step) / width;
+                        col = (rPtr * 2 / step) - width * row;
+
+                        // Even
+                        if (row % 2 == 0) {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * g);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * b);
+                            n++;
+                            // Odd
+                        } else {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * r);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * g);
+                            n++;
+                        }
+                    }
+                    break;
                 }
-            }
-            break;
-        }
 
-        // GRBG
-        case 1: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * g);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * r);
-                    k++;
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * b);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * g);
-                    k++;
+                // GRBG
+                case 1: {
+                    for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                        row = (rPtr * 2 / step) / width;
+                        col = (rPtr * 2 / step) - width * row;
+
+                        // Even
+                        if (row % 2 == 0) {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * g);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * r);
+                            n++;
+                            // Odd
+                        } else {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * b);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * g);
+                            n++;
+                        }
+                    }
+                    break;
                 }
-            }
-            break;
-        }
 
-        // BGGR
-        case 2: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * b);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * g);
-                    k++;
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * g);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * r);
-                    k++;
+                // BGGR
+                case 2: {
+                    for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                        row = (rPtr * 2 / step) / width;
+                        col = (rPtr * 2 / step) - width * row;
+
+                        // Even
+                        if (row % 2 == 0) {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * b);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * g);
+                            n++;
+                            // Odd
+                        } else {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * g);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * r);
+                            n++;
+                        }
+                    }
+                    break;
                 }
-            }
-            break;
-        }
 
-        // RGGB
-        case 3: {
-            for (unsigned int rPtr = 0; rPtr < runCount; rPtr += step) {
-                row = (rPtr * 2 / step) / width;
-                col = (rPtr * 2 / step) - width * row;
-
-                // Even
-                if (row % 2 == 0) {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * r);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * g);
-                    k++;
-                    // Odd
-                } else {
-                    row = row / 2;
-                    col = col / 2;
-                    // iOff = row * (width / 2) + col;
-                    src[rPtr] = LuxBound255<float>(src[rPtr] * g);
-                    src[rPtr + 1] = LuxBound255<float>(src[rPtr + 1] * b);
-                    k++;
+                // RGGB
+                case 3: {
+                    for (uint64_t rPtr = first; rPtr < last; rPtr += step) {
+                        row = (rPtr * 2 / step) / width;
+                        col = (rPtr * 2 / step) - width * row;
+
+                        // Even
+                        if (row % 2 == 0) {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * r);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * g);
+                            n++;
+                            // Odd
+                        } else {
+                            row = row / 2;
+                            col = col / 2;
+                            // iOff = row * (width / 2) + col;
+                            src[rPtr] = LuxBound255<float>(src[rPtr] * g);
+                            src[rPtr + 1] =
+                                LuxBound255<float>(src[rPtr + 1] * b);
+                            n++;
+                        }
+                    }
+                    break;
                 }
             }
-            break;
-        }
-    }
+            k += n;
+        });
 
     // Bytes
     return k;
@@ -2663,7 +2841,7 @@ long long LuxSetChannelFactors(unsigned char *src, int width, int height,
  * @param dataFormat 1: raw, 2: bayer, 3: others
  * @param width Width
  * @param height Height
- * @param bpp (Bits Per Pixel)  8, 12, 16
+ * @param bpp (Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
  * @param inChannels inChannels
  * @param outData The poniter of image data in memory after parsing.
  * @param isBigEndian Big Endian(be) ?
@@ -2720,29 +2898,17 @@ long long LuxLoadImageDataEnhanced2(unsigned char *imgData,
         return -1;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
     }
 
-    if (length !=
-        static_cast<unsigned long long>(
-            static_cast<float>(width * height * inChannels) * bytes)) {
+    if (length == 0 ||
+        length != LuxFrameBytes(width, height, inChannels, bpp)) {
         std::cerr << "width or height or bpp or channel are wrong!!!"
                   << "\nwidth: " << width << "\nheigth: " << height
                   << "\nbits per pixel: " << bpp
@@ -2752,23 +2918,32 @@ long long LuxLoadImageDataEnhanced2(unsigned char *imgData,
     }
 
     // Only support big endian
-    if (!isBigEndian) {
-        LuxEndianRevert(imgData, length, bpp, imgData, true);
+    if (!isBigEndian && !(bpp & LUX_BPP_MIPI)) {
+        LUX_TRACE_SCOPE("endian_revert");
+        LuxEndianRevert64(imgData, length, bpp, imgData, true);
     }
 
     /// bind mode
     auto parseImage =
-        std::bind(&LuxParseImageEnhanced, std::placeholders::_1,
+        std::bind(&LuxParseImage64Enhanced, std::placeholders::_1,
                   std::placeholders::_2, std::placeholders::_3,
                   std::placeholders::_4, std::placeholders::_5, mode);
 
     // TODO 代码优化： 加入 outChannels/types
     /* raw */
     if (dataFormat == 1) {
-        long long validLength = width * height;
+        uint64_t validLength = static_cast<uint64_t>(width) * height;
         auto *temp = new unsigned char[validLength];
         // uint64_t k = LuxParseImage(imgData, length, bpp, highZero, temp);
-        uint64_t k = parseImage(imgData, length, bpp, highZero, temp);
+        uint64_t k = 0;
+        {
+            LUX_TRACE_SCOPE("parse");
+            k = LuxParseByRows(width * inChannels, height, bpp, highZero)
+                    ? LuxParseRows(imgData, length, width * inChannels, height,
+                                   bpp, highZero, LUX_DECODE_DISPLAY8, mode,
+                                   temp)
+                    : parseImage(imgData, length, bpp, highZero, temp);
+        }
         (void)k;
 
         // Adjust r/g/b
@@ -2782,39 +2957,56 @@ long long LuxLoadImageDataEnhanced2(unsigned char *imgData,
 
         cv::Mat bayer8BitMat(height, width, CV_8UC1, temp);
         cv::Mat outputImg(height, width, CV_8UC1, outData);
-        cv::cvtColor(bayer8BitMat, outputImg, code);
+        {
+            LUX_TRACE_SCOPE("cvtColor");
+            cv::cvtColor(bayer8BitMat, outputImg, code);
+        }
 
         delete[] temp;
         /* 图片大小 （字节数） */
-        return outputImg.size().width * outputImg.size().height *
-               outputImg.channels();
+        return static_cast<long long>(outputImg.size().width) *
+               outputImg.size().height * outputImg.channels();
     }
 
     /* Bayer */
     else if (dataFormat == 2) {
         int outChannels = 3;
-        long long validLength = width * height * outChannels;
+        uint64_t validLength =
+            static_cast<uint64_t>(width) * height * outChannels;
         auto *temp = new unsigned char[validLength];
         // uint64_t k = LuxParseImage(imgData, length, bpp, highZero, temp);
-        uint64_t k = parseImage(imgData, length, bpp, highZero, temp);
+        uint64_t k = 0;
+        {
+            LUX_TRACE_SCOPE("parse");
+            k = LuxParseByRows(width * inChannels, height, bpp, highZero)
+                    ? LuxParseRows(imgData, length, width * inChannels, height,
+                                   bpp, highZero, LUX_DECODE_DISPLAY8, mode,
+                                   temp)
+                    : parseImage(imgData, length, bpp, highZero, temp);
+        }
 
         // Adjust r/g/b
-        if (eaf)
+        if (eaf) {
+            LUX_TRACE_SCOPE("white_balance");
             k = LuxSetChannelFactors(temp, width, height, bayerType, r, g, b);
-        else
+        } else {
             (void)k;
+        }
 
         /// 16UC1 Bayer
         cv::Mat bayer8BitMat(height, width, CV_8UC1, temp);
         cv::Mat rgb8BitMat(height, width, CV_8UC3, outData);
-        cv::cvtColor(bayer8BitMat, rgb8BitMat, code);
+        {
+            LUX_TRACE_SCOPE("cvtColor");
+            LuxDemosaic(bayer8BitMat, rgb8BitMat, code);
+        }
 
         // cv::imshow("LuxTW2", rgb8BitMat);
         // cv::waitKey();
 
         delete[] temp;
-        return rgb8BitMat.size().height * rgb8BitMat.size().width *
-               rgb8BitMat.channels();
+        return static_cast<long long>(rgb8BitMat.size().height) *
+               rgb8BitMat.size().width * rgb8BitMat.channels();
     }
 
     return -5;
@@ -2823,17 +3015,18 @@ long long LuxLoadImageDataEnhanced2(unsigned char *imgData,
 /**
  * @brief Load image data from file.
  * @note When Python Call the Function, the ALL parameters must be SET.
- * @param inputFileName The file before parsing.
+ * @param inputFileName The file before parsing: a headerless raw, a LuxCodec
+ * stream or a container.
  * @param dataFormat 1: raw, 2: bayer, 3: others
  * @param width Width
  * @param height Height
- * @param bpp bpp(Bits Per Pixel)  8, 12, 16
+ * @param bpp bpp(Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
  * @param channels Channels
  * @param outputRawFileName The .raw file after parsing.
  * @param outputTiffFileName The .tiff file after parsing.
  * @param isBigEndian Big Endian(be) ?
  * @param highZero 0000AAAA AAAAAAAA ?
- * @param saveTiff Save tiff ?
+ * @param saveTiff Save tiff ? Encoded on the writer queue, see LuxWriterFlush()
  * @param mode [0, 1, 2, 3, 4]
  * 0 - P0P1P2P3P4P5P6P7 P8P9PaPbQ0Q1Q2Q3 Q4Q5Q6Q7Q8Q9QaQb -> P0P1P2P3P4P5P6P7
  * Q0Q1Q2Q3Q4Q5Q6Q7 1 - P0P1P2P3P4P5P6P7 P8P9PaPbQ0Q1Q2Q3 Q4Q5Q6Q7Q8Q9QaQb ->
@@ -2886,22 +3079,146 @@ long long LuxLoadImageDataFromFileEnhanced2(
         return -1;
     }
 
-    float bytes = 0.0;
-    switch (bpp) {
-        case 8:
-            bytes = 1;
-            break;
-        case 12:
-            bytes = 1.5;
-            break;
-        case 16:
-            bytes = 2;
-            break;
-        default:
-            std::cerr << "bpp Don't Supported!!! \n"
-                      << "Supported depth of bits: 8, 12, 16" << std::endl;
-            ::fflush(stderr);
-            return -2;
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
+    }
+
+    /// Read the frame into imgData: a headerless raw, a LuxCodec stream or
+    /// a container, checked by the length of the frame
+    unsigned long long length = LuxFrameBytes(width, height, channels, bpp);
+    auto *imgData = new unsigned char[length];
+    long long ret = LuxReadFrameFromFile(inputFileName, imgData, length);
+    if (ret < 0) {
+        delete[] imgData;
+        return ret;
+    }
+
+    /// According to the target, Set channels, Type of outputFile
+    unsigned char *outData = nullptr;
+    int cvType = CV_8UC1;
+    /// raw
+    if (dataFormat == 1) {
+        outData = new unsigned char[static_cast<uint64_t>(width) * height];
+        cvType = CV_8UC1;
+    }
+    /// Bayer / others
+    else {
+        outData = new unsigned char[static_cast<uint64_t>(width) * height * 3];
+        cvType = CV_8UC3;
+    }
+
+    // unsigned long long k = LuxLoadImageData(imgData, length, dataFormat,
+    // width, height, bpp, channels, outData, isBigEndian, highZero, code);
+    long long k = LuxLoadImageDataEnhanced2(
+        imgData, length, dataFormat, width, height, bpp, channels, outData,
+        isBigEndian, highZero, mode, code, eaf, bayerType, r, g, b);
+
+    /// k > 0 is ok
+    if (k > 0) {
+        // For display
+        unsigned long long _ret = 0;
+        {
+            LUX_TRACE_SCOPE("write_raw");
+            _ret = LuxWriteImageIntoFile(outData, outputRawFileName,
+                                         ImageFileType::raw, k, width, height,
+                                         cvType);
+        }
+
+        // TIFF
+        // Encoded in the background, see LuxWriterFlush()
+        if (saveTiff) {
+            LUX_TRACE_SCOPE("write_tiff");
+            LuxWriterSubmit(outData, width, height, cvType, outputTiffFileName,
+                            true);
+        }
+
+        delete[] imgData;
+        delete[] outData;
+        return _ret;
+    } else {
+        delete[] imgData;
+        delete[] outData;
+        return k;
+    }
+
+    return -5;
+}
+
+/**
+ * @brief Load image data from a file whose lines (or frame) carry a CRC, verify
+ * them while stripping the link framing, then decode like
+ * LuxLoadImageDataFromFileEnhanced().
+ * @note The image is still decoded when CRC errors are found, so the corrupted
+ * lines can be shown to the user.
+ * @param inputFileName The file before parsing.
+ * @param dataFormat 1: raw, 2: bayer, 3: others
+ * @param width Width
+ * @param height Height
+ * @param bpp bpp(Bits Per Pixel)  8, 12, 16 or LuxMipiBpp
+ * @param channels Channels
+ * @param outputRawFileName The .raw file after parsing.
+ * @param outputTiffFileName The .tiff file after parsing.
+ * @param isBigEndian Big Endian(be) ?
+ * @param highZero 0000AAAA AAAAAAAA ?
+ * @param saveTiff Save tiff ? Encoded on the writer queue, see LuxWriterFlush()
+ * @param mode [0, 1, 2, 3, 4, 5], see LuxParseImageEnhanced()
+ * @param code The cv::COLOR_Bayer* code
+ * @param checkConf The CRC variant and record layout, see LuxCheckConf
+ * @param badLines Receives the indices of the corrupted lines, may be nullptr
+ * @param badLinesCap The capacity of @c badLines
+ * @param badCount Receives the number of corrupted lines, may be nullptr
+ * @return long long
+ * The bytes number of image file if success.
+ *  -1 : Data Format Don't Supported.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -3 : File open failed.
+ *  -4 : width or height or bpp or channel are wrong.
+ *  -5 : It is not reached.
+ *  -6 : Check configuration is wrong.
+ */
+long long LuxLoadImageDataFromFileChecked(
+    const char *inputFileName, int dataFormat, int width, int height, int bpp,
+    int channels, const char *outputRawFileName, const char *outputTiffFileName,
+    bool isBigEndian, bool highZero, bool saveTiff, int mode, int code,
+    const LuxCheckConf *checkConf, int *badLines, int badLinesCap,
+    int *badCount) {
+    if (badCount != nullptr) *badCount = 0;
+
+    if (dataFormat != 1 && dataFormat != 2 && dataFormat != 3) {
+        std::cerr << "Data Format Don't Supported!!! \n"
+                  << "1: raw, 2: bayer, 3: others" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
+    }
+
+    /// Payload bytes of one line, the CRC is computed over the packed bytes
+    uint64_t lineBytes = LuxFrameBytes(width, 1, channels, bpp);
+    if (lineBytes == 0 || height <= 0) {
+        std::cerr << "width or height or bpp or channel are wrong!!!"
+                  << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+    unsigned long long length = lineBytes * height;
+
+    if (checkConf == nullptr || LuxCRCBytes(checkConf->crcType) == 0) {
+        std::cerr << "Check configuration is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -6;
     }
 
     std::ifstream ifstrm(reinterpret_cast<const char *>(inputFileName),
@@ -2913,53 +3230,76 @@ long long LuxLoadImageDataFromFileEnhanced2(
     }
 
     /// Check the length of file
-    unsigned long long length = static_cast<unsigned long long int>(
-        static_cast<float>(width * height * channels) * bytes);
+    unsigned long long framed =
+        LuxCheckFrameBytes(checkConf, lineBytes, height);
     ifstrm.seekg(0, ifstrm.end);
     unsigned long long ret = ifstrm.tellg();
     ifstrm.seekg(0, ifstrm.beg);
-    if (ret != length) {
-        std::cerr << "The length of file is NOT right." << std::endl;
+    if (ret != framed) {
+        std::cerr << "The length of file is NOT right." << std::endl
+                  << "Target length: " << framed << " File length: " << ret
+                  << std::endl;
         ::fflush(stderr);
         return -4;
     }
 
-    /// Read bytes into imgData
+    /// Read the framed bytes, verify and strip them into imgData
+    auto *framedData = new unsigned char[framed];
+    {
+        LUX_TRACE_SCOPE("read_file");
+        ifstrm.read((char *)framedData, framed);
+    }
+
     auto *imgData = new unsigned char[length];
-    ifstrm.read((char *)imgData, length);
+    long long bad = 0;
+    {
+        LUX_TRACE_SCOPE("crc_verify");
+        bad = LuxCheckVerify(framedData, framed, lineBytes, height, checkConf,
+                             imgData, badLines, badLinesCap);
+    }
+    delete[] framedData;
+    if (bad < 0) {
+        delete[] imgData;
+        return -6;
+    }
+    if (badCount != nullptr) *badCount = static_cast<int>(bad);
 
     /// According to the target, Set channels, Type of outputFile
     unsigned char *outData = nullptr;
     int cvType = CV_8UC1;
     /// raw
     if (dataFormat == 1) {
-        outData = new unsigned char[width * height * 1];
+        outData = new unsigned char[static_cast<uint64_t>(width) * height];
         cvType = CV_8UC1;
     }
     /// Bayer / others
     else {
-        outData = new unsigned char[width * height * 3];
+        outData = new unsigned char[static_cast<uint64_t>(width) * height * 3];
         cvType = CV_8UC3;
     }
 
-    // unsigned long long k = LuxLoadImageData(imgData, length, dataFormat,
-    // width, height, bpp, channels, outData, isBigEndian, highZero, code);
-    long long k = LuxLoadImageDataEnhanced2(
-        imgData, length, dataFormat, width, height, bpp, channels, outData,
-        isBigEndian, highZero, mode, code, eaf, bayerType, r, g, b);
+    long long k = LuxLoadImageDataEnhanced(imgData, length, dataFormat, width,
+                                           height, bpp, channels, outData,
+                                           isBigEndian, highZero, mode, code);
 
     /// k > 0 is ok
     if (k > 0) {
         // For display
-        unsigned long long _ret =
-            LuxWriteImageIntoFile(outData, outputRawFileName,
-                                  ImageFileType::raw, k, width, height, cvType);
+        unsigned long long _ret = 0;
+        {
+            LUX_TRACE_SCOPE("write_raw");
+            _ret = LuxWriteImageIntoFile(outData, outputRawFileName,
+                                         ImageFileType::raw, k, width, height,
+                                         cvType);
+        }
 
         // TIFF
-        if (saveTiff)
-            LuxWriteImageIntoFile(outData, outputTiffFileName,
-                                  ImageFileType::tiff, k, width, height,
-                                  cvType);
+        // Encoded in the background, see LuxWriterFlush()
+        if (saveTiff) {
+            LUX_TRACE_SCOPE("write_tiff");
+            LuxWriterSubmit(outData, width, height, cvType, outputTiffFileName,
+                            true);
+        }
 
         delete[] imgData;
         delete[] outData;
@@ -2972,3 +3312,163 @@ long long LuxLoadImageDataFromFileEnhanced2(
 
     return -5;
 }
+
+/**
+ * @brief LuxLoadImageDataEnhanced() of a capture with line padding and
+ * embedded data lines, read in place: no repack, and @c imgData is not
+ * modified (little endian frames are not swapped in place).
+ * @param imgData The capture, (topLines + height + bottomLines) lines of
+ * @c layout->inStride bytes
+ * @param length The bytes number of the capture
+ * @param outData Rows of @c layout->outStride pixels (0: width)
+ * @param layout Row stride, embedded data lines and output stride, nullptr:
+ * packed rows
+ * @return long long
+ * The bytes number of image (without the output padding) if success.
+ *  -1 : Data Format Don't Supported.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -4 : width or height or bpp or channel or layout are wrong.
+ *  -5 : It is not reached.
+ */
+long long LuxLoadImageDataStrided(const unsigned char *imgData,
+                                  unsigned long long length, int dataFormat,
+                                  int width, int height, int bpp,
+                                  int inChannels, unsigned char *outData,
+                                  bool isBigEndian, bool highZero, int mode,
+                                  int code, const LuxFrameLayout *layout) {
+    if (dataFormat != 1 && dataFormat != 2 && dataFormat != 3) {
+        std::cerr << "Data Format Don't Supported!!! \n"
+                  << "1: raw, 2: bayer, 3: others" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
+    }
+
+    const uint64_t outStride = LuxLayoutOutStride(layout, width);
+    if (LuxFrameBytes(width, height, inChannels, bpp) == 0 || outStride == 0) {
+        std::cerr << "width or height or bpp or channel are wrong!!!"
+                  << "\nwidth: " << width << "\nheigth: " << height
+                  << "\nbits per pixel: " << bpp
+                  << "\ninChannels: " << inChannels << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+    if (dataFormat == 3) return -5;
+
+    /// The 8-bit window, packed, straight from the padded rows
+    const int samplesPerRow = width * inChannels;
+    LuxFrameLayout inLayout = {};
+    if (layout != nullptr) {
+        inLayout = *layout;
+        inLayout.outStride = 0;
+    }
+    std::vector<unsigned char> temp(static_cast<size_t>(samplesPerRow) *
+                                    height);
+    LuxDecodeRequest request = {};
+    request.outputs = LUX_DECODE_DISPLAY8;
+    request.mode = mode;
+    request.display8 = temp.data();
+    long long k = 0;
+    {
+        LUX_TRACE_SCOPE("parse");
+        k = LuxDecodeMultiStrided(imgData, length, samplesPerRow, height, bpp,
+                                  isBigEndian, highZero, &inLayout, &request);
+    }
+    if (k < 0) return k;
+
+    const int outChannels = dataFormat == 1 ? 1 : 3;
+    cv::Mat bayer8BitMat(height, width, CV_8UC1, temp.data(), samplesPerRow);
+    cv::Mat outputImg(height, width, dataFormat == 1 ? CV_8UC1 : CV_8UC3,
+                      outData, outStride * outChannels);
+    {
+        LUX_TRACE_SCOPE("cvtColor");
+        LuxDemosaic(bayer8BitMat, outputImg, code);
+    }
+    return static_cast<long long>(width) * height * outChannels;
+}
+
+/**
+ * @brief LuxLoadImageDataFromFileEnhanced() of a capture with line padding
+ * and embedded data lines, see LuxLoadImageDataStrided(). The outputs are
+ * packed, @c layout->outStride is not used.
+ * @return long long
+ * The bytes number of image file if success.
+ *  -1 : Data Format Don't Supported.
+ *  -2 : Bits per pixel Don't Supported.
+ *  -3 : File open failed.
+ *  -4 : width or height or bpp or channel or layout are wrong.
+ *  -5 : It is not reached.
+ */
+long long LuxLoadImageDataFromFileStrided(
+    const char *inputFileName, int dataFormat, int width, int height, int bpp,
+    int channels, const char *outputRawFileName, const char *outputTiffFileName,
+    bool isBigEndian, bool highZero, bool saveTiff, int mode, int code,
+    const LuxFrameLayout *layout) {
+    if (dataFormat != 1 && dataFormat != 2 && dataFormat != 3) {
+        std::cerr << "Data Format Don't Supported!!! \n"
+                  << "1: raw, 2: bayer, 3: others" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
+    }
+
+    LuxFrameLayout inLayout = {};
+    if (layout != nullptr) {
+        inLayout = *layout;
+        inLayout.outStride = 0;
+    }
+    unsigned long long length = LuxFrameLayoutBytes(
+        &inLayout, LuxFrameBytes(width, 1, channels, bpp), height);
+    if (length == 0) {
+        std::cerr << "width or height or bpp or channel are wrong!!!"
+                  << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+
+    std::vector<unsigned char> imgData(length);
+    long long ret = LuxReadFrameFromFile(inputFileName, imgData.data(), length);
+    if (ret < 0) return ret;
+
+    int cvType = dataFormat == 1 ? CV_8UC1 : CV_8UC3;
+    std::vector<unsigned char> outData(static_cast<size_t>(width) * height *
+                                       (dataFormat == 1 ? 1 : 3));
+    long long k = LuxLoadImageDataStrided(
+        imgData.data(), length, dataFormat, width, height, bpp, channels,
+        outData.data(), isBigEndian, highZero, mode, code, &inLayout);
+    if (k <= 0) return k;
+
+    // For display
+    unsigned long long _ret = 0;
+    {
+        LUX_TRACE_SCOPE("write_raw");
+        _ret = LuxWriteImageIntoFile(outData.data(), outputRawFileName,
+                                     ImageFileType::raw, k, width, height,
+                                     cvType);
+    }
+
+    // TIFF
+    // Encoded in the background, see LuxWriterFlush()
+    if (saveTiff) {
+        LUX_TRACE_SCOPE("write_tiff");
+        LuxWriterSubmit(outData.data(), width, height, cvType,
+                        outputTiffFileName, true);
+    }
+    return _ret;
+}
@@ -0,0 +1,480 @@
+/**
+ * @file LuxDecode.cc
+ */
+
+#include <imgCore/LuxCalib.h>
+#include <imgCore/LuxDecode.h>
+#include <imgCore/LuxDefect.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <imgCore/LuxWriter.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+/// Bits of the histogram of the mode 5 range
+constexpr int kLevelBits = 12;
+
+LuxNormalizeConf gNormalize{0, 100};
+std::mutex gNormalizeMutex;
+
+LuxNormalizeConf normalizeConf() {
+    std::lock_guard<std::mutex> lock(gNormalizeMutex);
+    return gNormalize;
+}
+
+/// Statistics of one band, merged under a lock at its end
+struct BandStats {
+    uint16_t siteMin[4] = {UINT16_MAX, UINT16_MAX, UINT16_MAX, UINT16_MAX};
+    uint16_t siteMax[4] = {0, 0, 0, 0};
+    uint64_t siteSum[4] = {0, 0, 0, 0};
+    uint64_t siteCount[4] = {0, 0, 0, 0};
+    uint32_t histogram[256] = {0};
+    uint32_t levels[1 << kLevelBits] = {0};  ///< Range of mode 5
+
+    void merge(const BandStats &o) {
+        for (int s = 0; s < 4; ++s) {
+            siteMin[s] = std::min(siteMin[s], o.siteMin[s]);
+            siteMax[s] = std::max(siteMax[s], o.siteMax[s]);
+            siteSum[s] += o.siteSum[s];
+            siteCount[s] += o.siteCount[s];
+        }
+        for (int i = 0; i < 256; ++i) histogram[i] += o.histogram[i];
+        for (int i = 0; i < (1 << kLevelBits); ++i) levels[i] += o.levels[i];
+    }
+};
+
+/// Window of mode [0, 4]: 8 bits starting @c mode bits below the top one,
+/// the lowest 8 bits once a 10-bit sample runs out of windows
+inline int windowShift(int bits, int mode) {
+    return std::max(0, bits - 8 - mode);
+}
+
+/// Mode 5: [black, white] of every possible sample value to [0, 255]. With
+/// black 0 and white the maximum it is normlize255().
+std::vector<unsigned char> normalizeLut(uint16_t mask, uint16_t black,
+                                        uint16_t white) {
+    std::vector<unsigned char> lut(mask + 1u, 0);
+    if (white <= black) {
+        /// A flat range: white from the white point on
+        for (uint32_t v = white; white > 0 && v <= mask; ++v)
+            lut[v] = UINT8_MAX;
+        return lut;
+    }
+    const float range = static_cast<float>(white - black);
+    for (uint32_t v = black; v <= mask; ++v)
+        lut[v] = static_cast<unsigned char>(
+            (std::min(v, static_cast<uint32_t>(white)) - black) / range *
+            UINT8_MAX);
+    return lut;
+}
+
+/// Mode 5 LUT from the level histogram (bins of @c 1 << shift values) and
+/// the exact maximum, see LuxNormalizeConf
+std::vector<unsigned char> normalizeLut(uint16_t mask, const uint32_t *levels,
+                                        int shift, uint16_t max) {
+    const LuxNormalizeConf conf = normalizeConf();
+    uint64_t count = 0;
+    for (int i = 0; i < (1 << kLevelBits); ++i) count += levels[i];
+
+    /// First bin whose cumulative count reaches @c rank percent
+    auto bin = [&](double rank) {
+        uint64_t target = std::max<uint64_t>(
+            1, static_cast<uint64_t>(std::ceil(rank / 100.0 * count)));
+        uint64_t cumulative = 0;
+        for (int i = 0; i < (1 << kLevelBits); ++i) {
+            cumulative += levels[i];
+            if (cumulative >= target) return i;
+        }
+        return (1 << kLevelBits) - 1;
+    };
+
+    uint16_t black = 0, white = max;
+    if (count > 0 && conf.lowPercentile > 0)
+        black = static_cast<uint16_t>(bin(conf.lowPercentile) << shift);
+    if (count > 0 && conf.highPercentile < 100)
+        white = static_cast<uint16_t>(
+            std::min<uint32_t>(((bin(conf.highPercentile) + 1) << shift) - 1,
+                               max));
+    return normalizeLut(mask, black, std::max(white, black));
+}
+
+bool validRequest(const LuxDecodeRequest *r, int width, int height,
+                  uint64_t outStride) {
+    if (r == nullptr || r->outputs == 0) return false;
+    if ((r->outputs & LUX_DECODE_DISPLAY8) &&
+        (r->display8 == nullptr || r->mode < 0 || r->mode > 5))
+        return false;
+    if ((r->outputs & LUX_DECODE_EXTEND16) && r->extend16 == nullptr)
+        return false;
+    if ((r->outputs & LUX_DECODE_STRETCH16) && r->stretch16 == nullptr)
+        return false;
+    if (r->outputs & LUX_DECODE_PLANES) {
+        if (width % 2 != 0 || height % 2 != 0) return false;
+        for (auto *plane : r->planes)
+            if (plane == nullptr) return false;
+    }
+    if ((r->outputs & LUX_DECODE_STATS) && r->stats == nullptr) return false;
+    /// The writer takes packed rows
+    return r->tiffFileName == nullptr ||
+           ((r->outputs & LUX_DECODE_STRETCH16) &&
+            outStride == static_cast<uint64_t>(width));
+}
+
+}  // namespace
+
+long long LuxDecodeMulti(const unsigned char *imgData,
+                         unsigned long long length, int width, int height,
+                         int bpp, bool isBigEndian, bool highZero,
+                         LuxDecodeRequest *request) {
+    return LuxDecodeMultiStrided(imgData, length, width, height, bpp,
+                                 isBigEndian, highZero, nullptr, request);
+}
+
+long long LuxDecodeMultiStrided(const unsigned char *imgData,
+                                unsigned long long length, int width,
+                                int height, int bpp, bool isBigEndian,
+                                bool highZero, const LuxFrameLayout *layout,
+                                LuxDecodeRequest *request) {
+    LUX_TRACE_SCOPE("decode_multi");
+    int ret = LuxCheckFrameLayout(imgData, length, width, height, bpp, layout);
+    if (ret < 0) return ret;
+    const uint64_t inRow =
+        LuxLayoutInStride(layout, LuxPackedBytes(width, bpp));
+    const uint64_t outRow = LuxLayoutOutStride(layout, width);
+    if (layout != nullptr) imgData += layout->topLines * inRow;
+    if (!validRequest(request, width, height, outRow)) {
+        std::cerr << "Decode request is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -6;
+    }
+
+    const unsigned int outputs = request->outputs;
+    const int bits = LuxSignificantBits(bpp, highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << bits) - 1);
+    const int stretchShift = 16 - bits;
+    const int histShift = bits - 8;
+    const int levelShift = std::max(0, bits - kLevelBits);
+    const uint64_t samples = static_cast<uint64_t>(width) * height;
+    const int planeWidth = width / 2;
+
+    /// Mode 5 needs the maximum: keep the samples, window them afterwards
+    const bool display8 = (outputs & LUX_DECODE_DISPLAY8) != 0;
+    const bool normalize = display8 && request->mode == 5 && bits > 8;
+    const bool stats = (outputs & LUX_DECODE_STATS) || normalize;
+    std::vector<uint16_t> scratch;
+    uint16_t *extend16 = (outputs & LUX_DECODE_EXTEND16) ? request->extend16
+                                                         : nullptr;
+    if (normalize && extend16 == nullptr) {
+        scratch.resize(outRow * height);
+        extend16 = scratch.data();
+    }
+    const int shift = windowShift(bits, request->mode);
+
+    BandStats total;
+    std::mutex totalMutex;
+    const LuxCalibPass calib(width, height, bits);
+    const LuxDefectPass defects(width, height, bits);
+    const LuxDefectPass::RowSource unpack = [&](int64_t y, uint16_t *dst) {
+        LuxUnpackRow(imgData + y * inRow, dst, width, bpp, isBigEndian, mask);
+        if (calib.active()) calib.apply(y, dst, 0, width);
+    };
+
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        std::vector<uint16_t> row(width);
+        BandStats band;
+        LuxDefectPass::Scratch scratch;
+        for (int64_t y = lo; y < hi; ++y) {
+            uint16_t *v = row.data();
+            unpack(y, v);
+            if (defects.active())
+                defects.correctRow(y, v, 0, width, unpack, &scratch);
+            const uint64_t at = static_cast<uint64_t>(y) * outRow;
+
+            if (display8 && !normalize) {
+                unsigned char *dst = request->display8 + at;
+                for (int x = 0; x < width; ++x)
+                    dst[x] = static_cast<unsigned char>(v[x] >> shift);
+            }
+            if (extend16 != nullptr)
+                ::memcpy(extend16 + at, v, width * sizeof(uint16_t));
+            if (outputs & LUX_DECODE_STRETCH16) {
+                uint16_t *dst = request->stretch16 + at;
+                for (int x = 0; x < width; ++x)
+                    dst[x] = static_cast<uint16_t>(v[x] << stretchShift);
+            }
+            if (outputs & LUX_DECODE_PLANES) {
+                uint64_t planeAt = static_cast<uint64_t>(y / 2) * planeWidth;
+                uint16_t *even = request->planes[(y & 1) << 1] + planeAt;
+                uint16_t *odd = request->planes[((y & 1) << 1) | 1] + planeAt;
+                for (int x = 0; x < planeWidth; ++x) {
+                    even[x] = v[2 * x];
+                    odd[x] = v[2 * x + 1];
+                }
+            }
+            if (stats) {
+                int site = (y & 1) << 1;
+                for (int x = 0; x < width; ++x) {
+                    int s = site | (x & 1);
+                    band.siteMin[s] = std::min(band.siteMin[s], v[x]);
+                    band.siteMax[s] = std::max(band.siteMax[s], v[x]);
+                    band.siteSum[s] += v[x];
+                    ++band.histogram[v[x] >> histShift];
+                }
+                if (normalize)
+                    for (int x = 0; x < width; ++x)
+                        ++band.levels[v[x] >> levelShift];
+                band.siteCount[site] += (width + 1) / 2;
+                band.siteCount[site | 1] += width / 2;
+            }
+        }
+        if (stats) {
+            std::lock_guard<std::mutex> lock(totalMutex);
+            total.merge(band);
+        }
+    });
+
+    uint16_t max = 0;
+    for (auto m : total.siteMax) max = std::max(max, m);
+
+    if (normalize) {
+        LUX_TRACE_SCOPE("normalize");
+        auto lut = normalizeLut(mask, total.levels, levelShift, max);
+        LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+            for (int64_t y = lo; y < hi; ++y) {
+                unsigned char *dst = request->display8 + y * outRow;
+                const uint16_t *src = extend16 + y * outRow;
+                for (int x = 0; x < width; ++x) dst[x] = lut[src[x]];
+            }
+        });
+    }
+
+    if (outputs & LUX_DECODE_STATS) {
+        LuxDecodeStats *out = request->stats;
+        ::memset(out, 0, sizeof(*out));
+        out->significantBits = bits;
+        out->min = UINT16_MAX;
+        uint64_t sum = 0;
+        for (int s = 0; s < 4; ++s) {
+            if (total.siteCount[s] == 0) continue;
+            out->siteMin[s] = total.siteMin[s];
+            out->siteMax[s] = total.siteMax[s];
+            out->siteMean[s] =
+                static_cast<double>(total.siteSum[s]) / total.siteCount[s];
+            out->min = std::min(out->min, total.siteMin[s]);
+            sum += total.siteSum[s];
+        }
+        out->max = max;
+        out->mean = static_cast<double>(sum) / samples;
+        ::memcpy(out->histogram, total.histogram, sizeof(out->histogram));
+    }
+
+    if (request->tiffFileName != nullptr)
+        LuxWriterSubmit(request->stretch16, width, height, CV_16UC1,
+                        request->tiffFileName, false);
+
+    return static_cast<long long>(samples);
+}
+
+long long LuxDecodeModes(const unsigned char *imgData,
+                         unsigned long long length, int width, int height,
+                         int bpp, bool isBigEndian, bool highZero,
+                         unsigned int modeMask, unsigned char *const *outputs) {
+    return LuxDecodeModesStrided(imgData, length, width, height, bpp,
+                                 isBigEndian, highZero, nullptr, modeMask,
+                                 outputs);
+}
+
+long long LuxDecodeModesStrided(const unsigned char *imgData,
+                                unsigned long long length, int width,
+                                int height, int bpp, bool isBigEndian,
+                                bool highZero, const LuxFrameLayout *layout,
+                                unsigned int modeMask,
+                                unsigned char *const *outputs) {
+    LUX_TRACE_SCOPE("decode_modes");
+    int ret = LuxCheckFrameLayout(imgData, length, width, height, bpp, layout);
+    if (ret < 0) return ret;
+    const uint64_t inRow =
+        LuxLayoutInStride(layout, LuxPackedBytes(width, bpp));
+    const uint64_t outRow = LuxLayoutOutStride(layout, width);
+    if (layout != nullptr) imgData += layout->topLines * inRow;
+    modeMask &= LUX_DECODE_ALL_MODES;
+    bool buffersOk = modeMask != 0 && outputs != nullptr;
+    for (int m = 0; buffersOk && m < 6; ++m)
+        if ((modeMask & (1u << m)) && outputs[m] == nullptr) buffersOk = false;
+    if (!buffersOk) {
+        std::cerr << "Decode request is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -6;
+    }
+
+    const int bits = LuxSignificantBits(bpp, highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << bits) - 1);
+    const uint64_t samples = static_cast<uint64_t>(width) * height;
+    /// 8-bit samples are the same in every mode
+    const bool normalize = (modeMask & (1u << 5)) && bits > 8;
+
+    int shifts[6];
+    for (int m = 0; m < 6; ++m)
+        shifts[m] = windowShift(bits, m == 5 ? 0 : m);
+    std::vector<int> modes;
+    for (int m = 0; m < 6; ++m)
+        if ((modeMask & (1u << m)) && !(m == 5 && normalize))
+            modes.push_back(m);
+
+    /// Mode 5 needs the range: keep the samples, window them afterwards
+    std::vector<uint16_t> samples16(normalize ? samples : 0);
+    const int levelShift = std::max(0, bits - kLevelBits);
+    std::vector<uint32_t> levels(normalize ? 1 << kLevelBits : 0);
+    uint16_t max = 0;
+    std::mutex levelsMutex;
+    const LuxCalibPass calib(width, height, bits);
+    const LuxDefectPass defects(width, height, bits);
+    const LuxDefectPass::RowSource unpack = [&](int64_t y, uint16_t *dst) {
+        LuxUnpackRow(imgData + y * inRow, dst, width, bpp, isBigEndian, mask);
+        if (calib.active()) calib.apply(y, dst, 0, width);
+    };
+
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        std::vector<uint16_t> row(width);
+        std::vector<uint32_t> bandLevels(levels.size());
+        uint16_t bandMax = 0;
+        LuxDefectPass::Scratch scratch;
+        for (int64_t y = lo; y < hi; ++y) {
+            uint16_t *v = row.data();
+            unpack(y, v);
+            if (defects.active())
+                defects.correctRow(y, v, 0, width, unpack, &scratch);
+            const uint64_t at = static_cast<uint64_t>(y) * width;
+
+            for (int m : modes) {
+                unsigned char *dst = outputs[m] + y * outRow;
+                const int shift = shifts[m];
+                for (int x = 0; x < width; ++x)
+                    dst[x] = static_cast<unsigned char>(v[x] >> shift);
+            }
+            if (normalize) {
+                ::memcpy(samples16.data() + at, v, width * sizeof(uint16_t));
+                for (int x = 0; x < width; ++x) {
+                    bandMax = std::max(bandMax, v[x]);
+                    ++bandLevels[v[x] >> levelShift];
+                }
+            }
+        }
+        if (normalize) {
+            std::lock_guard<std::mutex> lock(levelsMutex);
+            max = std::max(max, bandMax);
+            for (size_t i = 0; i < levels.size(); ++i)
+                levels[i] += bandLevels[i];
+        }
+    });
+
+    if (normalize) {
+        LUX_TRACE_SCOPE("normalize");
+        auto lut = normalizeLut(mask, levels.data(), levelShift, max);
+        LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+            for (int64_t y = lo; y < hi; ++y) {
+                unsigned char *dst = outputs[5] + y * outRow;
+                const uint16_t *src = samples16.data() + y * width;
+                for (int x = 0; x < width; ++x) dst[x] = lut[src[x]];
+            }
+        });
+    }
+    return static_cast<long long>(samples);
+}
+
+uint64_t LuxFrameLayoutBytes(const LuxFrameLayout *layout, uint64_t rowBytes,
+                             int height) {
+    const uint64_t stride = LuxLayoutInStride(layout, rowBytes);
+    if (rowBytes == 0 || height <= 0 || stride == 0) return 0;
+    uint64_t lines = static_cast<uint64_t>(height);
+    if (layout != nullptr) {
+        if (layout->topLines < 0 || layout->bottomLines < 0) return 0;
+        lines += static_cast<uint64_t>(layout->topLines) + layout->bottomLines;
+    }
+    /// 0 rather than a wrapped size
+    return stride > UINT64_MAX / lines ? 0 : stride * lines;
+}
+
+long long LuxFrameCompact(const unsigned char *imgData,
+                          unsigned long long length, uint64_t rowBytes,
+                          int height, const LuxFrameLayout *layout,
+                          unsigned char *output) {
+    LUX_TRACE_SCOPE("frame_compact");
+    const uint64_t bytes = LuxFrameLayoutBytes(layout, rowBytes, height);
+    if (imgData == nullptr || output == nullptr || bytes == 0 ||
+        length != bytes) {
+        std::cerr << "The length does not match the frame layout!!!"
+                  << "\nlength: " << length << "\nexpected: " << bytes
+                  << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+    const uint64_t stride = LuxLayoutInStride(layout, rowBytes);
+    if (layout != nullptr) imgData += layout->topLines * stride;
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        for (int64_t y = lo; y < hi; ++y)
+            ::memcpy(output + y * rowBytes, imgData + y * stride, rowBytes);
+    });
+    return static_cast<long long>(rowBytes * height);
+}
+
+int LuxSetNormalizeConf(const LuxNormalizeConf *conf) {
+    if (conf == nullptr || conf->lowPercentile < 0 ||
+        conf->lowPercentile >= conf->highPercentile ||
+        conf->highPercentile > 100)
+        return -1;
+    std::lock_guard<std::mutex> lock(gNormalizeMutex);
+    gNormalize = *conf;
+    return 0;
+}
+
+void LuxGetNormalizeConf(LuxNormalizeConf *conf) {
+    if (conf != nullptr) *conf = normalizeConf();
+}
+
+long long LuxNormalizeTo8(const uint16_t *samples, unsigned long long count,
+                          int bits, unsigned char *output) {
+    LUX_TRACE_SCOPE("normalize");
+    if (samples == nullptr || output == nullptr || bits < 8 || bits > 16)
+        return -1;
+
+    const uint16_t mask = static_cast<uint16_t>((1u << bits) - 1);
+    const int levelShift = std::max(0, bits - kLevelBits);
+    const int64_t n = static_cast<int64_t>(count);
+    /// Samples of one parallel band, at least
+    const int64_t grain = kGrainRows * 4096;
+
+    std::vector<uint32_t> levels(1 << kLevelBits);
+    uint16_t max = 0;
+    std::mutex levelsMutex;
+    LuxParallelFor(0, n, grain, [&](int64_t lo, int64_t hi) {
+        std::vector<uint32_t> bandLevels(levels.size());
+        uint16_t bandMax = 0;
+        for (int64_t i = lo; i < hi; ++i) {
+            const uint16_t v = samples[i] & mask;
+            bandMax = std::max(bandMax, v);
+            ++bandLevels[v >> levelShift];
+        }
+        std::lock_guard<std::mutex> lock(levelsMutex);
+        max = std::max(max, bandMax);
+        for (size_t i = 0; i < levels.size(); ++i) levels[i] += bandLevels[i];
+    });
+
+    auto lut = normalizeLut(mask, levels.data(), levelShift, max);
+    LuxParallelFor(0, n, grain, [&](int64_t lo, int64_t hi) {
+        for (int64_t i = lo; i < hi; ++i) output[i] = lut[samples[i] & mask];
+    });
+    return static_cast<long long>(count);
+}
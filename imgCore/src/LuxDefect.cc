@@ -0,0 +1,249 @@
+/**
+ * @file LuxDefect.cc
+ */
+
+#include <imgCore/LuxDefect.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+/// Defects per row: the sorted columns of row y in
+/// xs[rowStart[y], rowStart[y + 1])
+struct LuxDefectMapData {
+    int width;
+    int height;
+    std::vector<uint32_t> rowStart;
+    std::vector<int> xs;
+};
+
+namespace {
+
+std::shared_ptr<const LuxDefectMapData> gMap;
+LuxDefectConf gConf{0, 0.25};
+std::mutex gMutex;
+
+/// Map of @c points, the columns of every row sorted and unique
+std::shared_ptr<const LuxDefectMapData> buildMap(
+    std::vector<std::pair<int, int>> &points, int width, int height) {
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+
+    auto map = std::make_shared<LuxDefectMapData>();
+    map->width = width;
+    map->height = height;
+    map->rowStart.assign(height + 1, 0);
+    map->xs.reserve(points.size());
+    for (auto &p : points) {
+        ++map->rowStart[p.first + 1];
+        map->xs.push_back(p.second);
+    }
+    for (int y = 0; y < height; ++y) map->rowStart[y + 1] += map->rowStart[y];
+    return map;
+}
+
+/// Replace the map, nullptr clears it
+int setMap(std::shared_ptr<const LuxDefectMapData> map) {
+    const int count = map != nullptr ? static_cast<int>(map->xs.size()) : 0;
+    std::lock_guard<std::mutex> lock(gMutex);
+    gMap = count > 0 ? std::move(map) : nullptr;
+    return count;
+}
+
+/// Median of @c n (at most 4) samples
+uint16_t median(uint16_t *m, int n) {
+    std::sort(m, m + n);
+    if (n % 2 == 1) return m[n / 2];
+    return static_cast<uint16_t>((m[n / 2 - 1] + m[n / 2] + 1u) / 2);
+}
+
+}  // namespace
+
+int LuxSetDefectMap(const int *xy, int count, int width, int height) {
+    if (width <= 0 || height <= 0 || count < 0 ||
+        (count > 0 && xy == nullptr)) {
+        std::cerr << "Defect map is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+
+    /// (y, x): sorted by row
+    std::vector<std::pair<int, int>> points;
+    points.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const int x = xy[2 * i], y = xy[2 * i + 1];
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            std::cerr << "Defect out of the frame: " << x << ", " << y
+                      << std::endl;
+            ::fflush(stderr);
+            return -1;
+        }
+        points.emplace_back(y, x);
+    }
+    return setMap(buildMap(points, width, height));
+}
+
+int LuxSetDefectBitmap(const unsigned char *bitmap, int width, int height) {
+    if (bitmap == nullptr || width <= 0 || height <= 0) {
+        std::cerr << "Defect map is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+    std::vector<std::pair<int, int>> points;
+    for (int y = 0; y < height; ++y) {
+        const unsigned char *row = bitmap + static_cast<uint64_t>(y) * width;
+        for (int x = 0; x < width; ++x)
+            if (row[x] != 0) points.emplace_back(y, x);
+    }
+    return setMap(buildMap(points, width, height));
+}
+
+int LuxLoadDefectMap(const char *fileName, int width, int height) {
+    std::ifstream fin(fileName, std::ios::binary);
+    if (!fin.is_open()) return -1;
+    std::string content((std::istreambuf_iterator<char>(fin)),
+                        std::istreambuf_iterator<char>());
+
+    int ret;
+    if (width > 0 && height > 0 &&
+        content.size() == static_cast<uint64_t>(width) * height &&
+        content.find('\0') != std::string::npos) {
+        ret = LuxSetDefectBitmap(
+            reinterpret_cast<const unsigned char *>(content.data()), width,
+            height);
+    } else {
+        std::vector<int> xy;
+        std::istringstream in(content);
+        std::string line;
+        bool ok = true;
+        while (ok && std::getline(in, line)) {
+            line = line.substr(0, line.find('#'));
+            std::replace(line.begin(), line.end(), ',', ' ');
+            std::istringstream fields(line);
+            int x, y;
+            if (fields >> x >> y)
+                xy.insert(xy.end(), {x, y});
+            else
+                ok = line.find_first_not_of(" \t\r") == std::string::npos;
+        }
+        ret = ok ? LuxSetDefectMap(xy.data(), static_cast<int>(xy.size() / 2),
+                                   width, height)
+                 : -1;
+    }
+    if (ret < 0) {
+        std::cerr << "Defect map file is wrong: " << fileName << std::endl;
+        ::fflush(stderr);
+        return -3;
+    }
+    return ret;
+}
+
+void LuxClearDefectMap() { setMap(nullptr); }
+
+int LuxGetDefectCount() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gMap != nullptr ? static_cast<int>(gMap->xs.size()) : 0;
+}
+
+int LuxSetDefectConf(const LuxDefectConf *conf) {
+    if (conf == nullptr || !(conf->threshold > 0 && conf->threshold <= 1))
+        return -1;
+    std::lock_guard<std::mutex> lock(gMutex);
+    gConf = *conf;
+    return 0;
+}
+
+void LuxGetDefectConf(LuxDefectConf *conf) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    *conf = gConf;
+}
+
+LuxDefectPass::LuxDefectPass(int width, int height, int bits)
+    : height_(height), threshold_(0) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gMap != nullptr && gMap->width == width && gMap->height == height)
+        map_ = gMap;
+    if (gConf.dynamic)
+        threshold_ = std::max<uint32_t>(
+            1, static_cast<uint32_t>(gConf.threshold * ((1u << bits) - 1)));
+}
+
+bool LuxDefectPass::isMapped(int64_t y, int x) const {
+    if (map_ == nullptr) return false;
+    auto first = map_->xs.begin() + map_->rowStart[y];
+    auto last = map_->xs.begin() + map_->rowStart[y + 1];
+    return std::binary_search(first, last, x);
+}
+
+void LuxDefectPass::correctRow(int64_t y, uint16_t *v, int x0, int count,
+                               const RowSource &unpack,
+                               Scratch *scratch) const {
+    auto &fixes = scratch->fixes;
+    fixes.clear();
+    if (map_ != nullptr) {
+        auto first = map_->xs.begin() + map_->rowStart[y];
+        auto last = map_->xs.begin() + map_->rowStart[y + 1];
+        first = std::lower_bound(first, last, x0);
+        last = std::lower_bound(first, last, x0 + count);
+        fixes.assign(first, last);
+    }
+    /// Candidates of the detector: out of both neighbours of the row
+    const size_t mapped = fixes.size();
+    for (int i = 2; threshold_ > 0 && i + 2 < count; ++i) {
+        const uint32_t c = v[i], a = v[i - 2], b = v[i + 2];
+        if (c > std::max(a, b) + threshold_ ||
+            c + threshold_ < std::min(a, b))
+            fixes.push_back(x0 + i);
+    }
+    if (fixes.empty()) return;
+
+    const uint16_t *above = nullptr, *below = nullptr;
+    if (y >= 2) {
+        scratch->above.resize(count);
+        unpack(y - 2, scratch->above.data());
+        above = scratch->above.data();
+    }
+    if (y + 2 < height_) {
+        scratch->below.resize(count);
+        unpack(y + 2, scratch->below.data());
+        below = scratch->below.data();
+    }
+
+    /// A thin vertical line passes the row test: the candidates must be out
+    /// of the rows above and below as well
+    auto outOf = [&](uint32_t c, const uint16_t *row, int i) {
+        return row == nullptr || c > row[i] + threshold_ ||
+               c + threshold_ < row[i];
+    };
+    auto kept = fixes.begin() + mapped;
+    for (auto it = kept; it != fixes.end(); ++it) {
+        const int i = *it - x0;
+        if (outOf(v[i], above, i) && outOf(v[i], below, i) &&
+            !isMapped(y, *it))
+            *kept++ = *it;
+    }
+    fixes.erase(kept, fixes.end());
+    std::sort(fixes.begin(), fixes.end());
+
+    /// From the samples as unpacked, then written
+    auto &values = scratch->values;
+    values.resize(fixes.size());
+    for (size_t k = 0; k < fixes.size(); ++k) {
+        const int x = fixes[k], i = x - x0;
+        uint16_t m[4];
+        int n = 0;
+        for (int dx : {-2, 2})
+            if (i + dx >= 0 && i + dx < count &&
+                !std::binary_search(fixes.begin(), fixes.end(), x + dx))
+                m[n++] = v[i + dx];
+        if (above != nullptr && !isMapped(y - 2, x)) m[n++] = above[i];
+        if (below != nullptr && !isMapped(y + 2, x)) m[n++] = below[i];
+        values[k] = n > 0 ? median(m, n) : v[i];
+    }
+    for (size_t k = 0; k < fixes.size(); ++k) v[fixes[k] - x0] = values[k];
+}
@@ -0,0 +1,222 @@
+/**
+ * @file LuxDiff.cc
+ */
+
+#include <imgCore/LuxDiff.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LUX_HAVE_SSE2 1
+#endif
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+
+/// The statistics of some rows
+struct DiffStats {
+    int maxPos = 0;  ///< Largest a - b
+    int maxNeg = 0;  ///< Largest b - a
+    uint64_t differing = 0;
+    uint64_t over = 0;
+    uint64_t sumAbs = 0;
+
+    void merge(const DiffStats &o) {
+        maxPos = std::max(maxPos, o.maxPos);
+        maxNeg = std::max(maxNeg, o.maxNeg);
+        differing += o.differing;
+        over += o.over;
+        sumAbs += o.sumAbs;
+    }
+};
+
+/// a - b of a row into @c pos (a > b) and @c neg (a < b), one of them 0 per
+/// sample, added to @c stats
+void diffRow(const uint16_t *a, const uint16_t *b, int count, int threshold,
+             uint16_t *pos, uint16_t *neg, DiffStats *stats) {
+    int x = 0;
+#ifdef LUX_HAVE_SSE2
+    /// Unsigned compares through the signed ones, the samples biased by
+    /// 0x8000; the 16-bit counters get one per step and are flushed every
+    /// 16K steps, as are the 32-bit sums (2 x 65535 per step and lane)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+    const __m128i limit =
+        _mm_set1_epi16(static_cast<int16_t>(threshold ^ 0x8000));
+    __m128i maxPos = bias, maxNeg = bias;
+    while (x + 8 <= count) {
+        __m128i equal = zero, over = zero, sum = zero;
+        const int start = x;
+        const int end = std::min(count, x + 8 * (1 << 14));
+        for (; x + 8 <= end; x += 8) {
+            __m128i va =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + x));
+            __m128i vb =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + x));
+            __m128i p = _mm_subs_epu16(va, vb);
+            __m128i n = _mm_subs_epu16(vb, va);
+            __m128i d = _mm_or_si128(p, n);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(pos + x), p);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(neg + x), n);
+            maxPos = _mm_max_epi16(maxPos, _mm_xor_si128(p, bias));
+            maxNeg = _mm_max_epi16(maxNeg, _mm_xor_si128(n, bias));
+            equal = _mm_sub_epi16(equal, _mm_cmpeq_epi16(d, zero));
+            over = _mm_sub_epi16(
+                over, _mm_cmpgt_epi16(_mm_xor_si128(d, bias), limit));
+            sum = _mm_add_epi32(sum,
+                                _mm_add_epi32(_mm_unpacklo_epi16(d, zero),
+                                              _mm_unpackhi_epi16(d, zero)));
+        }
+        uint16_t equals[8], overs[8];
+        uint32_t sums[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(equals), equal);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(overs), over);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), sum);
+        uint64_t equalCount = 0;
+        for (int i = 0; i < 8; ++i) {
+            equalCount += equals[i];
+            stats->over += overs[i];
+        }
+        for (int i = 0; i < 4; ++i) stats->sumAbs += sums[i];
+        stats->differing += (x - start) - equalCount;
+    }
+    int16_t lanes[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), maxPos);
+    for (int16_t l : lanes)
+        stats->maxPos = std::max(stats->maxPos, (l ^ 0x8000) & 0xFFFF);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), maxNeg);
+    for (int16_t l : lanes)
+        stats->maxNeg = std::max(stats->maxNeg, (l ^ 0x8000) & 0xFFFF);
+#endif
+    for (; x < count; ++x) {
+        const int d = static_cast<int>(a[x]) - b[x];
+        pos[x] = static_cast<uint16_t>(d > 0 ? d : 0);
+        neg[x] = static_cast<uint16_t>(d < 0 ? -d : 0);
+        stats->maxPos = std::max(stats->maxPos, d);
+        stats->maxNeg = std::max(stats->maxNeg, -d);
+        stats->differing += d != 0;
+        stats->over += std::abs(d) > threshold;
+        stats->sumAbs += std::abs(d);
+    }
+}
+
+/// The color of @c s in [0, 1] on a ramp of @c stops channels, e.g. 3:
+/// red, then green, then blue rise one after the other
+uint8_t ramp(double s, int stops, int channel) {
+    const double v = std::min(1.0, std::max(0.0, stops * s - channel));
+    return static_cast<uint8_t>(std::lround(v * 255));
+}
+
+/// RGB of every difference, index d + offset
+std::vector<uint8_t> heatmapLut(int mode, int mask, int range) {
+    const int offset = mode == LUX_DIFF_SIGNED ? mask : 0;
+    std::vector<uint8_t> lut(3 * static_cast<size_t>(offset + mask + 1), 0);
+    const double scale = 1.0 / range;
+    for (int d = -offset; d <= mask; ++d) {
+        if (d == 0) continue;
+        /// The smallest difference stays visible
+        const double s = 0.1 + 0.9 * std::min(1.0, std::abs(d) * scale);
+        uint8_t *rgb = &lut[3 * static_cast<size_t>(d + offset)];
+        if (mode == LUX_DIFF_ABS) {
+            for (int c = 0; c < 3; ++c) rgb[c] = ramp(s, 3, c);
+        } else {
+            /// a > b: red, then green; a < b: blue, then green
+            rgb[d > 0 ? 0 : 2] = ramp(s, 2, 0);
+            rgb[1] = ramp(s, 2, 1);
+        }
+    }
+    return lut;
+}
+
+}  // namespace
+
+long long LuxComputeDiff(const unsigned char *frameA,
+                         const unsigned char *frameB, unsigned long long length,
+                         int width, int height, int bpp, bool isBigEndian,
+                         bool highZero, int mode, int threshold, int range,
+                         unsigned char *heatmap, LuxDiffResult *result) {
+    if (mode != LUX_DIFF_ABS && mode != LUX_DIFF_SIGNED) {
+        std::cerr << "Difference mode " << mode << " Don't Supported!!!"
+                  << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+    int ret = LuxCheckFrame(frameA, length, width, height, bpp);
+    if (ret < 0) return ret;
+    ret = LuxCheckFrame(frameB, length, width, height, bpp);
+    if (ret < 0) return ret;
+    LUX_TRACE_SCOPE("diff");
+
+    const int bits = LuxSignificantBits(bpp, highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << bits) - 1);
+    const uint64_t inRow = LuxPackedBytes(width, bpp);
+    threshold = std::min(std::max(threshold, 0), 0xFFFF);
+
+    /// The heatmap if @c lut, the statistics if @c collect
+    DiffStats total;
+    std::mutex mutex;
+    auto pass = [&](const uint8_t *lut, bool collect) {
+        LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+            std::vector<uint16_t> rows(4 * static_cast<size_t>(width));
+            uint16_t *a = rows.data(), *b = a + width;
+            uint16_t *pos = b + width, *neg = pos + width;
+            DiffStats stats;
+            for (int64_t y = lo; y < hi; ++y) {
+                LuxUnpackRow(frameA + y * inRow, a, width, bpp, isBigEndian,
+                             mask);
+                LuxUnpackRow(frameB + y * inRow, b, width, bpp, isBigEndian,
+                             mask);
+                diffRow(a, b, width, threshold, pos, neg, &stats);
+                if (lut == nullptr) continue;
+
+                uint8_t *out = heatmap + y * width * 3;
+                const int offset = mode == LUX_DIFF_SIGNED ? mask : 0;
+                for (int x = 0; x < width; ++x) {
+                    const int d = mode == LUX_DIFF_SIGNED
+                                      ? offset + pos[x] - neg[x]
+                                      : pos[x] + neg[x];
+                    ::memcpy(out + 3 * x, lut + 3 * d, 3);
+                }
+            }
+            if (!collect) return;
+            std::lock_guard<std::mutex> lock(mutex);
+            total.merge(stats);
+        });
+    };
+    if (heatmap != nullptr && range > 0) {
+        pass(heatmapLut(mode, mask, range).data(), true);
+    } else {
+        /// The range is known once every row is seen
+        pass(nullptr, true);
+        if (range <= 0)
+            range = std::max(1, std::max(total.maxPos, total.maxNeg));
+        if (heatmap != nullptr)
+            pass(heatmapLut(mode, mask, range).data(), false);
+    }
+
+    if (result != nullptr) {
+        const uint64_t samples = static_cast<uint64_t>(width) * height;
+        result->width = width;
+        result->height = height;
+        result->maxAbs = std::max(total.maxPos, total.maxNeg);
+        result->minSigned = -total.maxNeg;
+        result->maxSigned = total.maxPos;
+        result->meanAbs = static_cast<double>(total.sumAbs) / samples;
+        result->differing = total.differing;
+        result->overThreshold = total.over;
+        result->range = range;
+    }
+    return static_cast<long long>(width) * height;
+}
@@ -0,0 +1,323 @@
+/**
+ * @file LuxPacking.cc
+ */
+
+#include <imgCore/LuxPacking.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+
+/// Bytes of a group
+inline int groupBytes(const LuxPackingDesc *d) {
+    return d->group * d->containerBits / 8;
+}
+
+/// The bpp of @c d, whatever its line padding: the kernels work on rows
+bool knownLayout(const LuxPackingDesc *d, int *bpp, bool *bigEndian,
+                 bool *highZero) {
+    *bigEndian = d->byteOrder == LUX_BYTES_BIG;
+    *highZero = false;
+    if (d->bitOrder == LUX_BITS_MIPI) {
+        *bpp = LUX_BPP_MIPI | d->bits;
+        return LuxPackingGroup(*bpp) == d->group;
+    }
+    if (d->bits == 8 && d->containerBits == 8 && d->group == 1) {
+        *bpp = 8;
+        return true;
+    }
+    /// AAAAAAAA AAAABBBB BBBBBBBB
+    if (d->bits == 12 && d->containerBits == 12 && d->group == 2 &&
+        d->byteOrder == LUX_BYTES_BIG && d->bitOrder == LUX_BITS_MSB_FIRST) {
+        *bpp = 12;
+        return true;
+    }
+    if (d->containerBits == 16 && d->group == 1 &&
+        (d->bits == 16 || (d->bits == 12 && d->padPosition == LUX_PAD_HIGH))) {
+        *bpp = 16;
+        *highZero = d->bits == 12;
+        return true;
+    }
+    return false;
+}
+
+/// Generic unpacker: one word per group, a constant shift per sample
+class GroupUnpacker {
+public:
+    explicit GroupUnpacker(const LuxPackingDesc *d)
+        : d_(*d),
+          bytes_(d->bitOrder == LUX_BITS_MIPI ? d->group * d->bits / 8
+                                              : groupBytes(d)),
+          mask_((1u << d->bits) - 1),
+          containerMask_((1ull << d->containerBits) - 1),
+          padShift_(d->padPosition == LUX_PAD_LOW
+                        ? d->containerBits - d->bits
+                        : 0) {
+        for (int k = 0; k < d->group; ++k) {
+            if (d->bitOrder == LUX_BITS_MIPI)
+                shifts_.push_back((d->bits - 8) * k);
+            else if (d->bitOrder == LUX_BITS_MSB_FIRST)
+                shifts_.push_back(bytes_ * 8 - d->containerBits * (k + 1));
+            else
+                shifts_.push_back(d->containerBits * k);
+        }
+    }
+
+    void row(const uint8_t *src, uint16_t *dst, int width) const {
+        const int n = d_.group;
+        if (d_.bitOrder == LUX_BITS_MIPI) {
+            const int lowBits = d_.bits - 8;
+            const uint32_t lowMask = (1u << lowBits) - 1;
+            for (int x = 0; x < width; x += n, src += bytes_) {
+                const uint64_t low = word(src + n, bytes_ - n, false);
+                for (int k = 0; k < n; ++k)
+                    dst[x + k] = static_cast<uint16_t>(
+                        (src[k] << lowBits) |
+                        ((low >> shifts_[k]) & lowMask));
+            }
+            return;
+        }
+        const bool big = d_.byteOrder == LUX_BYTES_BIG;
+        for (int x = 0; x < width; x += n, src += bytes_) {
+            const uint64_t w = word(src, bytes_, big);
+            for (int k = 0; k < n; ++k)
+                dst[x + k] = static_cast<uint16_t>(
+                    (((w >> shifts_[k]) & containerMask_) >> padShift_) &
+                    mask_);
+        }
+    }
+
+private:
+    static uint64_t word(const uint8_t *p, int bytes, bool big) {
+        uint64_t w = 0;
+        if (big)
+            for (int i = 0; i < bytes; ++i) w = (w << 8) | p[i];
+        else
+            for (int i = 0; i < bytes; ++i)
+                w |= static_cast<uint64_t>(p[i]) << (8 * i);
+        return w;
+    }
+
+    LuxPackingDesc d_;
+    int bytes_;
+    uint32_t mask_;
+    uint64_t containerMask_;
+    int padShift_;
+    std::vector<int> shifts_;
+};
+
+/// Smallest group of @c bits samples filling whole bytes
+int defaultGroup(int bits) {
+    int group = 1;
+    while (group * bits % 8 != 0) ++group;
+    return group;
+}
+
+bool parseEnum(const std::string &value, const char *const *names, int count,
+               int *out) {
+    for (int i = 0; i < count; ++i) {
+        if (value == names[i]) {
+            *out = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *const kByteOrders[] = {"big", "little"};
+const char *const kBitOrders[] = {"msb", "lsb", "mipi"};
+const char *const kPads[] = {"high", "low"};
+
+}  // namespace
+
+int LuxPackingValid(const LuxPackingDesc *d) {
+    if (d == nullptr || d->bits < 1 || d->bits > 16 ||
+        d->containerBits < d->bits || d->containerBits > 16 || d->group < 1 ||
+        d->byteOrder < LUX_BYTES_BIG || d->byteOrder > LUX_BYTES_LITTLE ||
+        d->bitOrder < LUX_BITS_MSB_FIRST || d->bitOrder > LUX_BITS_MIPI ||
+        d->padPosition < LUX_PAD_HIGH || d->padPosition > LUX_PAD_LOW ||
+        d->linePadding < 0)
+        return 0;
+    if (d->bitOrder == LUX_BITS_MIPI)
+        /// The low bits of the group in at most one 64-bit word
+        return d->bits > 8 && d->containerBits == d->bits &&
+               d->group * d->bits % 8 == 0 && d->group * (d->bits - 8) <= 64;
+    return d->group * d->containerBits % 8 == 0 &&
+           d->group * d->containerBits <= 64;
+}
+
+int LuxPackingParse(const char *text, LuxPackingDesc *desc) {
+    if (text == nullptr || desc == nullptr) return -1;
+
+    LuxPackingDesc d{0, 0, 0, LUX_BYTES_BIG, LUX_BITS_MSB_FIRST, LUX_PAD_HIGH,
+                     0};
+    std::string spec(text);
+    for (auto &c : spec)
+        if (c == ';' || c == ',' || c == '\n' || c == '\r' || c == '\t')
+            c = ' ';
+
+    std::istringstream in(spec);
+    std::string item;
+    while (in >> item) {
+        auto eq = item.find('=');
+        std::string key = item.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+        bool ok = true;
+        try {
+            if (value.empty())
+                ok = false;
+            else if (key == "bits")
+                d.bits = std::stoi(value);
+            else if (key == "container")
+                d.containerBits = std::stoi(value);
+            else if (key == "group")
+                d.group = std::stoi(value);
+            else if (key == "linePadding")
+                d.linePadding = std::stoi(value);
+            else if (key == "byteOrder")
+                ok = parseEnum(value, kByteOrders, 2, &d.byteOrder);
+            else if (key == "bitOrder")
+                ok = parseEnum(value, kBitOrders, 3, &d.bitOrder);
+            else if (key == "pad")
+                ok = parseEnum(value, kPads, 2, &d.padPosition);
+            else
+                ok = false;
+        } catch (const std::exception &) {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Packing descriptor is wrong: " << item << std::endl;
+            ::fflush(stderr);
+            return -1;
+        }
+    }
+
+    if (d.containerBits == 0) d.containerBits = d.bits;
+    if (d.group == 0)
+        d.group = defaultGroup(d.bitOrder == LUX_BITS_MIPI ? d.bits
+                                                           : d.containerBits);
+    if (!LuxPackingValid(&d)) {
+        std::cerr << "Packing descriptor is wrong: " << text << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+    *desc = d;
+    return 0;
+}
+
+int LuxPackingLoad(const char *fileName, LuxPackingDesc *desc) {
+    std::ifstream fin(fileName);
+    if (!fin.is_open()) return -1;
+
+    /// Without sections the whole file, otherwise the [packing] section
+    std::string spec, line, section;
+    while (std::getline(fin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+        if (line[0] == '[') {
+            section = line;
+            continue;
+        }
+        if (section.empty() || section == "[packing]") spec += line + "\n";
+    }
+    if (spec.find('=') == std::string::npos) return -2;
+    return LuxPackingParse(spec.c_str(), desc) == 0 ? 0 : -3;
+}
+
+int LuxPackingFormat(const LuxPackingDesc *desc, char *text, int size) {
+    if (!LuxPackingValid(desc) || text == nullptr) return -1;
+    int n = ::snprintf(text, size,
+                       "bits=%d;container=%d;group=%d;byteOrder=%s;"
+                       "bitOrder=%s;pad=%s;linePadding=%d",
+                       desc->bits, desc->containerBits, desc->group,
+                       kByteOrders[desc->byteOrder],
+                       kBitOrders[desc->bitOrder], kPads[desc->padPosition],
+                       desc->linePadding);
+    return n < size ? n : -1;
+}
+
+int LuxPackingToBpp(const LuxPackingDesc *desc, int *bpp, bool *isBigEndian,
+                    bool *highZero) {
+    if (!LuxPackingValid(desc) || desc->linePadding != 0) return -1;
+    int b;
+    bool big, zero;
+    if (!knownLayout(desc, &b, &big, &zero)) return -1;
+    if (bpp != nullptr) *bpp = b;
+    if (isBigEndian != nullptr) *isBigEndian = big;
+    if (highZero != nullptr) *highZero = zero;
+    return 0;
+}
+
+uint64_t LuxPackingRowBytes(const LuxPackingDesc *desc, uint64_t samples) {
+    if (!LuxPackingValid(desc) || samples % desc->group != 0) return 0;
+    const uint64_t bytes =
+        desc->bitOrder == LUX_BITS_MIPI ? desc->group * desc->bits / 8
+                                        : groupBytes(desc);
+    return samples / desc->group * bytes + desc->linePadding;
+}
+
+long long LuxPackingUnpack(const LuxPackingDesc *desc,
+                           const unsigned char *imgData,
+                           unsigned long long length, int width, int height,
+                           unsigned int flags, uint16_t *out) {
+    LUX_TRACE_SCOPE("packing_unpack");
+    if (!LuxPackingValid(desc)) {
+        std::cerr << "Packing descriptor is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -1;
+    }
+    const uint64_t inRow = width > 0 ? LuxPackingRowBytes(desc, width) : 0;
+    if (imgData == nullptr || out == nullptr || inRow == 0 || height <= 0 ||
+        length != inRow * height) {
+        std::cerr << "width or height or length are wrong!!!"
+                  << "\nlength: " << length << "\nwidth: " << width
+                  << "\nheight: " << height << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+
+    int bpp;
+    bool bigEndian, highZero;
+    const bool known = knownLayout(desc, &bpp, &bigEndian, &highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << desc->bits) - 1);
+    const GroupUnpacker generic(desc);
+    const int stretchShift = flags & LUX_UNPACK_STRETCH16 ? 16 - desc->bits
+                                                          : 0;
+    const bool storeBig = (flags & LUX_UNPACK_BIG_ENDIAN) != 0;
+
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        for (int64_t y = lo; y < hi; ++y) {
+            uint16_t *dst = out + y * width;
+            const uint8_t *src = imgData + y * inRow;
+            if (known)
+                LuxUnpackRow(src, dst, width, bpp, bigEndian, mask);
+            else
+                generic.row(src, dst, width);
+
+            if (stretchShift == 0 && !storeBig) continue;
+            auto *bytes = reinterpret_cast<uint8_t *>(dst);
+            for (int x = 0; x < width; ++x) {
+                const auto v = static_cast<uint16_t>(dst[x] << stretchShift);
+                if (storeBig) {
+                    bytes[2 * x] = static_cast<uint8_t>(v >> 8);
+                    bytes[2 * x + 1] = static_cast<uint8_t>(v & 0xFF);
+                } else {
+                    dst[x] = v;
+                }
+            }
+        }
+    });
+    return static_cast<long long>(width) * height;
+}
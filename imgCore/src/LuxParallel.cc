@@ -0,0 +1,275 @@
+/**
+ * @file LuxParallel.cc
+ */
+
+#include <imgCore/LuxParallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <thread>
+
+#if __has_include(<opencv2/core/parallel/parallel_backend.hpp>)
+#include <opencv2/core/parallel/parallel_backend.hpp>
+#define LUX_OPENCV_BACKEND 1
+#endif
+
+namespace {
+
+/// Workers at most, the calling thread aside
+constexpr int kMaxWorkers = 255;
+constexpr int kPriorities = 2;
+/// Bands per thread of a call, for the stealing to even out the load
+constexpr int64_t kBandsPerThread = 4;
+
+thread_local int tlsWorker = -1;
+thread_local int tlsPriority = LUX_PRIORITY_INTERACTIVE;
+
+/// One LuxParallelFor() call, on the stack of its caller
+struct Job {
+    const std::function<void(int64_t, int64_t)> *body;
+    int priority;
+    std::mutex mutex;
+    std::condition_variable done;
+    /// Bands not finished, decremented under @c mutex
+    std::atomic<int64_t> pending{0};
+    std::exception_ptr error;
+};
+
+struct Task {
+    Job *job;
+    int64_t begin;
+    int64_t end;
+};
+
+class Pool {
+public:
+    /// Never destroyed: the workers may still be parked at exit
+    static Pool &instance() {
+        static Pool *pool = new Pool();
+        return *pool;
+    }
+
+    int setThreads(int threads) {
+        if (threads <= 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        const int workers = std::min(threads - 1, kMaxWorkers);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int index = spawned_; index < workers; ++index)
+            std::thread([this, index]() { loop(index); }).detach();
+        spawned_ = std::max<int>(spawned_, workers);
+        active_ = workers;
+        wake_.notify_all();
+        return workers + 1;
+    }
+
+    int threads() const { return active_ + 1; }
+
+    void run(int64_t begin, int64_t end, int64_t grain,
+             const std::function<void(int64_t, int64_t)> &body) {
+        const int64_t total = end - begin;
+        const int64_t bands = std::min((total + grain - 1) / grain,
+                                       kBandsPerThread * threads());
+        if (bands <= 1 || active_ == 0) {
+            body(begin, end);
+            return;
+        }
+
+        Job job;
+        job.body = &body;
+        job.priority = tlsPriority;
+        job.pending = bands;
+
+        const int64_t band = (total + bands - 1) / bands;
+        {
+            std::lock_guard<std::mutex> lock(ownMutex());
+            /// Stolen from the front: the first bands go first
+            for (int64_t lo = begin; lo < end; lo += band)
+                ownQueue(job.priority)
+                    .push_back({&job, lo, std::min(lo + band, end)});
+        }
+        queued_ += bands;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        wake_.notify_all();
+
+        /// Help with the bands of this call only, the others could keep the
+        /// caller long after its own work is done
+        Task task;
+        while (job.pending > 0 && takeOwn(&job, &task)) execute(task);
+
+        std::unique_lock<std::mutex> lock(job.mutex);
+        job.done.wait(lock, [&job]() { return job.pending == 0; });
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+    /// 1 + the index of the worker running the calling thread, 0 elsewhere
+    static int threadIndex() { return tlsWorker + 1; }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks[kPriorities];
+    };
+
+    /// Sized to the cores until LuxSetNumThreads()
+    Pool() { setThreads(0); }
+
+    /// Where the calls of the calling thread queue their bands: the deque
+    /// of its worker, the shared queue for the other threads
+    std::mutex &ownMutex() {
+        return tlsWorker >= 0 ? workers_[tlsWorker].mutex : sharedMutex_;
+    }
+    std::deque<Task> &ownQueue(int priority) {
+        return tlsWorker >= 0 ? workers_[tlsWorker].tasks[priority]
+                              : shared_[priority];
+    }
+
+    /// A band of @c job from where its caller queued it, the last first
+    bool takeOwn(Job *job, Task *task) {
+        std::lock_guard<std::mutex> lock(ownMutex());
+        auto &queue = ownQueue(job->priority);
+        for (auto it = queue.rbegin(); it != queue.rend(); ++it) {
+            if (it->job != job) continue;
+            *task = *it;
+            queue.erase(std::next(it).base());
+            --queued_;
+            return true;
+        }
+        return false;
+    }
+
+    static bool takeFront(std::mutex &mutex, std::deque<Task> &queue,
+                          Task *task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) return false;
+        *task = queue.front();
+        queue.pop_front();
+        return true;
+    }
+
+    /// Any band, the interactive ones first: the shared queue, then stolen
+    /// from the other workers
+    bool take(int self, Task *task) {
+        const int spawned = spawned_;
+        for (int p = 0; p < kPriorities; ++p) {
+            bool found = takeFront(sharedMutex_, shared_[p], task);
+            for (int i = 1; !found && i <= spawned; ++i) {
+                Worker &victim = workers_[(self + i) % spawned];
+                found = takeFront(victim.mutex, victim.tasks[p], task);
+            }
+            if (found) {
+                --queued_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(const Task &task) {
+        Job *job = task.job;
+        const int saved = tlsPriority;
+        tlsPriority = job->priority;
+        try {
+            (*job->body)(task.begin, task.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            if (!job->error) job->error = std::current_exception();
+        }
+        tlsPriority = saved;
+
+        /// The caller returns (and @c job goes) once it can lock the mutex
+        std::lock_guard<std::mutex> lock(job->mutex);
+        if (--job->pending == 0) job->done.notify_all();
+    }
+
+    void loop(int index) {
+        tlsWorker = index;
+        Task task;
+        for (;;) {
+            if (index < active_ && take(index, &task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock,
+                       [&]() { return index < active_ && queued_ > 0; });
+        }
+    }
+
+    /// Guards the start and the sleep of the workers
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    /// Workers started, parked or not: their deques can be stolen from
+    std::atomic<int> spawned_{0};
+    /// Workers taking bands, the others stay parked
+    std::atomic<int> active_{0};
+    /// Bands in the queues
+    std::atomic<int64_t> queued_{0};
+
+    std::mutex sharedMutex_;
+    std::deque<Task> shared_[kPriorities];
+    Worker workers_[kMaxWorkers];
+};
+
+#ifdef LUX_OPENCV_BACKEND
+/// The OpenCV kernels run in the pool, not in a second set of threads
+class OpenCVBackend : public cv::parallel::ParallelForAPI {
+public:
+    void parallel_for(int tasks, FN_parallel_for_body_cb_t body,
+                      void *data) override {
+        LuxParallelFor(0, tasks, 1, [body, data](int64_t lo, int64_t hi) {
+            body(static_cast<int>(lo), static_cast<int>(hi), data);
+        });
+    }
+    int getThreadNum() const override { return Pool::threadIndex(); }
+    int getNumThreads() const override { return LuxGetNumThreads(); }
+    int setNumThreads(int threads) override {
+        return LuxSetNumThreads(threads);
+    }
+    const char *getName() const override { return "ziwi"; }
+};
+#endif
+
+/// Installed when the library is loaded, before the first OpenCV call
+const bool kOpenCVAttached = []() {
+#ifdef LUX_OPENCV_BACKEND
+    cv::parallel::setParallelForBackend(std::make_shared<OpenCVBackend>(),
+                                        false);
+#endif
+    return true;
+}();
+
+}  // namespace
+
+void LuxParallelFor(int64_t begin, int64_t end, int64_t grain,
+                    const std::function<void(int64_t, int64_t)> &body) {
+    if (end <= begin) return;
+    if (grain < 1) grain = 1;
+    Pool::instance().run(begin, end, grain, body);
+}
+
+int LuxSetNumThreads(int threads) {
+    const int n = Pool::instance().setThreads(threads);
+#ifndef LUX_OPENCV_BACKEND
+    /// Older OpenCV keeps its own threads, sized alike
+    cv::setNumThreads(n);
+#endif
+    return n;
+}
+
+int LuxGetNumThreads() { return Pool::instance().threads(); }
+
+void LuxSetTaskPriority(int priority) {
+    tlsPriority = priority == LUX_PRIORITY_BACKGROUND
+                      ? LUX_PRIORITY_BACKGROUND
+                      : LUX_PRIORITY_INTERACTIVE;
+}
+
+int LuxGetTaskPriority() { return tlsPriority; }
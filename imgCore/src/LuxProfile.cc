@@ -0,0 +1,253 @@
+/**
+ * @file LuxProfile.cc
+ */
+
+#include <imgCore/LuxCalib.h>
+#include <imgCore/LuxDefect.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxProfile.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LUX_HAVE_SSE2 1
+#endif
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+/// Rows summed into the column sums of a band before they are merged: the
+/// 32-bit sums do not overflow, the float ones keep their precision
+constexpr int kFlushRows = 256;
+
+/// Add the samples of a row to @c columns, its even and odd samples to
+/// @c sums
+void addRow(const uint16_t *v, uint32_t *columns, int count,
+            double sums[2]) {
+    int x = 0;
+    uint64_t even = 0, odd = 0;
+#ifdef LUX_HAVE_SSE2
+    /// Lanes 0, 2 sum even samples, 1, 3 odd ones, 2 samples a step: 16K
+    /// steps of 65535 at most fit in 32 bits
+    const __m128i zero = _mm_setzero_si128();
+    while (x + 8 <= count) {
+        __m128i acc = zero;
+        const int end = std::min(count, x + 8 * (1 << 14));
+        for (; x + 8 <= end; x += 8) {
+            __m128i in =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x));
+            __m128i lo = _mm_unpacklo_epi16(in, zero);
+            __m128i hi = _mm_unpackhi_epi16(in, zero);
+            __m128i *c = reinterpret_cast<__m128i *>(columns + x);
+            _mm_storeu_si128(c, _mm_add_epi32(_mm_loadu_si128(c), lo));
+            _mm_storeu_si128(c + 1,
+                             _mm_add_epi32(_mm_loadu_si128(c + 1), hi));
+            acc = _mm_add_epi32(acc, _mm_add_epi32(lo, hi));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        even += static_cast<uint64_t>(lanes[0]) + lanes[2];
+        odd += static_cast<uint64_t>(lanes[1]) + lanes[3];
+    }
+#endif
+    for (; x < count; ++x) {
+        columns[x] += v[x];
+        (x & 1 ? odd : even) += v[x];
+    }
+    sums[0] = static_cast<double>(even);
+    sums[1] = static_cast<double>(odd);
+}
+
+/// addRow() of float samples
+void addRow(const float *v, float *columns, int count, double sums[2]) {
+    int x = 0;
+    double even = 0, odd = 0;
+#ifdef LUX_HAVE_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (; x + 4 <= count; x += 4) {
+        __m128 in = _mm_loadu_ps(v + x);
+        _mm_storeu_ps(columns + x, _mm_add_ps(_mm_loadu_ps(columns + x), in));
+        acc = _mm_add_ps(acc, in);
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    even = static_cast<double>(lanes[0]) + lanes[2];
+    odd = static_cast<double>(lanes[1]) + lanes[3];
+#endif
+    for (; x < count; ++x) {
+        columns[x] += v[x];
+        (x & 1 ? odd : even) += v[x];
+    }
+    sums[0] = even;
+    sums[1] = odd;
+}
+
+/// The column sums of the rows of each parity, merged from the bands
+struct ColumnTotals {
+    std::vector<double> sums[2];
+    std::mutex mutex;
+
+    explicit ColumnTotals(int width) {
+        for (auto &s : sums) s.assign(width, 0);
+    }
+
+    /// Add the sums of a band and clear them
+    template <typename T>
+    void merge(std::vector<T> band[2]) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int r = 0; r < 2; ++r) {
+            for (size_t x = 0; x < band[r].size(); ++x)
+                sums[r][x] += band[r][x];
+            std::fill(band[r].begin(), band[r].end(), 0);
+        }
+    }
+};
+
+/// Profiles of the frame whose row @c y is @c rowOf(y, scratch), the
+/// scratch of a band from @c newScratch()
+template <typename Sample, typename Sum, typename RowOf, typename NewScratch>
+void project(int width, int height, const RowOf &rowOf,
+             const NewScratch &newScratch, float *rowMeans,
+             ColumnTotals *totals) {
+    const double perRow[2] = {static_cast<double>((width + 1) / 2),
+                              static_cast<double>(width / 2)};
+    LuxParallelFor(0, height, kGrainRows, [&](int64_t lo, int64_t hi) {
+        auto scratch = newScratch();
+        std::vector<Sum> band[2] = {std::vector<Sum>(width, 0),
+                                    std::vector<Sum>(width, 0)};
+        for (int64_t y = lo; y < hi; ++y) {
+            const Sample *v = rowOf(y, scratch);
+            double sums[2];
+            addRow(v, band[y & 1].data(), width, sums);
+            for (int k = 0; k < 2; ++k)
+                rowMeans[2 * y + k] =
+                    perRow[k] > 0 ? static_cast<float>(sums[k] / perRow[k])
+                                  : 0.0f;
+            if ((y - lo + 1) % kFlushRows == 0) totals->merge(band);
+        }
+        totals->merge(band);
+    });
+}
+
+/// Mean and standard deviation of @c count values @c step apart
+void meanStd(const float *v, int64_t count, int step, double *mean,
+             double *stddev) {
+    double sum = 0, squares = 0;
+    for (int64_t i = 0; i < count; ++i) sum += v[i * step];
+    const double m = count > 0 ? sum / count : 0;
+    for (int64_t i = 0; i < count; ++i)
+        squares += (v[i * step] - m) * (v[i * step] - m);
+    *mean = m;
+    *stddev = count > 0 ? std::sqrt(squares / count) : 0;
+}
+
+/// The column means and the result, the outputs copied if requested
+long long finish(int width, int height, const std::vector<float> &rows,
+                 const ColumnTotals &totals, float *rowMeans,
+                 float *columnMeans, LuxFpnResult *result) {
+    const double perColumn[2] = {static_cast<double>((height + 1) / 2),
+                                 static_cast<double>(height / 2)};
+    std::vector<float> columns(2 * static_cast<size_t>(width));
+    for (int x = 0; x < width; ++x)
+        for (int r = 0; r < 2; ++r)
+            columns[2 * x + r] =
+                perColumn[r] > 0
+                    ? static_cast<float>(totals.sums[r][x] / perColumn[r])
+                    : 0.0f;
+    if (rowMeans != nullptr)
+        ::memcpy(rowMeans, rows.data(), rows.size() * sizeof(float));
+    if (columnMeans != nullptr)
+        ::memcpy(columnMeans, columns.data(), columns.size() * sizeof(float));
+
+    if (result != nullptr) {
+        ::memset(result, 0, sizeof(*result));
+        result->width = width;
+        result->height = height;
+        for (int s = 0; s < 4; ++s) {
+            const int r = s >> 1, k = s & 1;
+            double columnMean;
+            /// Sites of rows r, r + 2, ... and of columns k, k + 2, ...
+            meanStd(rows.data() + 2 * r + k, (height - r + 1) / 2, 4,
+                    &result->mean[s], &result->rowNoise[s]);
+            meanStd(columns.data() + 2 * k + r, (width - k + 1) / 2, 4,
+                    &columnMean, &result->columnNoise[s]);
+        }
+    }
+    return static_cast<long long>(width) * height;
+}
+
+}  // namespace
+
+long long LuxComputeFpnProfiles(const unsigned char *imgData,
+                                unsigned long long length, int width,
+                                int height, int bpp, bool isBigEndian,
+                                bool highZero, float *rowMeans,
+                                float *columnMeans, LuxFpnResult *result) {
+    LUX_TRACE_SCOPE("fpn_profiles");
+    int ret = LuxCheckFrame(imgData, length, width, height, bpp);
+    if (ret < 0) return ret;
+
+    const int bits = LuxSignificantBits(bpp, highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << bits) - 1);
+    const uint64_t inRow = LuxPackedBytes(width, bpp);
+    const LuxCalibPass calib(width, height, bits);
+    const LuxDefectPass defects(width, height, bits);
+    const LuxDefectPass::RowSource unpack = [&](int64_t y, uint16_t *dst) {
+        LuxUnpackRow(imgData + y * inRow, dst, width, bpp, isBigEndian, mask);
+        if (calib.active()) calib.apply(y, dst, 0, width);
+    };
+
+    /// The unpacked row and the defect buffers of a band
+    struct Scratch {
+        std::vector<uint16_t> row;
+        LuxDefectPass::Scratch defects;
+    };
+    std::vector<float> rows(2 * static_cast<size_t>(height));
+    ColumnTotals totals(width);
+    project<uint16_t, uint32_t>(
+        width, height,
+        [&](int64_t y, Scratch &scratch) {
+            unpack(y, scratch.row.data());
+            if (defects.active())
+                defects.correctRow(y, scratch.row.data(), 0, width, unpack,
+                                   &scratch.defects);
+            return static_cast<const uint16_t *>(scratch.row.data());
+        },
+        [&]() {
+            Scratch scratch;
+            scratch.row.resize(width);
+            return scratch;
+        },
+        rows.data(), &totals);
+    return finish(width, height, rows, totals, rowMeans, columnMeans, result);
+}
+
+long long LuxComputeFpnProfilesF(const float *image, int width, int height,
+                                 float *rowMeans, float *columnMeans,
+                                 LuxFpnResult *result) {
+    if (image == nullptr || width <= 0 || height <= 0) {
+        std::cerr << "Profiles of a wrong frame!!!" << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+    LUX_TRACE_SCOPE("fpn_profiles");
+    std::vector<float> rows(2 * static_cast<size_t>(height));
+    ColumnTotals totals(width);
+    project<float, float>(
+        width, height,
+        [&](int64_t y, int) {
+            return image + static_cast<uint64_t>(y) * width;
+        },
+        []() { return 0; }, rows.data(), &totals);
+    return finish(width, height, rows, totals, rowMeans, columnMeans, result);
+}
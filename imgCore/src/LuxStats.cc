@@ -0,0 +1,180 @@
+/**
+ * @file LuxStats.cc
+ */
+
+#include <imgCore/LuxCalib.h>
+#include <imgCore/LuxDefect.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxStats.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+
+/// Accumulators of one band, merged under a lock at its end. The histograms
+/// have a bin per sample value: 4 x 64K counters at 16 bit, one set per band.
+struct BandAccumulator {
+    uint64_t count[4] = {0, 0, 0, 0};
+    uint64_t sum[4] = {0, 0, 0, 0};
+    uint64_t sumSquares[4] = {0, 0, 0, 0};
+    uint16_t min[4] = {UINT16_MAX, UINT16_MAX, UINT16_MAX, UINT16_MAX};
+    uint16_t max[4] = {0, 0, 0, 0};
+    std::vector<uint32_t> histogram[4];
+
+    explicit BandAccumulator(size_t bins) {
+        for (auto &h : histogram) h.assign(bins, 0);
+    }
+
+    void merge(const BandAccumulator &o) {
+        for (int s = 0; s < 4; ++s) {
+            count[s] += o.count[s];
+            sum[s] += o.sum[s];
+            sumSquares[s] += o.sumSquares[s];
+            min[s] = std::min(min[s], o.min[s]);
+            max[s] = std::max(max[s], o.max[s]);
+            for (size_t i = 0; i < histogram[s].size(); ++i)
+                histogram[s][i] += o.histogram[s][i];
+        }
+    }
+};
+
+bool validRoi(const LuxRoi &r, int width, int height) {
+    return r.x >= 0 && r.y >= 0 && r.width > 0 && r.height > 0 &&
+           r.x <= width - r.width && r.y <= height - r.height;
+}
+
+/// Smallest value whose cumulative count reaches @c rank percent of @c count
+uint16_t percentile(const std::vector<uint32_t> &histogram, uint64_t count,
+                    double rank) {
+    if (count == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(std::ceil(rank / 100.0 * count));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t cumulative = 0;
+    for (size_t v = 0; v < histogram.size(); ++v) {
+        cumulative += histogram[v];
+        if (cumulative >= target) return static_cast<uint16_t>(v);
+    }
+    return static_cast<uint16_t>(histogram.size() - 1);
+}
+
+}  // namespace
+
+long long LuxComputeBayerStats(const unsigned char *imgData,
+                               unsigned long long length, int width,
+                               int height, int bpp, bool isBigEndian,
+                               bool highZero, const LuxRoi *roi,
+                               const double *percentileRanks,
+                               int percentileCount, LuxBayerStats *stats) {
+    LUX_TRACE_SCOPE("bayer_stats");
+    int ret = LuxCheckFrame(imgData, length, width, height, bpp);
+    if (ret < 0) return ret;
+
+    LuxRoi region = roi != nullptr ? *roi : LuxRoi{0, 0, width, height};
+    bool ranksOk = percentileCount >= 0 &&
+                   percentileCount <= LUX_STATS_MAX_PERCENTILES &&
+                   (percentileCount == 0 || percentileRanks != nullptr);
+    for (int i = 0; ranksOk && i < percentileCount; ++i)
+        ranksOk = percentileRanks[i] >= 0 && percentileRanks[i] <= 100;
+    if (stats == nullptr || !ranksOk || !validRoi(region, width, height)) {
+        std::cerr << "Statistics request is wrong!!!" << std::endl;
+        ::fflush(stderr);
+        return -6;
+    }
+
+    const int bits = LuxSignificantBits(bpp, highZero);
+    const uint16_t mask = static_cast<uint16_t>((1u << bits) - 1);
+    const uint64_t inRow = LuxPackedBytes(width, bpp);
+    /// Packed samples come in groups: unpack from the group of region.x
+    const int group = LuxPackingGroup(bpp);
+    const int x0 = region.x / group * group;
+    const int x1 = region.x + region.width;
+    const int unpacked = (x1 - x0 + group - 1) / group * group;
+    const uint64_t inOffset = LuxPackedBytes(x0, bpp);
+    const int skip = region.x - x0;
+
+    BandAccumulator total(mask + 1u);
+    std::mutex totalMutex;
+    const LuxCalibPass calib(width, height, bits);
+    const LuxDefectPass defects(width, height, bits);
+    const LuxDefectPass::RowSource unpack = [&](int64_t y, uint16_t *dst) {
+        LuxUnpackRow(imgData + y * inRow + inOffset, dst, unpacked, bpp,
+                     isBigEndian, mask);
+        if (calib.active()) calib.apply(y, dst, x0, unpacked);
+    };
+
+    LuxParallelFor(
+        region.y, region.y + region.height, kGrainRows,
+        [&](int64_t lo, int64_t hi) {
+            std::vector<uint16_t> row(unpacked);
+            BandAccumulator band(mask + 1u);
+            LuxDefectPass::Scratch scratch;
+            for (int64_t y = lo; y < hi; ++y) {
+                unpack(y, row.data());
+                if (defects.active())
+                    defects.correctRow(y, row.data(), x0, unpacked, unpack,
+                                       &scratch);
+                const uint16_t *v = row.data() + skip;
+                const int rowSite = static_cast<int>(y & 1) << 1;
+                /// Two sites per row, the first one at column region.x
+                for (int k = 0; k < 2; ++k) {
+                    const int s = rowSite | ((region.x + k) & 1);
+                    uint32_t *hist = band.histogram[s].data();
+                    uint64_t sum = 0, sumSquares = 0, n = 0;
+                    uint16_t lo16 = band.min[s], hi16 = band.max[s];
+                    for (int x = k; x < region.width; x += 2, ++n) {
+                        const uint32_t value = v[x];
+                        sum += value;
+                        sumSquares += value * value;
+                        lo16 = std::min<uint16_t>(lo16, value);
+                        hi16 = std::max<uint16_t>(hi16, value);
+                        ++hist[value];
+                    }
+                    band.count[s] += n;
+                    band.sum[s] += sum;
+                    band.sumSquares[s] += sumSquares;
+                    band.min[s] = lo16;
+                    band.max[s] = hi16;
+                }
+            }
+            std::lock_guard<std::mutex> lock(totalMutex);
+            total.merge(band);
+        });
+
+    ::memset(stats, 0, sizeof(*stats));
+    stats->significantBits = bits;
+    stats->roi = region;
+    stats->percentileCount = percentileCount;
+    for (int i = 0; i < percentileCount; ++i)
+        stats->percentileRanks[i] = percentileRanks[i];
+
+    for (int s = 0; s < 4; ++s) {
+        LuxChannelStats &c = stats->channels[s];
+        c.count = total.count[s];
+        if (c.count == 0) continue;
+        c.sum = total.sum[s];
+        c.sumSquares = total.sumSquares[s];
+        c.min = total.min[s];
+        c.max = total.max[s];
+        c.mean = static_cast<double>(c.sum) / c.count;
+        /// Exact sums, the long double keeps sum^2 from cancelling
+        long double variance =
+            (c.sumSquares - static_cast<long double>(c.sum) * c.sum / c.count) /
+            c.count;
+        c.stddev = std::sqrt(std::max(static_cast<double>(variance), 0.0));
+        for (int i = 0; i < percentileCount; ++i)
+            c.percentiles[i] =
+                percentile(total.histogram[s], c.count, percentileRanks[i]);
+    }
+    return static_cast<long long>(region.width) * region.height;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file LuxTemporal.cc
+ */
+
+#include <imgCore/LuxCalib.h>
+#include <imgCore/LuxContainer.h>
+#include <imgCore/LuxDefect.h>
+#include <imgCore/LuxParallel.h>
+#include <imgCore/LuxTemporal.h>
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LUX_HAVE_SSE2 1
+#endif
+
+namespace {
+
+/// Rows of one parallel band, at least
+constexpr int64_t kGrainRows = 16;
+
+/// Per site sums of one band of the maps, merged under a lock at its end
+struct BandSums {
+    uint64_t count[4] = {0, 0, 0, 0};
+    double mean[4] = {0, 0, 0, 0};
+    double variance[4] = {0, 0, 0, 0};
+    double deviation[4] = {0, 0, 0, 0};  ///< Of the mean from the site's
+    float maxNoise[4] = {0, 0, 0, 0};
+};
+
+/// One Welford step of @c count samples:
+/// d = v - mean, mean += d / n, m2 += d * (v - mean)
+void accumulate(const uint16_t *v, float *mean, float *m2, int count,
+                float invN) {
+    int x = 0;
+#ifdef LUX_HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 inv = _mm_set1_ps(invN);
+    for (; x + 8 <= count; x += 8) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x));
+        __m128 s[2] = {_mm_cvtepi32_ps(_mm_unpacklo_epi16(in, zero)),
+                       _mm_cvtepi32_ps(_mm_unpackhi_epi16(in, zero))};
+        for (int h = 0; h < 2; ++h) {
+            float *mp = mean + x + 4 * h, *qp = m2 + x + 4 * h;
+            __m128 m = _mm_loadu_ps(mp);
+            __m128 d = _mm_sub_ps(s[h], m);
+            m = _mm_add_ps(m, _mm_mul_ps(d, inv));
+            _mm_storeu_ps(mp, m);
+            _mm_storeu_ps(qp, _mm_add_ps(_mm_loadu_ps(qp),
+                                         _mm_mul_ps(d, _mm_sub_ps(s[h], m))));
+        }
+    }
+#endif
+    for (; x < count; ++x) {
+        const float d = v[x] - mean[x];
+        mean[x] += d * invN;
+        m2[x] += d * (v[x] - mean[x]);
+    }
+}
+
+/// Accumulate @c count frames of @c length bytes, read by @c read on
+/// another thread one frame ahead of the accumulation
+long long accumulateFrames(
+    int count, uint64_t length,
+    const std::function<long long(int k, unsigned char *frame)> &read,
+    LuxTemporalAccumulator *accumulator) {
+    std::vector<unsigned char> buffers[2];
+    for (auto &b : buffers) b.resize(length);
+    std::future<long long> next =
+        std::async(std::launch::async, read, 0, buffers[0].data());
+    for (int k = 0; k < count; ++k) {
+        long long ret = next.get();
+        if (ret < 0) return ret;
+        if (k + 1 < count)
+            next = std::async(std::launch::async, read, k + 1,
+                              buffers[(k + 1) % 2].data());
+        ret = accumulator->add(buffers[k % 2].data(), length);
+        if (ret < 0) return ret;
+    }
+    return accumulator->frames();
+}
+
+/// Bytes of a frame, 0 with a wrong geometry (logged)
+uint64_t frameBytes(int width, int height, int bpp) {
+    const uint64_t length =
+        width > 0 && height > 0 ? LuxPackedBytes(width, bpp) * height : 0;
+    if (length == 0) {
+        std::cerr << "Temporal analysis of a wrong geometry!!!" << std::endl;
+        ::fflush(stderr);
+    }
+    return length;
+}
+
+}  // namespace
+
+LuxTemporalAccumulator::LuxTemporalAccumulator(int width, int height,
+                                               int bpp, bool isBigEndian,
+                                               bool highZero)
+    : width_(width),
+      height_(height),
+      bpp_(bpp),
+      bits_(LuxSignificantBits(bpp, highZero)),
+      isBigEndian_(isBigEndian),
+      frames_(0) {}
+
+long long LuxTemporalAccumulator::add(const unsigned char *imgData,
+                                      unsigned long long length) {
+    LUX_TRACE_SCOPE("temporal_add");
+    int ret = LuxCheckFrame(imgData, length, width_, height_, bpp_);
+    if (ret < 0) return ret;
+
+    const uint64_t samples = static_cast<uint64_t>(width_) * height_;
+    if (frames_ == 0) {
+        mean_.assign(samples, 0);
+        m2_.assign(samples, 0);
+    }
+    const float invN = 1.0f / (frames_ + 1);
+    const uint16_t mask = static_cast<uint16_t>((1u << bits_) - 1);
+    const uint64_t inRow = LuxPackedBytes(width_, bpp_);
+    const LuxCalibPass calib(width_, height_, bits_);
+    const LuxDefectPass defects(width_, height_, bits_);
+    const LuxDefectPass::RowSource unpack = [&](int64_t y, uint16_t *dst) {
+        LuxUnpackRow(imgData + y * inRow, dst, width_, bpp_, isBigEndian_,
+                     mask);
+        if (calib.active()) calib.apply(y, dst, 0, width_);
+    };
+
+    LuxParallelFor(0, height_, kGrainRows, [&](int64_t lo, int64_t hi) {
+        std::vector<uint16_t> row(width_);
+        LuxDefectPass::Scratch scratch;
+        for (int64_t y = lo; y < hi; ++y) {
+            unpack(y, row.data());
+            if (defects.active())
+                defects.correctRow(y, row.data(), 0, width_, unpack,
+                                   &scratch);
+            accumulate(row.data(), mean_.data() + y * width_,
+                       m2_.data() + y * width_, width_, invN);
+        }
+    });
+    return ++frames_;
+}
+
+long long LuxTemporalAccumulator::finish(float *meanMap, float *noiseMap,
+                                         LuxTemporalResult *result) const {
+    if (frames_ == 0) return -6;
+    LUX_TRACE_SCOPE("temporal_finish");
+
+    /// The maps and the sums, then the spread of the mean around the mean
+    /// of its site
+    const float invN1 = frames_ > 1 ? 1.0f / (frames_ - 1) : 0.0f;
+    BandSums total;
+    std::mutex totalMutex;
+    LuxParallelFor(0, height_, kGrainRows, [&](int64_t lo, int64_t hi) {
+        BandSums band;
+        for (int64_t y = lo; y < hi; ++y) {
+            const uint64_t at = y * width_;
+            const float *mean = mean_.data() + at;
+            const float *m2 = m2_.data() + at;
+            if (meanMap != nullptr)
+                ::memcpy(meanMap + at, mean, width_ * sizeof(float));
+            for (int k = 0; k < 2; ++k) {
+                const int s = static_cast<int>((y & 1) << 1) | k;
+                double sum = 0, variance = 0;
+                float maxNoise = band.maxNoise[s];
+                for (int x = k; x < width_; x += 2) {
+                    const float v = std::max(m2[x] * invN1, 0.0f);
+                    const float sd = std::sqrt(v);
+                    if (noiseMap != nullptr) noiseMap[at + x] = sd;
+                    sum += mean[x];
+                    variance += v;
+                    maxNoise = std::max(maxNoise, sd);
+                }
+                band.count[s] += (width_ - k + 1) / 2;
+                band.mean[s] += sum;
+                band.variance[s] += variance;
+                band.maxNoise[s] = maxNoise;
+            }
+        }
+        std::lock_guard<std::mutex> lock(totalMutex);
+        for (int s = 0; s < 4; ++s) {
+            total.count[s] += band.count[s];
+            total.mean[s] += band.mean[s];
+            total.variance[s] += band.variance[s];
+            total.maxNoise[s] = std::max(total.maxNoise[s], band.maxNoise[s]);
+        }
+    });
+    if (result == nullptr) return frames_;
+
+    double siteMean[4];
+    for (int s = 0; s < 4; ++s)
+        siteMean[s] = total.count[s] > 0 ? total.mean[s] / total.count[s] : 0;
+    LuxParallelFor(0, height_, kGrainRows, [&](int64_t lo, int64_t hi) {
+        double deviation[4] = {0, 0, 0, 0};
+        for (int64_t y = lo; y < hi; ++y) {
+            const float *mean = mean_.data() + y * width_;
+            for (int k = 0; k < 2; ++k) {
+                const int s = static_cast<int>((y & 1) << 1) | k;
+                double sum = 0;
+                for (int x = k; x < width_; x += 2)
+                    sum += (mean[x] - siteMean[s]) * (mean[x] - siteMean[s]);
+                deviation[s] += sum;
+            }
+        }
+        std::lock_guard<std::mutex> lock(totalMutex);
+        for (int s = 0; s < 4; ++s) total.deviation[s] += deviation[s];
+    });
+
+    ::memset(result, 0, sizeof(*result));
+    result->frames = frames_;
+    result->significantBits = bits_;
+    result->width = width_;
+    result->height = height_;
+    for (int s = 0; s < 4; ++s) {
+        LuxTemporalChannel &c = result->channels[s];
+        c.count = total.count[s];
+        if (c.count == 0) continue;
+        c.mean = siteMean[s];
+        c.temporalNoise = std::sqrt(total.variance[s] / c.count);
+        c.spatialNoise = std::sqrt(total.deviation[s] / c.count);
+        c.maxNoise = total.maxNoise[s];
+    }
+    return frames_;
+}
+
+void LuxTemporalAccumulator::reset() {
+    frames_ = 0;
+    mean_.clear();
+    mean_.shrink_to_fit();
+    m2_.clear();
+    m2_.shrink_to_fit();
+}
+
+long long LuxTemporalFromFiles(const char *const *fileNames, int count,
+                               int width, int height, int bpp,
+                               bool isBigEndian, bool highZero, float *meanMap,
+                               float *noiseMap, LuxTemporalResult *result) {
+    if (fileNames == nullptr || count <= 0) return -6;
+    if (LuxPackingGroup(bpp) == 0) return -2;
+    const uint64_t length = frameBytes(width, height, bpp);
+    if (length == 0) return -4;
+
+    LuxTemporalAccumulator accumulator(width, height, bpp, isBigEndian,
+                                       highZero);
+    long long ret = accumulateFrames(
+        count, length,
+        [&](int k, unsigned char *frame) {
+            return LuxReadFrameFromFile(fileNames[k], frame, length);
+        },
+        &accumulator);
+    if (ret < 0) return ret;
+    return accumulator.finish(meanMap, noiseMap, result);
+}
+
+long long LuxTemporalFromSequence(const char *fileName, int maxFrames,
+                                  int width, int height, int bpp,
+                                  bool isBigEndian, bool highZero,
+                                  float *meanMap, float *noiseMap,
+                                  LuxTemporalResult *result) {
+    if (LuxPackingGroup(bpp) == 0) return -2;
+    const uint64_t length = frameBytes(width, height, bpp);
+    if (length == 0) return -4;
+
+    std::ifstream fin(fileName, std::ios_base::binary);
+    if (!fin.is_open()) {
+        std::cerr << "Fail to read " << fileName << std::endl;
+        ::fflush(stderr);
+        return -3;
+    }
+    fin.seekg(0, fin.end);
+    const uint64_t size = fin.tellg();
+    if (size == 0 || size % length != 0) {
+        std::cerr << "Not a sequence of frames of " << length
+                  << " bytes: " << fileName << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+    uint64_t count = size / length;
+    if (maxFrames > 0) count = std::min<uint64_t>(count, maxFrames);
+
+    /// One read at a time: the stream is shared by the reads in turn
+    LuxTemporalAccumulator accumulator(width, height, bpp, isBigEndian,
+                                       highZero);
+    long long ret = accumulateFrames(
+        static_cast<int>(count), length,
+        [&](int k, unsigned char *frame) -> long long {
+            fin.seekg(static_cast<uint64_t>(k) * length, fin.beg);
+            fin.read(reinterpret_cast<char *>(frame), length);
+            return fin.fail() ? -3 : static_cast<long long>(length);
+        },
+        &accumulator);
+    if (ret < 0) return ret;
+    return accumulator.finish(meanMap, noiseMap, result);
+}
@@ -0,0 +1,197 @@
+/**
+ * @file LuxTrace.cc
+ */
+
+#include <imgCore/LuxTrace.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+struct LuxTraceEvent {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+/// Events of one thread. The owning thread is the only writer, so the lock
+/// is uncontended except while dumping.
+struct LuxTraceBuffer {
+    std::mutex lock;
+    uint32_t tid;
+    std::vector<LuxTraceEvent> events;
+};
+
+/// Bound the memory of a long session, the oldest half is dropped
+constexpr size_t kMaxEventsPerThread = 1 << 20;
+
+struct LuxTraceRegistry {
+    std::mutex lock;
+    std::vector<std::shared_ptr<LuxTraceBuffer>> buffers;
+    std::atomic<bool> enabled{true};
+    std::atomic<uint32_t> nextTid{1};
+    std::chrono::steady_clock::time_point epoch =
+        std::chrono::steady_clock::now();
+};
+
+LuxTraceRegistry &registry() {
+    static LuxTraceRegistry reg;
+    return reg;
+}
+
+/// Registered on first use, kept alive by the registry after the thread exits
+LuxTraceBuffer &threadBuffer() {
+    thread_local std::shared_ptr<LuxTraceBuffer> buffer = []() {
+        auto &reg = registry();
+        auto buf = std::make_shared<LuxTraceBuffer>();
+        buf->tid = reg.nextTid++;
+        std::lock_guard<std::mutex> guard(reg.lock);
+        reg.buffers.push_back(buf);
+        return buf;
+    }();
+    return *buffer;
+}
+
+/// Copy every event out of the buffers, tagged with its thread id
+std::vector<std::pair<uint32_t, LuxTraceEvent>> snapshot() {
+    std::vector<std::pair<uint32_t, LuxTraceEvent>> all;
+    auto &reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (auto &buf : reg.buffers) {
+        std::lock_guard<std::mutex> bufGuard(buf->lock);
+        for (auto &e : buf->events) all.emplace_back(buf->tid, e);
+    }
+    return all;
+}
+
+/// Nearest-rank percentile of a sorted vector
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+}  // namespace
+
+uint64_t LuxTraceNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - registry().epoch)
+        .count();
+}
+
+void LuxTraceRecord(const char *name, uint64_t beginNs, uint64_t endNs) {
+    if (name == nullptr) return;
+    auto &buf = threadBuffer();
+    std::lock_guard<std::mutex> guard(buf.lock);
+    if (buf.events.size() >= kMaxEventsPerThread)
+        buf.events.erase(buf.events.begin(),
+                         buf.events.begin() + kMaxEventsPerThread / 2);
+    buf.events.push_back({name, beginNs, endNs});
+}
+
+void LuxTraceEnable(bool enable) { registry().enabled = enable; }
+
+bool LuxTraceEnabled() { return registry().enabled.load(); }
+
+void LuxTraceReset() {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (auto &buf : reg.buffers) {
+        std::lock_guard<std::mutex> bufGuard(buf->lock);
+        buf->events.clear();
+    }
+}
+
+long long LuxTraceDump(const char *fileName) {
+    std::ofstream fout(fileName);
+    if (!fout.is_open()) {
+        std::cerr << "Fail to open " << fileName << std::endl;
+        ::fflush(stderr);
+        return -3;
+    }
+
+    auto events = snapshot();
+    fout << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    fout << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < events.size(); ++i) {
+        auto &e = events[i].second;
+        // Complete events ("X"), timestamps in microseconds
+        fout << (i ? ",\n" : "\n") << "{\"name\": \"" << e.name
+             << "\", \"cat\": \"ziwi\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+             << events[i].first << ", \"ts\": " << e.begin / 1000.0
+             << ", \"dur\": " << (e.end - e.begin) / 1000.0 << "}";
+    }
+    fout << "\n]}" << std::endl;
+    return static_cast<long long>(events.size());
+}
+
+std::vector<LuxTraceStat> LuxTraceStats() {
+    std::map<std::string, std::vector<double>> durations;
+    for (auto &te : snapshot())
+        durations[te.second.name].push_back(
+            (te.second.end - te.second.begin) / 1000.0);
+
+    std::vector<LuxTraceStat> stats;
+    for (auto &kv : durations) {
+        auto &d = kv.second;
+        std::sort(d.begin(), d.end());
+        LuxTraceStat s;
+        s.name = kv.first;
+        s.count = d.size();
+        s.total = 0;
+        for (double v : d) s.total += v;
+        s.mean = s.total / d.size();
+        s.p50 = percentile(d, 50);
+        s.p90 = percentile(d, 90);
+        s.p99 = percentile(d, 99);
+        s.max = d.back();
+        stats.push_back(s);
+    }
+    std::sort(stats.begin(), stats.end(),
+              [](const LuxTraceStat &a, const LuxTraceStat &b) {
+                  return a.total > b.total;
+              });
+    return stats;
+}
+
+int LuxTraceWriteSummary(const char *fileName) {
+    std::ostringstream os;
+    os << std::left << std::setw(24) << "stage" << std::right << std::setw(8)
+       << "count" << std::setw(12) << "total(ms)" << std::setw(12)
+       << "mean(us)" << std::setw(12) << "p50(us)" << std::setw(12)
+       << "p90(us)" << std::setw(12) << "p99(us)" << std::setw(12)
+       << "max(us)" << "\n";
+    os << std::fixed << std::setprecision(1);
+
+    auto stats = LuxTraceStats();
+    for (auto &s : stats)
+        os << std::left << std::setw(24) << s.name << std::right
+           << std::setw(8) << s.count << std::setw(12) << s.total / 1000.0
+           << std::setw(12) << s.mean << std::setw(12) << s.p50
+           << std::setw(12) << s.p90 << std::setw(12) << s.p99
+           << std::setw(12) << s.max << "\n";
+
+    if (fileName == nullptr) {
+        std::cerr << os.str();
+        ::fflush(stderr);
+    } else {
+        std::ofstream fout(fileName);
+        if (!fout.is_open()) {
+            std::cerr << "Fail to open " << fileName << std::endl;
+            ::fflush(stderr);
+            return -3;
+        }
+        fout << os.str();
+    }
+    return static_cast<int>(stats.size());
+}
@@ -0,0 +1,183 @@
+/**
+ * @file LuxUnpack.cc
+ */
+
+#include <imgCore/LuxUnpack.h>
+#include <stdio.h>
+
+#include <iostream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LUX_HAVE_SSSE3_DISPATCH 1
+#endif
+
+namespace {
+
+/// P = b[i] << 2 | 2 bits of b[4]
+void unpackRaw10Scalar(const uint8_t *src, uint16_t *dst, int width) {
+    for (int x = 0; x < width; x += 4, src += 5)
+        for (int i = 0; i < 4; ++i)
+            dst[x + i] = static_cast<uint16_t>((src[i] << 2) |
+                                               ((src[4] >> (2 * i)) & 0x03));
+}
+
+/// P0 = b0 << 4 | b2 & 0x0F, P1 = b1 << 4 | b2 >> 4
+void unpackRaw12Scalar(const uint8_t *src, uint16_t *dst, int width) {
+    for (int x = 0; x < width; x += 2, src += 3) {
+        dst[x] = static_cast<uint16_t>((src[0] << 4) | (src[2] & 0x0F));
+        dst[x + 1] = static_cast<uint16_t>((src[1] << 4) | (src[2] >> 4));
+    }
+}
+
+/// P = b[i] << 6 | 6 bits of the little endian b4 b5 b6
+void unpackRaw14(const uint8_t *src, uint16_t *dst, int width) {
+    for (int x = 0; x < width; x += 4, src += 7) {
+        const uint32_t low = src[4] | (src[5] << 8) | (src[6] << 16);
+        for (int i = 0; i < 4; ++i)
+            dst[x + i] = static_cast<uint16_t>((src[i] << 6) |
+                                               ((low >> (6 * i)) & 0x3F));
+    }
+}
+
+#ifdef LUX_HAVE_SSSE3_DISPATCH
+/// 8 samples per 10 bytes: each lane gets the high byte and the low-bits
+/// byte, a per lane multiply moves the 2 bits of the sample to bits 7:6.
+__attribute__((target("ssse3")))
+void unpackRaw10SSSE3(const uint8_t *src, uint16_t *dst, int width) {
+    const __m128i shuffle =
+        _mm_setr_epi8(4, 0, 4, 1, 4, 2, 4, 3, 9, 5, 9, 6, 9, 7, 9, 8);
+    const __m128i mul = _mm_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1);
+    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF00));
+    const __m128i low = _mm_set1_epi16(0x00C0);
+
+    int x = 0;
+    /// The 16-byte load reads 6 bytes past the 10 used
+    for (; x + 8 <= width && (x / 4 * 5) + 16 <= width / 4 * 5; x += 8) {
+        __m128i in = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(src + x / 4 * 5));
+        __m128i lanes = _mm_shuffle_epi8(in, shuffle);
+        __m128i msb = _mm_srli_epi16(_mm_and_si128(lanes, high), 6);
+        __m128i lsb =
+            _mm_srli_epi16(_mm_and_si128(_mm_mullo_epi16(lanes, mul), low), 6);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                         _mm_or_si128(msb, lsb));
+    }
+    unpackRaw10Scalar(src + x / 4 * 5, dst + x, width - x);
+}
+
+/// 8 samples per 12 bytes, as unpackRaw10SSSE3() with nibbles
+__attribute__((target("ssse3")))
+void unpackRaw12SSSE3(const uint8_t *src, uint16_t *dst, int width) {
+    const __m128i shuffle =
+        _mm_setr_epi8(2, 0, 2, 1, 5, 3, 5, 4, 8, 6, 8, 7, 11, 9, 11, 10);
+    const __m128i mul = _mm_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1);
+    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF00));
+    const __m128i low = _mm_set1_epi16(0x00F0);
+
+    int x = 0;
+    /// The 16-byte load reads 4 bytes past the 12 used
+    for (; x + 8 <= width && (x / 2 * 3) + 16 <= width / 2 * 3; x += 8) {
+        __m128i in = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(src + x / 2 * 3));
+        __m128i lanes = _mm_shuffle_epi8(in, shuffle);
+        __m128i msb = _mm_srli_epi16(_mm_and_si128(lanes, high), 4);
+        __m128i lsb =
+            _mm_srli_epi16(_mm_and_si128(_mm_mullo_epi16(lanes, mul), low), 4);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                         _mm_or_si128(msb, lsb));
+    }
+    unpackRaw12Scalar(src + x / 2 * 3, dst + x, width - x);
+}
+
+const bool kHasSSSE3 = __builtin_cpu_supports("ssse3");
+#endif
+
+void unpackRaw10(const uint8_t *src, uint16_t *dst, int width) {
+#ifdef LUX_HAVE_SSSE3_DISPATCH
+    if (kHasSSSE3) return unpackRaw10SSSE3(src, dst, width);
+#endif
+    unpackRaw10Scalar(src, dst, width);
+}
+
+void unpackRaw12(const uint8_t *src, uint16_t *dst, int width) {
+#ifdef LUX_HAVE_SSSE3_DISPATCH
+    if (kHasSSSE3) return unpackRaw12SSSE3(src, dst, width);
+#endif
+    unpackRaw12Scalar(src, dst, width);
+}
+
+}  // namespace
+
+int LuxCheckFrame(const unsigned char *imgData, unsigned long long length,
+                  int width, int height, int bpp) {
+    return LuxCheckFrameLayout(imgData, length, width, height, bpp, nullptr);
+}
+
+int LuxCheckFrameLayout(const unsigned char *imgData,
+                        unsigned long long length, int width, int height,
+                        int bpp, const LuxFrameLayout *layout) {
+    if (LuxPackingGroup(bpp) == 0) {
+        std::cerr << "bpp Don't Supported!!! \n"
+                  << "Supported depth of bits: 8, 12, 16, MIPI RAW10 / RAW12 "
+                     "/ RAW14"
+                  << std::endl;
+        ::fflush(stderr);
+        return -2;
+    }
+    uint64_t rowBytes = width > 0 ? LuxPackedBytes(width, bpp) : 0;
+    uint64_t stride = LuxLayoutInStride(layout, rowBytes);
+    /// The signs first, then the lines in 64 bits, as LuxFrameLayoutBytes()
+    uint64_t lines = height > 0 ? static_cast<uint64_t>(height) : 0;
+    if (layout != nullptr) {
+        if (layout->topLines < 0 || layout->bottomLines < 0 ||
+            LuxLayoutOutStride(layout, width) == 0)
+            stride = 0;
+        else
+            lines += static_cast<uint64_t>(layout->topLines) +
+                     layout->bottomLines;
+    }
+    if (imgData == nullptr || stride == 0 || lines == 0 ||
+        stride > UINT64_MAX / lines || height <= 0 ||
+        length != stride * lines) {
+        std::cerr << "width or height or bpp or length are wrong!!!"
+                  << "\nlength: " << length << "\nwidth: " << width
+                  << "\nheight: " << height << "\nbits per pixel: " << bpp;
+        if (layout != nullptr)
+            std::cerr << "\nstride: " << layout->inStride
+                      << "\ntop lines: " << layout->topLines
+                      << "\nbottom lines: " << layout->bottomLines
+                      << "\noutput stride: " << layout->outStride;
+        std::cerr << std::endl;
+        ::fflush(stderr);
+        return -4;
+    }
+    return 0;
+}
+
+void LuxUnpackRow(const uint8_t *src, uint16_t *dst, int width, int bpp,
+                  bool bigEndian, uint16_t mask) {
+    if (bpp == 8) {
+        for (int x = 0; x < width; ++x) dst[x] = src[x];
+    } else if (bpp == 12) {
+        /// AAAAAAAA AAAABBBB BBBBBBBB
+        for (int x = 0; x < width; x += 2, src += 3) {
+            dst[x] = static_cast<uint16_t>((src[0] << 4) | (src[1] >> 4));
+            dst[x + 1] = static_cast<uint16_t>(((src[1] & 0x0F) << 8) | src[2]);
+        }
+    } else if (bpp == LUX_BPP_RAW10) {
+        unpackRaw10(src, dst, width);
+    } else if (bpp == LUX_BPP_RAW12) {
+        unpackRaw12(src, dst, width);
+    } else if (bpp == LUX_BPP_RAW14) {
+        unpackRaw14(src, dst, width);
+    } else if (bigEndian) {
+        for (int x = 0; x < width; ++x)
+            dst[x] = static_cast<uint16_t>((src[2 * x] << 8) | src[2 * x + 1]) &
+                     mask;
+    } else {
+        for (int x = 0; x < width; ++x)
+            dst[x] = static_cast<uint16_t>(src[2 * x] | (src[2 * x + 1] << 8)) &
+                     mask;
+    }
+}
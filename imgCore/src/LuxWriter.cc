@@ -0,0 +1,298 @@
+/**
+ * @file LuxWriter.cc
+ */
+
+#include <imgCore/LuxTrace.h>
+#include <imgCore/LuxWriter.h>
+#include <stdio.h>
+
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Failed tickets kept for LuxWriterWait(), the oldest are dropped beyond
+constexpr size_t kKeptFailures = 256;
+
+struct LuxWriteTask {
+    long long ticket;
+    std::vector<uint8_t> data;
+    int width;
+    int height;
+    int type;
+    bool isRGB;
+    LuxWriterConf conf;
+    std::string fileName;
+};
+
+/// Bytes per pixel of the supported types, 0 otherwise
+int pixelBytes(int type) {
+    switch (type) {
+        case CV_8UC1:
+            return 1;
+        case CV_8UC3:
+            return 3;
+        case CV_16UC1:
+            return 2;
+        case CV_16UC3:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+bool encode(LuxWriteTask &task) {
+    LUX_TRACE_SCOPE("encode");
+    cv::Mat image(task.height, task.width, task.type, task.data.data());
+    // The task owns the copy, swap the channels in place
+    if (task.isRGB && (task.type == CV_8UC3 || task.type == CV_16UC3))
+        cv::cvtColor(image, image, cv::COLOR_RGB2BGR);
+
+    std::vector<int> params;
+    switch (task.conf.codec) {
+        case LUX_WRITER_TIFF_NONE:
+            params = {cv::IMWRITE_TIFF_COMPRESSION, 1};
+            break;
+        case LUX_WRITER_TIFF_LZW:
+            params = {cv::IMWRITE_TIFF_COMPRESSION, 5};
+            break;
+        case LUX_WRITER_TIFF_DEFLATE:
+            params = {cv::IMWRITE_TIFF_COMPRESSION, 8};
+            break;
+        case LUX_WRITER_PNG:
+            params = {cv::IMWRITE_PNG_COMPRESSION, task.conf.level};
+            break;
+    }
+
+    try {
+        return cv::imwrite(task.fileName, image, params);
+    } catch (const std::exception &e) {
+        std::cerr << "Fail to write " << task.fileName << ": " << e.what()
+                  << std::endl;
+        ::fflush(stderr);
+        return false;
+    }
+}
+
+class LuxWriterQueue {
+public:
+    LuxWriterQueue() { start(); }
+    /// Backstop only, shutdown() joins the workers: see writer()
+    ~LuxWriterQueue() {
+        for (auto &t : workers_)
+            if (t.joinable()) t.detach();
+    }
+
+    int configure(const LuxWriterConf &conf) {
+        if (conf.codec < 0 || conf.codec >= LUX_WRITER_CODEC_COUNT ||
+            conf.level < 0 || conf.level > 9 || conf.queueDepth < 1 ||
+            conf.threads < 1)
+            return -1;
+        std::lock_guard<std::mutex> control(controlMutex_);
+        if (shutdown_) return -1;
+        stop();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            conf_ = conf;
+        }
+        start();
+        return 0;
+    }
+
+    /// Drain the queue and join the workers for good
+    int shutdown() {
+        std::lock_guard<std::mutex> control(controlMutex_);
+        if (!shutdown_) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                shutdown_ = true;
+            }
+            stop();
+        }
+        return flush();
+    }
+
+    LuxWriterConf conf() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return conf_;
+    }
+
+    long long submit(const void *imgData, int width, int height, int type,
+                     const char *outFileName, bool isRGB) {
+        int bytes = pixelBytes(type);
+        if (bytes == 0 || imgData == nullptr || outFileName == nullptr)
+            return -1;
+
+        LuxWriteTask task;
+        task.data.resize(static_cast<size_t>(width) * height * bytes);
+        ::memcpy(task.data.data(), imgData, task.data.size());
+        task.width = width;
+        task.height = height;
+        task.type = type;
+        task.isRGB = isRGB;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        // A reconfiguration lets the blocked submits in, the new workers
+        // take them; a shutdown turns them away, its workers are gone
+        notFull_.wait(lock, [this]() {
+            return shutdown_ || stopping_ ||
+                   static_cast<int>(queue_.size()) < conf_.queueDepth;
+        });
+        if (shutdown_) {
+            std::cerr << "Writer shut down, " << outFileName
+                      << " is not written" << std::endl;
+            ::fflush(stderr);
+            return -2;
+        }
+        task.conf = conf_;
+        task.fileName = withSuffix(outFileName, conf_.codec);
+        task.ticket = ++lastTicket_;
+        pending_.insert(task.ticket);
+        queue_.push_back(std::move(task));
+        notEmpty_.notify_one();
+        return lastTicket_;
+    }
+
+    int wait(long long ticket) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&]() { return pending_.count(ticket) == 0; });
+        return failedTickets_.erase(ticket) ? -1 : 0;
+    }
+
+    int flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return pending_.empty(); });
+        int failed = failures_;
+        failures_ = 0;
+        failedTickets_.clear();
+        return failed;
+    }
+
+private:
+    /// ".tiff" / ".png" is appended when missing, as LuxWriteImageIntoFile;
+    /// the suffix of the other codec is replaced, "x.tiff" gives "x.png"
+    static std::string withSuffix(const char *fileName, int codec) {
+        std::string name(fileName);
+        const bool png = codec == LUX_WRITER_PNG;
+        std::string suffix;
+        const auto dot = name.find_last_of("./\\");
+        if (dot != std::string::npos && name[dot] == '.') {
+            suffix = name.substr(dot);
+            for (auto &c : suffix)
+                c = static_cast<char>(
+                    std::tolower(static_cast<unsigned char>(c)));
+        }
+        const bool isTiff = suffix == ".tiff" || suffix == ".tif";
+        if (png ? suffix == ".png" : isTiff) return name;
+        if (isTiff || suffix == ".png") name.erase(dot);
+        return name + (png ? ".png" : ".tiff");
+    }
+
+    /// start() / stop() under controlMutex_
+    void start() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = false;
+        }
+        for (int i = 0; i < conf_.threads; ++i)
+            workers_.emplace_back([this]() { work(); });
+    }
+
+    /// Drain the queue and join the workers
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            notEmpty_.notify_all();
+            notFull_.notify_all();
+        }
+        for (auto &t : workers_) t.join();
+        workers_.clear();
+    }
+
+    void work() {
+        for (;;) {
+            LuxWriteTask task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notEmpty_.wait(
+                    lock, [this]() { return !queue_.empty() || stopping_; });
+                if (queue_.empty()) return;
+                task = std::move(queue_.front());
+                queue_.pop_front();
+                notFull_.notify_one();
+            }
+
+            bool ok = encode(task);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.erase(task.ticket);
+            if (!ok) {
+                ++failures_;
+                failedTickets_.insert(task.ticket);
+                if (failedTickets_.size() > kKeptFailures)
+                    failedTickets_.erase(failedTickets_.begin());
+            }
+            done_.notify_all();
+        }
+    }
+
+    LuxWriterConf conf_{LUX_WRITER_TIFF_LZW, 3, 4, 2};
+    /// Serializes configure() and shutdown(), each restarts the workers
+    std::mutex controlMutex_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_, notFull_, done_;
+    std::deque<LuxWriteTask> queue_;
+    std::set<long long> pending_, failedTickets_;
+    int failures_ = 0;  ///< Since the last flush
+    long long lastTicket_ = 0;
+    bool stopping_ = false;
+    bool shutdown_ = false;
+    std::vector<std::thread> workers_;
+};
+
+/// Never destroyed: joining the workers or encoding from a static
+/// destructor would run after OpenCV or the iostreams may be gone. The
+/// queue is drained by LuxWriterShutdown(), from the program or else at
+/// exit: registered after OpenCV and the iostreams are up, the handler runs
+/// before they go.
+LuxWriterQueue &writer() {
+    static LuxWriterQueue *queue = []() {
+        auto q = new LuxWriterQueue;
+        std::atexit([]() { LuxWriterShutdown(); });
+        return q;
+    }();
+    return *queue;
+}
+
+}  // namespace
+
+int LuxWriterConfigure(const LuxWriterConf *conf) {
+    if (conf == nullptr) return -1;
+    return writer().configure(*conf);
+}
+
+void LuxWriterGetConf(LuxWriterConf *conf) {
+    if (conf != nullptr) *conf = writer().conf();
+}
+
+long long LuxWriterSubmit(const void *imgData, int width, int height, int type,
+                          const char *outFileName, bool isRGB) {
+    return writer().submit(imgData, width, height, type, outFileName, isRGB);
+}
+
+int LuxWriterWait(long long ticket) { return writer().wait(ticket); }
+
+int LuxWriterFlush() { return writer().flush(); }
+
+int LuxWriterShutdown() { return writer().shutdown(); }
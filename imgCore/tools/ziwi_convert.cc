@@ -0,0 +1,883 @@
+/**
+ * @file ziwi_convert.cc
+ * @brief Headless batch converter: raw captures -> tiff / png / bmp / jpg /
+ * parsed raw, with the same parameters as the ParaConfDialog.
+ *
+ * Three stages connected by bounded queues:
+ *  read   (--readers threads)  file -> bytes
+ *  decode (-j threads)         CRC strip, endian, parse, demosaic
+ *  encode (--encoders threads) cv::imwrite / raw write
+ *
+ * Usage:
+ *  ziwi-convert [options] <dir | glob | file>... -o <outDir>
+ *   --ini <para.ini>     read workspace/width/height/channels/bpp/mode/endian/
+ *                        crcType/crcScope from the GUI settings
+ *   --workspace 0|1      0: CE7, 1: TW2 (0000AAAA AAAAAAAA)
+ *   --width N --height N --bpp 8|12|16|raw10|raw12|raw14 --channels N
+ *   --mode 0-5           raw10/12/14: MIPI CSI-2 packed, --channels 1
+ *   --little-endian      input is little endian (default big endian)
+ *   --data-format 1|2    1: raw (gray), 2: bayer (RGB), default 2
+ *   --crc N --crc-scope line|frame   see LuxCRCType
+ *   --format tiff|png|bmp|jpg|raw|zraw   default tiff
+ *   --bayer 0-3 --tile WxH --preview N   .zraw: Bayer pattern, tiled payload,
+ *                        preview longest side (0: none, default 256)
+ *   --compress           .zraw: lossless LuxCodec payload, not with --tile
+ *   --awb gray|white     automatic white balance (gray world / white patch)
+ *                        of the Bayer output, --bayer gives the pattern
+ *   --auto-levels        pick the window (--mode) and the gain per frame
+ *   --normalize LOW,HIGH mode 5 between these percentiles, default 0,100
+ *   --packing FILE|SPEC  packing descriptor (see LuxPacking.h), e.g.
+ *                        "bits=10;bitOrder=lsb;byteOrder=little"; a sidecar
+ *                        <input>.pack or [packing] in --ini is used as well
+ *   --line-stride N --top-lines N --bottom-lines N   bytes per input line,
+ *                        embedded data lines before / after the image
+ *   --black N[,N,N,N]    black level, per Bayer site in the order of the
+ *                        frame; --no-rescale keeps [0, full scale - black]
+ *   --dark FILE --flat FILE   dark frame / flat field raws of the input
+ *                        format (see LuxCalib.h)
+ *   --defects FILE       defect map (see LuxDefect.h) of width * channels x
+ *                        height, corrected while unpacking
+ *   --defect-dynamic T   also correct the isolated defects standing out of
+ *                        their neighbours by T of the full scale, e.g. 0.25
+ *   --ccm M0,...,M8      color correction matrix of the RGB output, row-major
+ *   --gamma srgb|none|P  curve of the RGB output, P: power, e.g. 2.2 (see
+ *                        LuxColor.h)
+ *   --temporal           no conversion: mean and temporal noise of the
+ *                        inputs (one file: frames back to back) into
+ *                        temporal_mean.tiff / temporal_noise.tiff (32-bit
+ *                        float) and a summary per Bayer channel
+ *
+ * .zraw inputs carry their own geometry, the parameters above are ignored
+ * for them and --width/--height are not needed when every input is one
+ * (except with --temporal).
+ *   -j N --readers N --encoders N
+ *   --threads N          threads of the imgCore pool shared by the decoders,
+ *                        0: one per core (default)
+ */
+
+#include <imgCore/LuxCheck.h>
+#include <imgCore/LuxContainer.h>
+#include <imgCore/LuxDLL.h>
+#include <imgCore/LuxPacking.h>
+#include <imgCore/LuxTrace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// Mirror of Lux::ziwi::ParaConf, without Qt
+struct ConvertConf {
+    int workspace = 0;
+    int width = 0;
+    int height = 0;
+    int channels = 1;
+    int bpp = 16;
+    int mode = 0;
+    bool bigEndian = true;
+    int dataFormat = 2;
+    LuxCheckConf check{LUX_CRC_NONE, LUX_CHECK_LINE, LUX_CHECK_TAIL, 0, 0,
+                       false, true};
+    std::string format = "tiff";
+    int bayerPattern = 3;
+    int tileWidth = 0;
+    int tileHeight = 0;
+    int previewSide = 256;
+    bool compress = false;
+    int awb = LUX_AWB_NONE;
+    bool autoLevels = false;
+    bool hasPacking = false;
+    LuxPackingDesc packing;
+    LuxFrameLayout layout{0, 0, 0, 0};
+    std::string outDir;
+    int decoders = 0;
+    int readers = 2;
+    int encoders = 2;
+    int threads = 0;  ///< LuxSetNumThreads()
+    LuxCalibConf calib{{0, 0, 0, 0}, 1};
+    std::string calibFrames[2];  ///< Dark frame, flat field
+    std::string defectMap;
+    LuxDefectConf defect{0, 0.25};
+    LuxColorConf color{{1, 0, 0, 0, 1, 0, 0, 0, 1}, LUX_GAMMA_NONE, 2.2};
+    bool temporal = false;
+};
+
+struct Job {
+    fs::path input;
+    std::vector<unsigned char> data;    ///< Raw bytes, then decoded pixels
+    std::vector<unsigned char> sensor;  ///< Sensor bytes kept for .zraw
+    bool container = false;             ///< Input was a .zraw
+    LuxZrawHeader header;               ///< Geometry of the sensor bytes
+    int width = 0;
+    int height = 0;
+    int cvType = CV_8UC1;
+};
+
+/// Blocking queue with a capacity, close() wakes every waiting consumer
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this]() { return queue_.size() < capacity_; });
+        queue_.push_back(std::move(item));
+        notEmpty_.notify_one();
+    }
+
+    /// Empty optional once the queue is closed and drained
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this]() { return !queue_.empty() || closed_; });
+        if (queue_.empty()) return std::nullopt;
+        T item = std::move(queue_.front());
+        queue_.pop_front();
+        notFull_.notify_one();
+        return item;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    bool closed_ = false;
+    std::deque<T> queue_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_, notFull_;
+};
+
+/// Close @c queue once @c producers threads have called done()
+template <typename T>
+class StageLatch {
+public:
+    StageLatch(BoundedQueue<T> &queue, int producers)
+        : queue_(queue), left_(producers) {}
+    void done() {
+        if (--left_ == 0) queue_.close();
+    }
+
+private:
+    BoundedQueue<T> &queue_;
+    std::atomic<int> left_;
+};
+
+/// '*' and '?' wildcards, enough for "captures/*.raw"
+bool wildcardMatch(const char *pattern, const char *str) {
+    if (*pattern == '\0') return *str == '\0';
+    if (*pattern == '*')
+        return wildcardMatch(pattern + 1, str) ||
+               (*str != '\0' && wildcardMatch(pattern, str + 1));
+    if (*str == '\0') return false;
+    return (*pattern == '?' || *pattern == *str) &&
+           wildcardMatch(pattern + 1, str + 1);
+}
+
+/// A directory gives its *.raw / *.zraw files, a glob is matched in its parent
+void collectInputs(const std::string &arg, std::vector<fs::path> &inputs) {
+    fs::path path(arg);
+    if (fs::is_directory(path)) {
+        for (auto &entry : fs::directory_iterator(path)) {
+            auto ext = entry.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (entry.is_regular_file() && (ext == ".raw" || ext == ".zraw"))
+                inputs.push_back(entry.path());
+        }
+    } else if (arg.find_first_of("*?") != std::string::npos) {
+        fs::path dir = path.parent_path().empty() ? "." : path.parent_path();
+        auto pattern = path.filename().string();
+        if (!fs::is_directory(dir)) return;
+        for (auto &entry : fs::directory_iterator(dir))
+            if (entry.is_regular_file() &&
+                wildcardMatch(pattern.c_str(),
+                              entry.path().filename().string().c_str()))
+                inputs.push_back(entry.path());
+    } else if (fs::is_regular_file(path)) {
+        inputs.push_back(path);
+    } else {
+        std::cerr << "No such file or directory: " << arg << std::endl;
+    }
+}
+
+/// "N" for every Bayer site, or "N,N,N,N"
+bool parseBlack(const std::string &value, LuxCalibConf &calib) {
+    int *b = calib.blackLevel;
+    int n = std::sscanf(value.c_str(), "%d,%d,%d,%d", b, b + 1, b + 2, b + 3);
+    if (n == 1) b[1] = b[2] = b[3] = b[0];
+    return n == 1 || n == 4;
+}
+
+/// Nine comma-separated coefficients, row-major
+bool parseCcm(const std::string &value, LuxColorConf &color) {
+    float *m = color.ccm;
+    return std::sscanf(value.c_str(), "%f,%f,%f,%f,%f,%f,%f,%f,%f", m, m + 1,
+                       m + 2, m + 3, m + 4, m + 5, m + 6, m + 7, m + 8) == 9;
+}
+
+/// "none", "srgb" or a power
+bool parseGamma(const std::string &value, LuxColorConf &color) {
+    if (value == "none" || value == "srgb") {
+        color.gamma = value == "none" ? LUX_GAMMA_NONE : LUX_GAMMA_SRGB;
+        return true;
+    }
+    color.gamma = LUX_GAMMA_POWER;
+    return std::sscanf(value.c_str(), "%lf", &color.power) == 1;
+}
+
+/// The QSettings ini of the GUI: "key=value" lines under [General]. A
+/// malformed or out of range value is reported with its line.
+bool loadIni(const std::string &fileName, ConvertConf &conf) {
+    std::ifstream fin(fileName);
+    if (!fin.is_open()) {
+        std::cerr << "Fail to read " << fileName << std::endl;
+        return false;
+    }
+    std::string line;
+    for (int lineNo = 1; std::getline(fin, line); ++lineNo) {
+        auto eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        auto key = line.substr(0, eq), value = line.substr(eq + 1);
+        while (!value.empty() &&
+               std::isspace(static_cast<unsigned char>(value.back())))
+            value.pop_back();
+        auto asBool = [&]() { return value == "true" || value == "1"; };
+        // The whole value must parse, std::stoi alone accepts "12abc"
+        size_t end = 0;
+        auto whole = [&]() {
+            if (end != value.size()) throw std::invalid_argument(value);
+        };
+        auto asInt = [&]() {
+            int v = std::stoi(value, &end);
+            whole();
+            return v;
+        };
+        auto asUInt64 = [&]() {
+            unsigned long long v = std::stoull(value, &end);
+            whole();
+            return v;
+        };
+        auto asDouble = [&]() {
+            double v = std::stod(value, &end);
+            whole();
+            return v;
+        };
+        bool ok = true;
+        try {
+            if (key == "workspace")
+                conf.workspace = asInt();
+            else if (key == "width")
+                conf.width = asInt();
+            else if (key == "height")
+                conf.height = asInt();
+            else if (key == "channels")
+                conf.channels = asInt();
+            else if (key == "bpp")
+                conf.bpp = asInt();
+            else if (key == "mode")
+                conf.mode = asInt();
+            else if (key == "endian")
+                conf.bigEndian = asBool();
+            else if (key == "crcType")
+                conf.check.crcType = asInt();
+            else if (key == "crcScope")
+                conf.check.scope = asInt();
+            else if (key == "crcPosition")
+                conf.check.position = asInt();
+            else if (key == "crcHeaderBytes")
+                conf.check.headerBytes = asInt();
+            else if (key == "crcPaddingBytes")
+                conf.check.paddingBytes = asInt();
+            else if (key == "crcCoverHeader")
+                conf.check.coverHeader = asBool();
+            else if (key == "crcBigEndian")
+                conf.check.crcBigEndian = asBool();
+            else if (key == "lineStride")
+                conf.layout.inStride = asUInt64();
+            else if (key == "topLines")
+                conf.layout.topLines = asInt();
+            else if (key == "bottomLines")
+                conf.layout.bottomLines = asInt();
+            else if (key == "threads")
+                conf.threads = asInt();
+            else if (key == "blackLevel")
+                ok = parseBlack(value, conf.calib);
+            else if (key == "blackRescale")
+                conf.calib.rescale = asBool() ? 1 : 0;
+            else if (key == "darkFrame")
+                conf.calibFrames[LUX_CALIB_DARK] = value;
+            else if (key == "flatFrame")
+                conf.calibFrames[LUX_CALIB_FLAT] = value;
+            else if (key == "defectMap")
+                conf.defectMap = value;
+            else if (key == "defectDynamic")
+                conf.defect.dynamic = asInt();
+            else if (key == "defectThreshold")
+                conf.defect.threshold = asDouble();
+            else if (key == "ccm")
+                ok = parseCcm(value, conf.color);
+            else if (key == "gamma")
+                ok = parseGamma(value, conf.color);
+        } catch (const std::exception &) {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << fileName << ":" << lineNo << ": wrong " << key
+                      << " '" << value << "'" << std::endl;
+            return false;
+        }
+    }
+    // No [packing] section is fine, a wrong one is not
+    int ret = LuxPackingLoad(fileName.c_str(), &conf.packing);
+    if (ret == -3) {
+        std::cerr << fileName << ": wrong [packing]" << std::endl;
+        return false;
+    }
+    if (ret == 0) conf.hasPacking = true;
+    return true;
+}
+
+/// .zraw: header + row-major frame, a LuxCodec stream: the decoded frame,
+/// otherwise the whole file
+bool readInput(Job &job) {
+    if (LuxZrawIsContainer(job.input.string().c_str()) == 1) {
+        LuxZrawFile file;
+        if (LuxZrawOpen(job.input.string().c_str(), &file) != 0) return false;
+        job.container = true;
+        job.header = file.header;
+        job.data.resize(LuxZrawFrameBytes(&file.header));
+        long long n = LuxZrawReadFrame(&file, job.data.data());
+        LuxZrawClose(&file);
+        return n >= 0;
+    }
+
+    std::ifstream fin(job.input, std::ios_base::binary);
+    if (!fin.is_open()) return false;
+    job.data.resize(fs::file_size(job.input));
+    fin.read(reinterpret_cast<char *>(job.data.data()), job.data.size());
+    if (fin.fail()) return false;
+
+    LuxCodecHeader stream;
+    if (LuxCodecInfo(job.data.data(), job.data.size(), &stream) == 0) {
+        std::vector<unsigned char> frame(stream.rawBytes);
+        if (LuxCodecDecode(job.data.data(), job.data.size(), frame.data(),
+                           frame.size()) < 0)
+            return false;
+        job.data.swap(frame);
+    }
+    return true;
+}
+
+/**
+ * @brief CRC strip (optional), endian, parse and demosaic of one frame.
+ * @return false with a message on stderr if the frame is rejected.
+ */
+bool decode(ConvertConf conf, Job &job) {
+    LUX_TRACE_SCOPE("decode");
+    if (job.container) {
+        conf.width = job.header.width;
+        conf.height = job.header.height;
+        conf.bpp = job.header.bpp;
+        conf.channels = job.header.channels;
+        conf.bigEndian = job.header.bigEndian != 0;
+        conf.workspace = job.header.highZero ? 1 : 0;
+        conf.bayerPattern = job.header.bayerPattern;
+        conf.check.crcType = LUX_CRC_NONE;
+    }
+    job.width = conf.width;
+    job.height = conf.height;
+
+    /// A packing descriptor runs as its bpp when it has one, otherwise the
+    /// frame is unpacked to 16-bit big endian, which keeps the windows
+    fs::path sidecar = job.input;
+    sidecar += ".pack";
+    if (!job.container) {
+        int ret = LuxPackingLoad(sidecar.string().c_str(), &conf.packing);
+        if (ret == -3) {
+            std::cerr << sidecar << ": wrong packing descriptor" << std::endl;
+            return false;
+        }
+        if (ret == 0) conf.hasPacking = true;
+    }
+    bool repack = false;
+    if (conf.hasPacking && !job.container) {
+        bool highZero = false;
+        if (LuxPackingToBpp(&conf.packing, &conf.bpp, &conf.bigEndian,
+                            &highZero) == 0)
+            conf.workspace = highZero ? 1 : 0;
+        else
+            repack = true;
+    }
+
+    const uint64_t samples = static_cast<uint64_t>(conf.width) * conf.channels;
+    uint64_t lineBytes = repack ? LuxPackingRowBytes(&conf.packing, samples)
+                                : LuxPackedBytes(samples, conf.bpp);
+    uint64_t length = lineBytes * conf.height;
+
+    /// Line padding and embedded data lines; with a CRC stage its records
+    /// describe the lines
+    if (!job.container && conf.check.crcType == LUX_CRC_NONE &&
+        LuxFrameLayoutBytes(&conf.layout, lineBytes, conf.height) != length) {
+        std::vector<unsigned char> frame(length);
+        if (LuxFrameCompact(job.data.data(), job.data.size(), lineBytes,
+                            conf.height, &conf.layout, frame.data()) < 0) {
+            std::cerr << job.input << ": frame does not match the line layout"
+                      << std::endl;
+            return false;
+        }
+        job.data.swap(frame);
+    }
+
+    if (conf.check.crcType != LUX_CRC_NONE) {
+        std::vector<unsigned char> payload(length);
+        int badLines[1];
+        long long bad = LuxCheckVerify(job.data.data(), job.data.size(),
+                                       lineBytes, conf.height, &conf.check,
+                                       payload.data(), badLines, 1);
+        if (bad < 0) {
+            std::cerr << job.input << ": wrong frame length or CRC config"
+                      << std::endl;
+            return false;
+        }
+        if (bad > 0)
+            std::cerr << job.input << ": " << bad
+                      << " lines failed the CRC check" << std::endl;
+        job.data.swap(payload);
+    }
+    if (repack) {
+        std::vector<unsigned char> frame(samples * conf.height * 2);
+        if (LuxPackingUnpack(&conf.packing, job.data.data(), job.data.size(),
+                             conf.width * conf.channels, conf.height,
+                             LUX_UNPACK_STRETCH16 | LUX_UNPACK_BIG_ENDIAN,
+                             reinterpret_cast<uint16_t *>(frame.data())) < 0) {
+            std::cerr << job.input << ": frame does not match the packing"
+                      << std::endl;
+            return false;
+        }
+        job.data.swap(frame);
+        conf.bpp = 16;
+        conf.bigEndian = true;
+        conf.workspace = 0;
+    }
+    if (!job.container) {
+        ::memset(&job.header, 0, sizeof(job.header));
+        job.header.width = conf.width;
+        job.header.height = conf.height;
+        job.header.bpp = conf.bpp;
+        job.header.channels = conf.channels;
+        job.header.bigEndian = conf.bigEndian;
+        job.header.highZero = conf.workspace == 1;
+        job.header.bayerPattern = conf.bayerPattern;
+        job.header.dataFormat = conf.dataFormat;
+    }
+    // The parse below works in place
+    if (conf.format == "zraw") job.sensor = job.data;
+
+    // Before the parse: it swaps little endian frames in place
+    LuxAutoResult tune;
+    bool tuned = false;
+    if (conf.awb != LUX_AWB_NONE || conf.autoLevels) {
+        LuxAutoConf autoConf{conf.awb, conf.autoLevels, std::min(conf.mode, 4),
+                             conf.bayerPattern, 0, 0.5, 99.5};
+        tuned = LuxAutoTune(job.data.data(), job.data.size(),
+                            conf.width * conf.channels, conf.height, conf.bpp,
+                            conf.bigEndian, conf.workspace == 1, &autoConf,
+                            &tune) > 0;
+        if (!tuned)
+            std::cerr << job.input << ": auto tune failed, fixed parameters"
+                      << std::endl;
+    }
+    int mode = tuned && conf.autoLevels ? tune.mode : conf.mode;
+
+    int outChannels = conf.dataFormat == 1 ? 1 : 3;
+    std::vector<unsigned char> out(static_cast<size_t>(conf.width) *
+                                   conf.height * outChannels);
+    int code = conf.dataFormat == 1 ? cv::COLOR_BayerRG2GRAY
+                                    : cv::COLOR_BayerRG2RGB;
+    long long k = 0;
+    if (tuned && conf.dataFormat == 2)
+        k = LuxLoadImageDataEnhanced2(
+            job.data.data(), job.data.size(), conf.dataFormat, conf.width,
+            conf.height, conf.bpp, conf.channels, out.data(), conf.bigEndian,
+            conf.workspace == 1, mode, code, true, conf.bayerPattern, tune.r,
+            tune.g, tune.b);
+    else
+        k = LuxLoadImageDataEnhanced(
+            job.data.data(), job.data.size(), conf.dataFormat, conf.width,
+            conf.height, conf.bpp, conf.channels, out.data(), conf.bigEndian,
+            conf.workspace == 1, mode, code);
+    if (k <= 0) {
+        std::cerr << job.input << ": decode failed (" << k << ")" << std::endl;
+        return false;
+    }
+    job.data.swap(out);
+    job.cvType = outChannels == 1 ? CV_8UC1 : CV_8UC3;
+    return true;
+}
+
+/// Container with the sensor bytes and a downscaled preview of the decode
+bool encodeZraw(const ConvertConf &conf, Job &job, const fs::path &out) {
+    /// The layout of the sensor bytes, after a repack of the packing
+    LuxZrawHeader header = job.header;
+    header.flags &= ~(LUX_ZRAW_PREVIEW | LUX_ZRAW_COMPRESSED);
+    if (conf.compress) {
+        header.flags = (header.flags & ~LUX_ZRAW_TILED) | LUX_ZRAW_COMPRESSED;
+    } else if (conf.tileWidth > 0 && conf.tileHeight > 0) {
+        header.flags |= LUX_ZRAW_TILED;
+        header.tileWidth = conf.tileWidth;
+        header.tileHeight = conf.tileHeight;
+    } else {
+        header.flags &= ~LUX_ZRAW_TILED;
+    }
+
+    cv::Mat preview;
+    int side = std::max(job.width, job.height);
+    if (conf.previewSide > 0 && side > 0) {
+        double scale = std::min(1.0, conf.previewSide / double(side));
+        cv::Mat image(job.height, job.width, job.cvType, job.data.data());
+        cv::resize(image, preview, cv::Size(), scale, scale, cv::INTER_AREA);
+        header.flags |= LUX_ZRAW_PREVIEW;
+        header.previewWidth = preview.cols;
+        header.previewHeight = preview.rows;
+        header.previewType = job.cvType;
+    }
+
+    return LuxZrawWrite(out.string().c_str(), &header, job.sensor.data(),
+                        preview.empty() ? nullptr : preview.data) > 0;
+}
+
+bool encode(const ConvertConf &conf, Job &job) {
+    LUX_TRACE_SCOPE("encode");
+    fs::path out = fs::path(conf.outDir) / job.input.stem();
+    out += "." + conf.format;
+
+    if (conf.format == "zraw") return encodeZraw(conf, job, out);
+
+    if (conf.format == "raw") {
+        std::ofstream fout(out, std::ios_base::binary);
+        fout.write(reinterpret_cast<const char *>(job.data.data()),
+                   job.data.size());
+        return !fout.fail();
+    }
+
+    cv::Mat image(job.height, job.width, job.cvType, job.data.data());
+    if (job.cvType == CV_8UC3) cv::cvtColor(image, image, cv::COLOR_RGB2BGR);
+    return cv::imwrite(out.string(), image);
+}
+
+/// --temporal: the frames of @c inputs, in name order, through
+/// LuxTemporalFromFiles() / LuxTemporalFromSequence()
+int runTemporal(const ConvertConf &conf, std::vector<fs::path> inputs) {
+    const int width = conf.width * conf.channels;
+    const bool highZero = conf.workspace == 1;
+    std::vector<float> mean(static_cast<size_t>(width) * conf.height);
+    std::vector<float> noise(mean.size());
+    LuxTemporalResult result;
+    long long ret;
+    if (inputs.size() == 1) {
+        ret = LuxTemporalFromSequence(inputs[0].string().c_str(), 0, width,
+                                      conf.height, conf.bpp, conf.bigEndian,
+                                      highZero, mean.data(), noise.data(),
+                                      &result);
+    } else {
+        std::sort(inputs.begin(), inputs.end());
+        std::vector<std::string> names;
+        std::vector<const char *> files;
+        for (auto &p : inputs) names.push_back(p.string());
+        for (auto &n : names) files.push_back(n.c_str());
+        ret = LuxTemporalFromFiles(files.data(), static_cast<int>(files.size()),
+                                   width, conf.height, conf.bpp,
+                                   conf.bigEndian, highZero, mean.data(),
+                                   noise.data(), &result);
+    }
+    if (ret < 0) {
+        std::cerr << "Temporal analysis failed: " << ret << std::endl;
+        return 2;
+    }
+
+    auto write = [&](const char *name, std::vector<float> &map) {
+        cv::Mat image(conf.height, width, CV_32FC1, map.data());
+        return cv::imwrite((fs::path(conf.outDir) / name).string(), image);
+    };
+    const bool ok = write("temporal_mean.tiff", mean) &&
+                    write("temporal_noise.tiff", noise);
+    std::cout << "frames: " << result.frames << std::endl;
+    for (int s = 0; s < 4; ++s) {
+        const LuxTemporalChannel &c = result.channels[s];
+        std::cout << "site " << (s >> 1) << "," << (s & 1)
+                  << ": mean " << c.mean << ", temporal noise "
+                  << c.temporalNoise << ", spatial noise " << c.spatialNoise
+                  << ", max noise " << c.maxNoise << std::endl;
+    }
+    return ok ? 0 : 2;
+}
+
+/// 8, 12, 16 or the MIPI packings by name, -1 if unknown
+int parseBpp(const std::string &value) {
+    if (value == "raw10") return LUX_BPP_RAW10;
+    if (value == "raw12") return LUX_BPP_RAW12;
+    if (value == "raw14") return LUX_BPP_RAW14;
+    return value.empty() ? -1 : std::atoi(value.c_str());
+}
+
+int usage(const char *argv0) {
+    std::cerr << "Usage: " << argv0
+              << " [--ini para.ini] [--workspace 0|1] [--width N] "
+                 "[--height N] [--bpp 8|12|16|raw10|raw12|raw14] "
+                 "[--channels N] [--mode 0-5] "
+                 "[--little-endian] [--data-format 1|2] [--crc N] "
+                 "[--crc-scope line|frame] "
+                 "[--format tiff|png|bmp|jpg|raw|zraw] [--bayer 0-3] "
+                 "[--tile WxH] [--preview N] [--compress] "
+                 "[--awb gray|white] [--auto-levels] "
+                 "[--normalize LOW,HIGH] [--packing FILE|SPEC] "
+                 "[--line-stride N] [--top-lines N] [--bottom-lines N] "
+                 "[--black N[,N,N,N]] [--no-rescale] [--dark FILE] "
+                 "[--flat FILE] [--defects FILE] [--defect-dynamic T] "
+                 "[--ccm M0,...,M8] [--gamma srgb|none|P] [--temporal] "
+                 "[-j N] [--readers N] [--encoders N] [--threads N] "
+                 "-o <outDir> "
+                 "<dir | glob | file>..."
+              << std::endl;
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    ConvertConf conf;
+    std::vector<fs::path> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        auto next = [&]() -> std::string {
+            return i + 1 < argc ? argv[++i] : "";
+        };
+        auto nextInt = [&]() {
+            auto v = next();
+            return v.empty() ? -1 : std::atoi(v.c_str());
+        };
+        if (arg == "--ini") {
+            if (!loadIni(next(), conf)) return 1;
+        } else if (arg == "--workspace")
+            conf.workspace = nextInt();
+        else if (arg == "--width")
+            conf.width = nextInt();
+        else if (arg == "--height")
+            conf.height = nextInt();
+        else if (arg == "--bpp")
+            conf.bpp = parseBpp(next());
+        else if (arg == "--channels")
+            conf.channels = nextInt();
+        else if (arg == "--mode")
+            conf.mode = nextInt();
+        else if (arg == "--little-endian")
+            conf.bigEndian = false;
+        else if (arg == "--data-format")
+            conf.dataFormat = nextInt();
+        else if (arg == "--crc")
+            conf.check.crcType = nextInt();
+        else if (arg == "--crc-scope")
+            conf.check.scope =
+                next() == "frame" ? LUX_CHECK_FRAME : LUX_CHECK_LINE;
+        else if (arg == "--format")
+            conf.format = next();
+        else if (arg == "--bayer")
+            conf.bayerPattern = nextInt();
+        else if (arg == "--tile")
+            std::sscanf(next().c_str(), "%dx%d", &conf.tileWidth,
+                        &conf.tileHeight);
+        else if (arg == "--preview")
+            conf.previewSide = nextInt();
+        else if (arg == "--compress")
+            conf.compress = true;
+        else if (arg == "--awb")
+            conf.awb = next() == "white" ? LUX_AWB_WHITE_PATCH
+                                         : LUX_AWB_GRAY_WORLD;
+        else if (arg == "--auto-levels")
+            conf.autoLevels = true;
+        else if (arg == "--normalize") {
+            LuxNormalizeConf range{0, 100};
+            if (std::sscanf(next().c_str(), "%lf,%lf", &range.lowPercentile,
+                            &range.highPercentile) != 2 ||
+                LuxSetNormalizeConf(&range) != 0)
+                return usage(argv[0]);
+        } else if (arg == "--packing") {
+            auto spec = next();
+            int ret = fs::exists(spec)
+                          ? LuxPackingLoad(spec.c_str(), &conf.packing)
+                          : LuxPackingParse(spec.c_str(), &conf.packing);
+            if (ret != 0) return usage(argv[0]);
+            conf.hasPacking = true;
+        } else if (arg == "--line-stride") {
+            auto v = next();
+            conf.layout.inStride = std::strtoull(v.c_str(), nullptr, 10);
+        } else if (arg == "--top-lines")
+            conf.layout.topLines = nextInt();
+        else if (arg == "--bottom-lines")
+            conf.layout.bottomLines = nextInt();
+        else if (arg == "--black") {
+            if (!parseBlack(next(), conf.calib)) return usage(argv[0]);
+        } else if (arg == "--no-rescale")
+            conf.calib.rescale = 0;
+        else if (arg == "--dark")
+            conf.calibFrames[LUX_CALIB_DARK] = next();
+        else if (arg == "--flat")
+            conf.calibFrames[LUX_CALIB_FLAT] = next();
+        else if (arg == "--defects")
+            conf.defectMap = next();
+        else if (arg == "--defect-dynamic") {
+            conf.defect.dynamic = 1;
+            conf.defect.threshold = std::atof(next().c_str());
+        } else if (arg == "--ccm") {
+            if (!parseCcm(next(), conf.color)) return usage(argv[0]);
+        } else if (arg == "--gamma") {
+            if (!parseGamma(next(), conf.color)) return usage(argv[0]);
+        } else if (arg == "--temporal")
+            conf.temporal = true;
+        else if (arg == "-o")
+            conf.outDir = next();
+        else if (arg == "-j")
+            conf.decoders = nextInt();
+        else if (arg == "--readers")
+            conf.readers = nextInt();
+        else if (arg == "--encoders")
+            conf.encoders = nextInt();
+        else if (arg == "--threads")
+            conf.threads = nextInt();
+        else if (!arg.empty() && arg[0] == '-')
+            return usage(argv[0]);
+        else
+            collectInputs(arg, inputs);
+    }
+
+    // .zraw inputs bring their geometry, the others need it given
+    const bool containers =
+        !conf.temporal &&
+        std::all_of(inputs.begin(), inputs.end(), [](const fs::path &p) {
+            return LuxZrawIsContainer(p.string().c_str()) == 1;
+        });
+    if ((!containers &&
+         (conf.width <= 0 || conf.height <= 0 || conf.channels <= 0)) ||
+        conf.outDir.empty() || inputs.empty())
+        return usage(argv[0]);
+    if (conf.decoders <= 0)
+        conf.decoders =
+            std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    conf.readers = std::max(1, conf.readers);
+    conf.encoders = std::max(1, conf.encoders);
+    LuxSetNumThreads(conf.threads);
+    if (LuxSetCalibConf(&conf.calib) != 0) return usage(argv[0]);
+    for (int kind : {LUX_CALIB_DARK, LUX_CALIB_FLAT})
+        if (!conf.calibFrames[kind].empty() &&
+            LuxLoadCalibFrame(kind, conf.calibFrames[kind].c_str(),
+                              conf.width * conf.channels, conf.height,
+                              conf.bpp, conf.bigEndian,
+                              conf.workspace == 1) < 0)
+            return usage(argv[0]);
+    if (LuxSetDefectConf(&conf.defect) != 0 ||
+        (!conf.defectMap.empty() &&
+         LuxLoadDefectMap(conf.defectMap.c_str(), conf.width * conf.channels,
+                          conf.height) < 0))
+        return usage(argv[0]);
+    if (LuxSetColorConf(&conf.color) != 0) return usage(argv[0]);
+    fs::create_directories(conf.outDir);
+    if (conf.temporal) {
+        int ret = runTemporal(conf, inputs);
+        LuxWriterShutdown();
+        return ret;
+    }
+
+    // Bounded so a fast reader can not load the whole night into memory
+    size_t depth = static_cast<size_t>(conf.decoders) * 2;
+    BoundedQueue<fs::path> paths(inputs.size() + 1);
+    BoundedQueue<Job> readQueue(depth), decodedQueue(depth);
+    StageLatch<Job> readDone(readQueue, conf.readers);
+    StageLatch<Job> decodeDone(decodedQueue, conf.decoders);
+
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<int> converted{0}, failed{0};
+
+    for (auto &p : inputs) paths.push(p);
+    paths.close();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < conf.readers; ++i)
+        threads.emplace_back([&]() {
+            while (auto path = paths.pop()) {
+                LUX_TRACE_SCOPE("read");
+                Job job;
+                job.input = *path;
+                if (!readInput(job)) {
+                    std::cerr << "Fail to read " << job.input << std::endl;
+                    ++failed;
+                    continue;
+                }
+                bytesIn += job.data.size();
+                readQueue.push(std::move(job));
+            }
+            readDone.done();
+        });
+
+    for (int i = 0; i < conf.decoders; ++i)
+        threads.emplace_back([&]() {
+            while (auto job = readQueue.pop()) {
+                if (decode(conf, *job))
+                    decodedQueue.push(std::move(*job));
+                else
+                    ++failed;
+            }
+            decodeDone.done();
+        });
+
+    for (int i = 0; i < conf.encoders; ++i)
+        threads.emplace_back([&]() {
+            while (auto job = decodedQueue.pop()) {
+                if (encode(conf, *job)) {
+                    ++converted;
+                } else {
+                    std::cerr << "Fail to write " << job->input << std::endl;
+                    ++failed;
+                }
+            }
+        });
+
+    for (auto &t : threads) t.join();
+    // Joined before the statics go, see LuxWriterShutdown()
+    if (LuxWriterShutdown() > 0) ++failed;
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::cout << "files: " << converted << " converted, " << failed
+              << " failed, " << seconds << " s, " << converted / seconds
+              << " files/s, " << bytesIn / seconds / 1e6 << " MB/s"
+              << std::endl;
+
+#ifdef LUX_ENABLE_TRACE
+    LuxTraceWriteSummary(nullptr);
+#endif
+    return failed > 0 ? 2 : 0;
+}
@@ -7,6 +7,7 @@
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <vector>
 
 class DisplayUtils {
 private:
@@ -37,7 +38,9 @@ public:
         const unsigned char* inData, int dataFormat, bool saveTiffFlag,
         std::string& tiffFileName, int mode, bool isBigEndian,
         unsigned long long width, unsigned long long height, int bitDepth,
-        int channel);
+        int channel, const LuxCheckConf* checkConf = nullptr,
+        std::vector<int>* badLines = nullptr,
+        const LuxFrameLayout* layout = nullptr);
 
 private:
     bool createDirIfNot(const std::string& dirName);
@@ -80,6 +80,10 @@ const std::string RELAY_FILE = kBASE_DIR + "internal/internal_only_disp.raw";
 // para.ini - for .raw
 const std::string kPARA_INI = kBASE_DIR + "internal/para.ini";
 
+// Stage timings, written on exit when built with ZIWI_ENABLE_TRACE
+const std::string kTRACE_FILE = kBASE_DIR + "internal/trace.json";
+const std::string kTRACE_SUMMARY = kBASE_DIR + "internal/trace_summary.txt";
+
 #ifdef _WIN32
 const QFont FONT = QFont("微软雅黑", 9);
 #else
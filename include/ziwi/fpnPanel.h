@@ -0,0 +1,51 @@
+#pragma once
+
+#include <imgCore/LuxProfile.h>
+
+#include <QDockWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <vector>
+
+namespace Lux {
+namespace ziwi {
+
+class ProfilePlot;
+
+/**
+ * @brief FpnPanel - Side panel with the row and column mean profiles of each
+ * Bayer channel (fixed pattern noise), of the raw shown or of the average of
+ * a sequence of frames.
+ *
+ */
+class FpnPanel : public QDockWidget {
+    Q_OBJECT
+
+    FpnPanel(const FpnPanel&) = delete;
+    FpnPanel& operator=(const FpnPanel&) = delete;
+
+private:
+    ProfilePlot* rowPlot_;
+    ProfilePlot* columnPlot_;
+    QTableWidget* table_;
+    QLabel* sourceLabel_;
+    QPushButton* averageButton_;
+
+public:
+    explicit FpnPanel(QWidget* parent = nullptr);
+
+    /// The profiles in the layout of LuxComputeFpnProfiles()
+    void setProfiles(const LuxFpnResult& result,
+                     const std::vector<float>& rowMeans,
+                     const std::vector<float>& columnMeans,
+                     const QString& source);
+    void clear();
+
+signals:
+    /// The user asks for the profiles of the average of several frames
+    void averageRequested();
+};
+
+}  // namespace ziwi
+}  // namespace Lux
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <imgCore/LuxUnpack.h>
+
+#include <QImage>
+#include <functional>
+#include <list>
+#include <string>
+#include <utility>
+
+namespace Lux {
+namespace ziwi {
+
+/* Everything the 8-bit display of a raw depends on. */
+struct FrameKey {
+    std::string fileName;
+    int width;
+    int height;
+    int bpp;
+    int channels;
+    int mode;
+    bool bigEndian;
+    unsigned char workspace;
+    int crcType;
+    // LuxPackingFormat() of a packing without a bpp of its own, the file is
+    // unpacked into 16-bit big endian; empty: the file has bpp
+    std::string packing;
+    // Line padding and embedded data lines of the file, outStride unused
+    LuxFrameLayout layout;
+    // Calibration in force (LuxCalib.h), empty: none
+    std::string calibration;
+    // Defect map and detector in force (LuxDefect.h), empty: none
+    std::string defects;
+
+    bool operator==(const FrameKey& o) const {
+        return fileName == o.fileName && width == o.width &&
+               height == o.height && bpp == o.bpp && channels == o.channels &&
+               mode == o.mode && bigEndian == o.bigEndian &&
+               workspace == o.workspace && crcType == o.crcType &&
+               packing == o.packing && layout.inStride == o.layout.inStride &&
+               layout.topLines == o.layout.topLines &&
+               layout.bottomLines == o.layout.bottomLines &&
+               calibration == o.calibration && defects == o.defects;
+    }
+};
+
+/**
+ * @brief FrameCache - Decoded display frames shared by the views. Showing a
+ * frame in several views, or coming back to it, costs no decode; the least
+ * recently used frames are dropped beyond the capacity.
+ *
+ */
+class FrameCache {
+public:
+    /* Decode @c key, a null QImage if it fails (which is not cached). */
+    using Decoder = std::function<QImage(const FrameKey&)>;
+
+private:
+    size_t capacity_;
+    // front: most recently used. QImage is implicitly shared, the views get
+    // a reference to the cached pixels, not a copy.
+    std::list<std::pair<FrameKey, QImage>> frames_;
+    size_t hits_;
+    size_t misses_;
+
+public:
+    explicit FrameCache(size_t capacity = 8);
+
+    QImage get(const FrameKey& key, const Decoder& decode);
+    void clear() { frames_.clear(); }
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+};
+
+}  // namespace ziwi
+}  // namespace Lux
@@ -6,7 +6,7 @@
 
 #include <string>
 
-enum ImageType { UNKNOWN = -1, RAW, PNG, JPG, TIFF, SVG };
+enum ImageType { UNKNOWN = -1, RAW, PNG, JPG, TIFF, SVG, ZRAW };
 
 struct ImageInfo {
     unsigned char* data_;
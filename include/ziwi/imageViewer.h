@@ -11,6 +11,7 @@
 #include <QWidget>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 namespace Lux {
 namespace ziwi {
@@ -120,6 +121,7 @@ private:
     QGraphicsScene *scene_;
     SynchableGraphicsView *view_;
     std::unique_ptr<QGraphicsPixmapItem> pixmapItem_;
+    std::vector<QGraphicsRectItem *> lineMarks_;
     QGridLayout *layout_;
     QPixmap *backgroundPiximageItem_;
     double zoomFactor_;
@@ -133,9 +135,16 @@ public:
     bool handDragging() const { return view_->handDragging(); }
     void dumpTransform() { view_->dumpTransform(view_->transform(), "    "); }
 
+    /* The view itself, e.g. to keep other views in step with it. */
+    SynchableGraphicsView *view() const { return view_; }
+
     QPixmap pixmap() { return pixmapItem_->pixmap(); }
     void setImage(const QPixmap &pixmap);
 
+    /* Highlight image lines, e.g. the lines which failed the CRC check. */
+    void setLineMarks(const std::vector<int> &lines);
+    void clearLineMarks();
+
 signals:
     void sceneChanged();
     void transformChanged();
@@ -2,16 +2,22 @@
 
 #include <ziwi/about.h>
 #include <ziwi/algorithm.h>
+#include <ziwi/fpnPanel.h>
+#include <ziwi/frameCache.h>
 #include <ziwi/imageViewer.h>
 #include <ziwi/parameterConfigDialog.h>
 #include <ziwi/imageInfo.h>
+#include <ziwi/statsPanel.h>
+#include <ziwi/viewGrid.h>
 
 #include <QAction>
 #include <QColor>
 #include <QIcon>
 #include <QLabel>
 #include <QMainWindow>
+#include <QPointer>
 #include <QPushButton>
+#include <QTimer>
 #include <memory>
 
 QT_BEGIN_NAMESPACE
@@ -38,6 +44,18 @@ private:
     int height_;
     int bpp_;
     int channel_;
+    int crcType_;
+    int crcScope_;
+    // The raw shown last, the source of the mode grid
+    std::string rawFile_;
+    // Packing descriptor of rawFile_ without a bpp of its own, see FrameKey
+    std::string packing_;
+    // Calibration in force, see FrameKey; and the frames loaded
+    std::string calibration_;
+    std::string calibFramesLoaded_[2];
+    // Defect correction in force, see FrameKey; and the map file loaded
+    std::string defects_;
+    std::string defectMapLoaded_;
 
     // QGraphicsScene* scene_;
     Lux::ziwi::ImageViewer* imageViewer_;
@@ -47,6 +65,18 @@ private:
     DisplayUtils* imgCore_;
     Lux::ziwi::ParaConfDialog* paraConfDialog_;
 
+    // Decoded frames shared by the compare views
+    Lux::ziwi::FrameCache frameCache_;
+    QPointer<Lux::ziwi::ViewGrid> compare_;
+
+    // Statistics of the visible region, recomputed once the view settles
+    Lux::ziwi::StatsPanel* statsPanel_;
+    QTimer* statsTimer_;
+    // Samples of rawFile_, empty if no raw is shown
+    std::vector<unsigned char> statsFrame_;
+    // Row / column profiles of statsFrame_ or of an average of frames
+    Lux::ziwi::FpnPanel* fpnPanel_;
+
 public:
     DeCompImgViewMainWindow(QPixmap* pixmap = nullptr,
                             std::string name = "Ziwi");
@@ -56,9 +86,25 @@ private:
     void buildStatusBar();
     void buildAction();
     void buildImageViewer();
+    void buildStatsPanel();
+    void buildFpnPanel();
 
     ImageInfo* loadImageData();
+    void showContainer(const ImageInfo* imgInfo);
     void paramConfig();
+    bool applyPacking(const std::string& rawFile);
+    void applyCalibration();
+    void applyDefects(const std::string& rawFile);
+    LuxCheckConf checkConfig() const;
+    LuxFrameLayout frameLayout() const;
+    FrameKey frameKey(const std::string& fileName) const;
+    bool readFrame(const FrameKey& key,
+                   std::vector<unsigned char>& frame) const;
+    bool readPayload(const FrameKey& key, uint64_t lineBytes,
+                     std::vector<unsigned char>& frame) const;
+    QImage decodeFrame(const FrameKey& key) const;
+    QImage diffFrames(const FrameKey& a, const FrameKey& b,
+                      QString* caption) const;
     void updateTittle(std::string name);
 
 private slots:
@@ -68,6 +114,11 @@ private slots:
     void onFitWidth();
     void onFitHeight();
     void onAbout();
+    void onModeGrid();
+    void onCompare();
+    void updateStats();
+    void updateFpn();
+    void onFpnAverage();
     void transformChanged();
     void scrollChanged();
 };
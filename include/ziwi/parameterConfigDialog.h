@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <QComboBox>
 #include <QDialog>
 #include <QLineEdit>
 #include <QRadioButton>
@@ -14,9 +15,14 @@ struct ParaConf {
     unsigned int width;
     unsigned int height;
     unsigned int channels;
+    // 8, 12, 16 or LuxMipiBpp
     unsigned int bpp;
     unsigned int mode;
     bool bigEndian;
+    // LuxCRCType, 0 - no check
+    int crcType;
+    // LuxCheckScope, 0 - every line, 1 - whole frame
+    int crcScope;
 };
 
 class ParaConfDialog : public QDialog {
@@ -33,6 +39,10 @@ private:
     QRadioButton* radio8_;
     QRadioButton* radio12_;
     QRadioButton* radio16_;
+    // MIPI CSI-2 packings
+    QRadioButton* radioRaw10_;
+    QRadioButton* radioRaw12_;
+    QRadioButton* radioRaw14_;
 
     QRadioButton* radioBigEndian_;
     QRadioButton* radioLittleEndian_;
@@ -44,6 +54,9 @@ private:
     QRadioButton* radio58_;
     QRadioButton* radioAll8_;
 
+    QComboBox* crcType_;
+    QComboBox* crcScope_;
+
     ParaConf* conf_;
 
 public:
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <imgCore/LuxStats.h>
+
+#include <QDockWidget>
+#include <QLabel>
+#include <QTableWidget>
+
+namespace Lux {
+namespace ziwi {
+
+/**
+ * @brief StatsPanel - Side panel with the statistics of each Bayer channel
+ * (count, mean, std, min, max, percentiles) of the region shown.
+ *
+ */
+class StatsPanel : public QDockWidget {
+    Q_OBJECT
+
+    StatsPanel(const StatsPanel&) = delete;
+    StatsPanel& operator=(const StatsPanel&) = delete;
+
+private:
+    QTableWidget* table_;
+    QLabel* roiLabel_;
+
+public:
+    explicit StatsPanel(QWidget* parent = nullptr);
+
+    void setStats(const LuxBayerStats& stats);
+    void clear();
+};
+
+}  // namespace ziwi
+}  // namespace Lux
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <ziwi/imageViewer.h>
+
+#include <QFrame>
+#include <QGridLayout>
+#include <QLabel>
+#include <QPixmap>
+#include <QTimer>
+#include <vector>
+
+namespace Lux {
+namespace ziwi {
+
+/**
+ * @brief ViewSyncGroup - Keep the zoom and the scroll of several
+ * SynchableGraphicsViews in step: the others follow the view the user zooms
+ * or pans. Bursts of changes (wheel, drag) are coalesced, the followers move
+ * at most once per throttle interval.
+ */
+class ViewSyncGroup : public QObject {
+    Q_OBJECT
+
+    ViewSyncGroup(const ViewSyncGroup&) = delete;
+    ViewSyncGroup& operator=(const ViewSyncGroup&) = delete;
+
+private:
+    std::vector<SynchableGraphicsView*> views_;
+    bool syncing_;
+    QTimer* throttle_;
+    SynchableGraphicsView* pending_;
+
+public:
+    explicit ViewSyncGroup(QObject* parent = nullptr);
+
+    void addView(SynchableGraphicsView* view);
+    void clear();
+
+    /* Milliseconds between two updates of the followers, 0: immediate. */
+    void setThrottle(int ms) { throttle_->setInterval(ms); }
+
+    /* Make every view follow @c leader at once, it may be outside the group. */
+    void follow(SynchableGraphicsView* leader);
+    /* Follow @c leader at the next throttle tick. */
+    void schedule(SynchableGraphicsView* leader);
+
+private slots:
+    void onViewChanged();
+    void onThrottle();
+};
+
+/**
+ * @brief ViewGrid - rows x cols synchronized views, each with a caption.
+ *
+ */
+class ViewGrid : public QFrame {
+    Q_OBJECT
+
+    ViewGrid(const ViewGrid&) = delete;
+    ViewGrid& operator=(const ViewGrid&) = delete;
+
+private:
+    struct Cell {
+        QGraphicsScene* scene;
+        SynchableGraphicsView* view;
+        QGraphicsPixmapItem* item;
+        QLabel* caption;
+    };
+
+    std::vector<Cell> cells_;
+    QGridLayout* layout_;
+    ViewSyncGroup* sync_;
+    double zoomFactorDelta_;
+
+public:
+    ViewGrid(int rows, int cols, QWidget* parent = nullptr);
+
+    int count() const { return static_cast<int>(cells_.size()); }
+    SynchableGraphicsView* view(int index) { return cells_[index].view; }
+
+    void setImage(int index, const QPixmap& pixmap, const QString& caption);
+    /* Zoom and scroll the grid like @c leader, e.g. the main viewer. */
+    void followView(SynchableGraphicsView* leader) { sync_->schedule(leader); }
+
+public slots:
+    void fitToWindow();
+    void actualSize();
+
+private slots:
+    void handleWheelNotches(float notches);
+};
+
+}  // namespace ziwi
+}  // namespace Lux
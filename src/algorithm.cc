@@ -1,6 +1,8 @@
 
+#include <imgCore/LuxTrace.h>
 #include <ziwi/algorithm.h>
 
+#include <algorithm>
 #include <fstream>
 
 DisplayUtils::DisplayUtils(bool useFileRelay, std::string relayFile)
@@ -40,7 +42,8 @@ unsigned char* DisplayUtils::LoadDataForDisplaySelectableMode(
     unsigned char workspace, const unsigned char* inData, int dataFormat,
     bool saveTiffFlag, std::string& tiffFileName, int mode, bool isBigEndian,
     unsigned long long width, unsigned long long height, int bitDepth,
-    int channel) {
+    int channel, const LuxCheckConf* checkConf, std::vector<int>* badLines,
+    const LuxFrameLayout* layout) {
     auto code = Unkow;
     if (dataFormat == 1)
         code = BayerRG2GRAY;
@@ -51,26 +54,57 @@ unsigned char* DisplayUtils::LoadDataForDisplaySelectableMode(
         return nullptr;
     }
 
+    bool checked = checkConf != nullptr && checkConf->crcType != LUX_CRC_NONE;
+    // The CRC records describe the lines of a checked frame
+    if (checked) layout = nullptr;
+    if (badLines != nullptr) badLines->clear();
+
     if (useFileRelay_) {
-        std::ofstream ofs(relayFile_, std::ios::binary);
-        std::cout << "Length: "
-                  << static_cast<size_t>(height * width * channel * bitDepth /
-                                         8.0)
-                  << std::endl;
-        ofs.write(reinterpret_cast<const char*>(inData),
-                  static_cast<size_t>(height * width * channel * bitDepth /
-                                      8.0));  // NOLINT
-        if (ofs.fail()) {
-            std::cerr << "Error: failed to write relay file." << std::endl;
-            ofs.close();
-            return nullptr;
-        } else {
-            ofs.close();
+        // With a CRC stage the input still carries the link framing
+        uint64_t lineBytes = LuxPackedBytes(
+            static_cast<uint64_t>(width) * channel, bitDepth);
+        size_t inLength = LuxFrameLayoutBytes(layout, lineBytes, height);
+        if (checked)
+            inLength = LuxCheckFrameBytes(checkConf, lineBytes, height);
+
+        {
+            LUX_TRACE_SCOPE("relay_write");
+            std::ofstream ofs(relayFile_, std::ios::binary);
+            std::cout << "Length: " << inLength << std::endl;
+            ofs.write(reinterpret_cast<const char*>(inData), inLength);
+            if (ofs.fail()) {
+                std::cerr << "Error: failed to write relay file." << std::endl;
+                ofs.close();
+                return nullptr;
+            } else {
+                ofs.close();
+            }
         }
 
         // 0 - CE7
         long long len = INT_MIN;
-        if (workspace == 0) {
+        if (checked && (workspace == 0 || workspace == 1)) {
+            std::vector<int> lines(height);
+            int badCount = 0;
+            len = LuxLoadImageDataFromFileChecked(
+                relayFile_.c_str(), dataFormat, width, height, bitDepth,
+                channel, relayFile_.c_str(), tiffFileName.c_str(), isBigEndian,
+                workspace == 1, saveTiffFlag, mode, code, checkConf,
+                lines.data(), static_cast<int>(lines.size()), &badCount);
+            if (badCount > 0)
+                std::cerr << "Warning: " << badCount
+                          << " lines failed the CRC check." << std::endl;
+            if (badLines != nullptr)
+                badLines->assign(lines.begin(),
+                                 lines.begin() + std::min<size_t>(
+                                                     badCount, lines.size()));
+        } else if (layout != nullptr && (workspace == 0 || workspace == 1)) {
+            // Line padding and embedded data lines are skipped in place
+            len = LuxLoadImageDataFromFileStrided(
+                relayFile_.c_str(), dataFormat, width, height, bitDepth,
+                channel, relayFile_.c_str(), tiffFileName.c_str(), isBigEndian,
+                workspace == 1, saveTiffFlag, mode, code, layout);
+        } else if (workspace == 0) {
             len = LuxLoadImageDataFromFileEnhanced(
                 relayFile_.c_str(), dataFormat, width, height, bitDepth,
                 channel, relayFile_.c_str(), tiffFileName.c_str(), isBigEndian,
@@ -86,6 +120,7 @@ unsigned char* DisplayUtils::LoadDataForDisplaySelectableMode(
         }
         if (len < 0) return nullptr;
 
+        LUX_TRACE_SCOPE("relay_read");
         auto* outData = new unsigned char[len];
         std::ifstream ifs(relayFile_, std::ios::binary);
         ifs.read(reinterpret_cast<char*>(outData), len);  // NOLINT
@@ -0,0 +1,167 @@
+#include <ziwi/common.h>
+#include <ziwi/fpnPanel.h>
+
+#include <QHeaderView>
+#include <QPainter>
+#include <QPolygonF>
+#include <QVBoxLayout>
+#include <algorithm>
+
+using Lux::ziwi::FpnPanel;
+
+namespace {
+// Bayer sites of LuxFpnResult, RGGB
+const char* const kChannelNames[4] = {"R", "Gr", "Gb", "B"};
+const QColor kChannelColors[4] = {QColor(220, 40, 40), QColor(40, 170, 40),
+                                  QColor(20, 110, 60), QColor(40, 80, 220)};
+}  // namespace
+
+namespace Lux {
+namespace ziwi {
+
+///
+/// @brief ProfilePlot - The profiles of the four Bayer sites along the rows
+/// or the columns, one curve per site.
+///
+class ProfilePlot : public QWidget {
+public:
+    ProfilePlot(const QString& title, bool alongRows, QWidget* parent)
+        : QWidget(parent), title_(title), alongRows_(alongRows) {
+        setMinimumHeight(120);
+    }
+
+    /// @c means: two values per row (alongRows) or per column
+    void setProfile(const std::vector<float>& means) {
+        const int count = static_cast<int>(means.size() / 2);
+        for (int s = 0; s < 4; ++s) {
+            // Rows of parity s >> 1, or columns of parity s & 1
+            const int first = alongRows_ ? s >> 1 : s & 1;
+            const int pick = alongRows_ ? s & 1 : s >> 1;
+            curves_[s].clear();
+            for (int i = first; i < count; i += 2)
+                curves_[s] << QPointF(i, means[2 * i + pick]);
+        }
+        length_ = count;
+        update();
+    }
+
+    void clear() {
+        for (auto& c : curves_) c.clear();
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent*) override {
+        QPainter painter(this);
+        painter.fillRect(rect(), Qt::white);
+        painter.drawText(rect().adjusted(4, 2, -4, -2),
+                         Qt::AlignTop | Qt::AlignHCenter, title_);
+
+        float lo = 0, hi = 0;
+        bool any = false;
+        for (const auto& c : curves_)
+            for (const auto& p : c) {
+                lo = any ? std::min<float>(lo, p.y()) : p.y();
+                hi = any ? std::max<float>(hi, p.y()) : p.y();
+                any = true;
+            }
+        if (!any) return;
+        if (hi - lo < 1e-3f) {
+            lo -= 0.5f;
+            hi += 0.5f;
+        }
+
+        const QRectF area = QRectF(rect()).adjusted(48, 18, -6, -6);
+        painter.setPen(Qt::gray);
+        painter.drawRect(area);
+        painter.drawText(QRectF(0, area.top() - 6, 46, 12),
+                         Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(hi, 'f', 1));
+        painter.drawText(QRectF(0, area.bottom() - 6, 46, 12),
+                         Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(lo, 'f', 1));
+
+        const double sx = area.width() / std::max(1, length_ - 1);
+        const double sy = area.height() / (hi - lo);
+        painter.setRenderHint(QPainter::Antialiasing);
+        for (int s = 0; s < 4; ++s) {
+            QPolygonF line;
+            line.reserve(curves_[s].size());
+            for (const auto& p : curves_[s])
+                line << QPointF(area.left() + p.x() * sx,
+                                area.bottom() - (p.y() - lo) * sy);
+            painter.setPen(QPen(kChannelColors[s], 1));
+            painter.drawPolyline(line);
+        }
+    }
+
+private:
+    QString title_;
+    bool alongRows_;
+    int length_ = 0;
+    QVector<QPointF> curves_[4];
+};
+
+}  // namespace ziwi
+}  // namespace Lux
+
+FpnPanel::FpnPanel(QWidget* parent)
+    : QDockWidget(tr("行列噪声"), parent),
+      rowPlot_(new ProfilePlot(tr("行均值"), true, this)),
+      columnPlot_(new ProfilePlot(tr("列均值"), false, this)),
+      table_(new QTableWidget(4, 3, this)),
+      sourceLabel_(new QLabel(this)),
+      averageButton_(new QPushButton(tr("多帧平均..."), this)) {
+    setObjectName("fpnPanel");
+    setFont(FONT);
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionMode(QAbstractItemView::NoSelection);
+    table_->horizontalHeader()->setSectionResizeMode(
+        QHeaderView::ResizeToContents);
+    table_->setHorizontalHeaderLabels(
+        {tr("均值"), tr("行噪声"), tr("列噪声")});
+    for (int s = 0; s < 4; ++s) {
+        auto item = new QTableWidgetItem(kChannelNames[s]);
+        item->setForeground(kChannelColors[s]);
+        table_->setVerticalHeaderItem(s, item);
+    }
+    connect(averageButton_, &QPushButton::clicked, this,
+            &FpnPanel::averageRequested);
+
+    auto body = new QWidget(this);
+    auto layout = new QVBoxLayout(body);
+    layout->setContentsMargins(3, 3, 3, 3);
+    layout->addWidget(sourceLabel_);
+    layout->addWidget(rowPlot_, 1);
+    layout->addWidget(columnPlot_, 1);
+    layout->addWidget(table_);
+    layout->addWidget(averageButton_);
+    setWidget(body);
+    clear();
+}
+
+void FpnPanel::setProfiles(const LuxFpnResult& result,
+                           const std::vector<float>& rowMeans,
+                           const std::vector<float>& columnMeans,
+                           const QString& source) {
+    rowPlot_->setProfile(rowMeans);
+    columnPlot_->setProfile(columnMeans);
+    for (int s = 0; s < 4; ++s) {
+        const double cells[3] = {result.mean[s], result.rowNoise[s],
+                                 result.columnNoise[s]};
+        for (int k = 0; k < 3; ++k)
+            table_->setItem(
+                s, k, new QTableWidgetItem(QString::number(cells[k], 'f', 2)));
+    }
+    sourceLabel_->setText(tr("%1, %2 x %3")
+                              .arg(source)
+                              .arg(result.width)
+                              .arg(result.height));
+}
+
+void FpnPanel::clear() {
+    rowPlot_->clear();
+    columnPlot_->clear();
+    table_->clearContents();
+    sourceLabel_->setText(tr("请先打开 raw 图像"));
+}
@@ -0,0 +1,31 @@
+#include <imgCore/LuxTrace.h>
+#include <ziwi/frameCache.h>
+
+#include <algorithm>
+
+using Lux::ziwi::FrameCache;
+
+FrameCache::FrameCache(size_t capacity)
+    : capacity_(std::max<size_t>(1, capacity)), hits_(0), misses_(0) {}
+
+QImage FrameCache::get(const FrameKey& key, const Decoder& decode) {
+    auto it = std::find_if(frames_.begin(), frames_.end(),
+                           [&key](const auto& f) { return f.first == key; });
+    if (it != frames_.end()) {
+        ++hits_;
+        frames_.splice(frames_.begin(), frames_, it);
+        return frames_.front().second;
+    }
+
+    ++misses_;
+    QImage image;
+    {
+        LUX_TRACE_SCOPE("cache_decode");
+        image = decode(key);
+    }
+    if (image.isNull()) return image;
+
+    frames_.emplace_front(key, image);
+    while (frames_.size() > capacity_) frames_.pop_back();
+    return image;
+}
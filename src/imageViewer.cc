@@ -199,12 +199,39 @@ ImageViewer::ImageViewer(QPixmap* pixmap, QString name)
 void ImageViewer::wheelEvent(QWheelEvent* event) { view_->wheelEvent(event); }
 
 void ImageViewer::setImage(const QPixmap& pixmap) {
+    clearLineMarks();
     pixmapItem_->setPixmap(pixmap);
     pixmapItem_->setTransformationMode(
         Qt::TransformationMode::SmoothTransformation);
     fitToWindow();
 }
 
+void ImageViewer::setLineMarks(const std::vector<int>& lines) {
+    clearLineMarks();
+    if (pixmapItem_->pixmap().isNull()) return;
+
+    // One rect per run of adjacent lines, child of the pixmap so it follows
+    // the zoom and the scroll.
+    auto width = pixmapItem_->pixmap().width();
+    for (size_t i = 0; i < lines.size();) {
+        size_t j = i + 1;
+        while (j < lines.size() && lines[j] == lines[j - 1] + 1) ++j;
+
+        auto mark = new QGraphicsRectItem(0, lines[i], width,
+                                          lines[j - 1] - lines[i] + 1,
+                                          pixmapItem_.get());
+        mark->setPen(Qt::NoPen);
+        mark->setBrush(QColor(255, 0, 0, 96));
+        lineMarks_.push_back(mark);
+        i = j;
+    }
+}
+
+void ImageViewer::clearLineMarks() {
+    for (auto mark : lineMarks_) delete mark;
+    lineMarks_.clear();
+}
+
 void ImageViewer::fitToWindow() {
     if (pixmapItem_->pixmap().isNull()) {
         std::cout << "pixmap is null" << std::endl;
@@ -1,10 +1,12 @@
 #include <ziwi/common.h>
 #include <ziwi/mainwindow.h>
+#include <imgCore/LuxTrace.h>
 #include <ziwi/parameterConfigDialog.h>
 
 #include <QActionGroup>
 #include <QApplication>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QSettings>
 #include <fstream>
@@ -27,19 +29,77 @@ DeCompImgViewMainWindow::DeCompImgViewMainWindow(QPixmap* pixmap,
       height_(3840),
       bpp_(16),
       channel_(1),
+      crcType_(LUX_CRC_NONE),
+      crcScope_(LUX_CHECK_LINE),
       imageViewer_(new Lux::ziwi::ImageViewer(nullptr, "ziwi")),
       appLabel_(new QLabel(this)),
 
       fileLabel_(new QLabel("请选择待查看图像", this)),
-      imgCore_(new DisplayUtils(true, RELAY_FILE)) {
+      imgCore_(new DisplayUtils(true, RELAY_FILE)),
+      statsPanel_(new Lux::ziwi::StatsPanel(this)),
+      statsTimer_(new QTimer(this)),
+      fpnPanel_(new Lux::ziwi::FpnPanel(this)) {
     ui_->setupUi(this);
 
     buildStatusBar();
     buildAction();
     buildImageViewer();
+    buildStatsPanel();
+    buildFpnPanel();
+
+    // TIFF / PNG encodes of the loaders, para.ini: writerCodec, writerLevel
+    QSettings settings(kPARA_INI.c_str(), QSettings::IniFormat);
+    LuxWriterConf writerConf;
+    LuxWriterGetConf(&writerConf);
+    writerConf.codec = settings.value("writerCodec", writerConf.codec).toInt();
+    writerConf.level = settings.value("writerLevel", writerConf.level).toInt();
+    LuxWriterConfigure(&writerConf);
+
+    // Range of mode 5, para.ini: normalizeLow, normalizeHigh (percentiles)
+    LuxNormalizeConf normalizeConf;
+    LuxGetNormalizeConf(&normalizeConf);
+    normalizeConf.lowPercentile =
+        settings.value("normalizeLow", normalizeConf.lowPercentile).toDouble();
+    normalizeConf.highPercentile =
+        settings.value("normalizeHigh", normalizeConf.highPercentile)
+            .toDouble();
+    if (LuxSetNormalizeConf(&normalizeConf) != 0)
+        std::cerr << "Error: wrong normalizeLow / normalizeHigh in "
+                  << kPARA_INI << std::endl;
+
+    // Color stage of the RGB output, para.ini: ccm (nine coefficients,
+    // row-major), gamma (none, srgb or a power, e.g. 2.2)
+    LuxColorConf colorConf;
+    LuxGetColorConf(&colorConf);
+    QStringList ccm =
+        settings.value("ccm").toStringList().join(',').split(',');
+    if (ccm.size() == 9)
+        for (int i = 0; i < 9; ++i) colorConf.ccm[i] = ccm[i].toFloat();
+    const QString gamma = settings.value("gamma", "none").toString();
+    if (gamma == "none") {
+        colorConf.gamma = LUX_GAMMA_NONE;
+    } else if (gamma == "srgb") {
+        colorConf.gamma = LUX_GAMMA_SRGB;
+    } else {
+        colorConf.gamma = LUX_GAMMA_POWER;
+        colorConf.power = gamma.toDouble();
+    }
+    if (LuxSetColorConf(&colorConf) != 0)
+        std::cerr << "Error: wrong ccm / gamma in " << kPARA_INI << std::endl;
+
+    // Threads of the imgCore kernels, para.ini: threads (0: one per core)
+    LuxSetNumThreads(settings.value("threads", 0).toInt());
 }
 
-DeCompImgViewMainWindow::~DeCompImgViewMainWindow() { delete imgCore_; }
+DeCompImgViewMainWindow::~DeCompImgViewMainWindow() {
+    delete imgCore_;
+    LuxWriterShutdown();
+
+#ifdef LUX_ENABLE_TRACE
+    LuxTraceDump(kTRACE_FILE.c_str());
+    LuxTraceWriteSummary(kTRACE_SUMMARY.c_str());
+#endif
+}
 
 void DeCompImgViewMainWindow::buildStatusBar() {
     appLabel_->setText(kAppName);
@@ -82,6 +142,16 @@ void DeCompImgViewMainWindow::buildAction() {
             &DeCompImgViewMainWindow::onFitHeight);
     ui_->actionFitHeight->setIcon(QIcon(kICON_FIT_HEIGHT.c_str()));
 
+    // mode 0 - 5 side by side
+    connect(ui_->actionModeGrid, &QAction::triggered, this,
+            &DeCompImgViewMainWindow::onModeGrid);
+    ui_->actionModeGrid->setIcon(QIcon(kICON_CODEC.c_str()));
+
+    // 2-up / 4-up compare of frames
+    connect(ui_->actionCompare, &QAction::triggered, this,
+            &DeCompImgViewMainWindow::onCompare);
+    ui_->actionCompare->setIcon(QIcon(kICON_FIT_WINDOW.c_str()));
+
     // about
     connect(ui_->actionAbout, &QAction::triggered, this,
             &DeCompImgViewMainWindow::onAbout);
@@ -102,6 +172,34 @@ void DeCompImgViewMainWindow::buildImageViewer() {
     ui_->centralwidget->setLayout(ui_->gridLayout);
 }
 
+void DeCompImgViewMainWindow::buildStatsPanel() {
+    addDockWidget(Qt::RightDockWidgetArea, statsPanel_);
+    ui_->menu_2->addSeparator();
+    ui_->menu_2->addAction(statsPanel_->toggleViewAction());
+
+    statsTimer_->setSingleShot(true);
+    statsTimer_->setInterval(100);
+    connect(statsTimer_, &QTimer::timeout, this,
+            &DeCompImgViewMainWindow::updateStats);
+    connect(statsPanel_, &QDockWidget::visibilityChanged, this,
+            [this](bool visible) {
+                if (visible) statsTimer_->start();
+            });
+}
+
+void DeCompImgViewMainWindow::buildFpnPanel() {
+    addDockWidget(Qt::RightDockWidgetArea, fpnPanel_);
+    ui_->menu_2->addAction(fpnPanel_->toggleViewAction());
+    fpnPanel_->hide();
+
+    connect(fpnPanel_, &QDockWidget::visibilityChanged, this,
+            [this](bool visible) {
+                if (visible) updateFpn();
+            });
+    connect(fpnPanel_, &Lux::ziwi::FpnPanel::averageRequested, this,
+            &DeCompImgViewMainWindow::onFpnAverage);
+}
+
 ///
 /// @brief Update the title including the status bar and the MainWindow tittle
 ///
@@ -121,12 +219,16 @@ ImageInfo* DeCompImgViewMainWindow::loadImageData() {
 
     QString fileName = QFileDialog::getOpenFileName(
         this, tr("选择图像"), kBASE_DIR.c_str(),
-        tr("图像文件(*.raw *.jpg *.png *.tiff *.svg);;所有文件 (*.*)"));
+        tr("图像文件(*.raw *.zraw *.jpg *.png *.tiff *.svg);;所有文件 (*.*)"));
     updateTittle(fileName.toStdString());
 
     ImageInfo* info = new ImageInfo();
 
-    if (fileName.endsWith("raw", Qt::CaseSensitivity::CaseInsensitive)) {
+    // .zraw carries its own parameters, also when it is named .raw
+    if (fileName.endsWith("zraw", Qt::CaseSensitivity::CaseInsensitive) ||
+        LuxZrawIsContainer(fileName.toStdString().c_str()) == 1) {
+        info->type_ = ImageType::ZRAW;
+    } else if (fileName.endsWith("raw", Qt::CaseSensitivity::CaseInsensitive)) {
         info->type_ = ImageType::RAW;
     } else if (fileName.endsWith("jpg", Qt::CaseSensitivity::CaseInsensitive)) {
         info->type_ = ImageType::JPG;
@@ -153,6 +255,7 @@ ImageInfo* DeCompImgViewMainWindow::loadImageData() {
                 ifs.seekg(0, std::ios::beg);
                 // unsigned char* buffer = new unsigned char[length];
                 info->data_ = new unsigned char[length];
+                LUX_TRACE_SCOPE("gui_read_file");
                 ifs.read((char*)info->data_, length);
                 ifs.close();
                 return info;
@@ -177,32 +280,143 @@ void DeCompImgViewMainWindow::onShowLVDSImage() {
     // auto imgdata = loadImageData();
     auto imgInfo = loadImageData();
     if (imgInfo == nullptr) return;
+    statsFrame_.clear();
 
     if (imgInfo->type_ == ImageType::RAW) {
         paramConfig();
+        if (!applyPacking(imgInfo->name_)) {
+            delete imgInfo;
+            QMessageBox::information(this, tr("提示"), tr("打包描述错误"));
+            return;
+        }
+        applyCalibration();
+        applyDefects(imgInfo->name_);
+        LUX_TRACE_SCOPE("open_raw");
         std::string tiffFile = "";
+        LuxCheckConf checkConf = checkConfig();
+        LuxFrameLayout layout = frameLayout();
+        const LuxFrameLayout* inputLayout =
+            layout.inStride != 0 || layout.topLines != 0 ||
+                    layout.bottomLines != 0
+                ? &layout
+                : nullptr;
+        std::vector<int> badLines;
+        const unsigned char* input = imgInfo->data_;
+        std::vector<unsigned char> unpacked;
+        if (!packing_.empty()) {
+            // readFrame() strips the CRC framing and unpacks the samples
+            if (!readFrame(frameKey(imgInfo->name_), unpacked)) {
+                delete imgInfo;
+                QMessageBox::information(this, tr("提示"), tr("转换失败"));
+                return;
+            }
+            input = unpacked.data();
+            inputLayout = nullptr;
+            checkConf.crcType = LUX_CRC_NONE;
+        }
         auto outData = imgCore_->LoadDataForDisplaySelectableMode(
-            workspace_, imgInfo->data_, 1, false, tiffFile, mode_, endian_,
-            width_, height_, bpp_, channel_);
+            workspace_, input, 1, false, tiffFile, mode_, endian_, width_,
+            height_, bpp_, channel_, &checkConf, &badLines, inputLayout);
         if (outData == nullptr) {
             delete imgInfo;
             QMessageBox::information(this, tr("提示"), tr("转换失败"));
             return;
         }
+        rawFile_ = imgInfo->name_;
+        if (!readFrame(frameKey(rawFile_), statsFrame_)) statsFrame_.clear();
 
         // QPixmap pixmap(fileName);
-        imageViewer_->setImage(QPixmap::fromImage(
-            QImage(outData, width_, height_, width_, QImage::Format_Indexed8)));
+        {
+            LUX_TRACE_SCOPE("qpixmap");
+            imageViewer_->setImage(QPixmap::fromImage(QImage(
+                outData, width_, height_, width_, QImage::Format_Indexed8)));
+        }
 
+        // Highlight the lines which failed the CRC check
+        if (!badLines.empty()) {
+            imageViewer_->setLineMarks(badLines);
+            fileLabel_->setText(fileLabel_->text() +
+                                tr("  [CRC 错误行: %1]").arg(badLines.size()));
+        }
+
+    } else if (imgInfo->type_ == ImageType::ZRAW) {
+        showContainer(imgInfo);
     } else if (imgInfo->type_ == ImageType::UNKNOWN) {
         QMessageBox::information(this, tr("提示"), tr("图片类型暂不支持"));
     } else {  // jpg, png, tiff
         imageViewer_->setImage(QPixmap(imgInfo->name_.c_str()));
     }
+    statsPanel_->clear();
+    statsTimer_->start();
+    fpnPanel_->clear();
+    updateFpn();
 
     delete imgInfo;
 }
 
+///
+/// @brief Open a .zraw without the ParaConfDialog: the parameters come from
+/// the header, the preview is shown while the frame is decoded.
+///
+void DeCompImgViewMainWindow::showContainer(const ImageInfo* imgInfo) {
+    LUX_TRACE_SCOPE("open_zraw");
+    LuxZrawFile file;
+    if (LuxZrawOpen(imgInfo->name_.c_str(), &file) != 0) {
+        QMessageBox::information(this, tr("提示"), tr("打开文件失败"));
+        return;
+    }
+    const LuxZrawHeader& header = file.header;
+
+    if (const unsigned char* preview = LuxZrawPreview(&file)) {
+        bool rgb = header.previewType == CV_8UC3;
+        imageViewer_->setImage(QPixmap::fromImage(QImage(
+            preview, header.previewWidth, header.previewHeight,
+            header.previewWidth * (rgb ? 3 : 1),
+            rgb ? QImage::Format_RGB888 : QImage::Format_Grayscale8)));
+        QApplication::processEvents();
+    }
+
+    rawFile_ = imgInfo->name_;
+    packing_.clear();
+    workspace_ = header.highZero ? 1 : 0;
+    width_ = header.width;
+    height_ = header.height;
+    bpp_ = header.bpp;
+    channel_ = header.channels;
+    endian_ = header.bigEndian != 0;
+
+    // Plain untiled payloads are decoded straight from the mapping
+    std::vector<unsigned char> frame;
+    const unsigned char* payload = LuxZrawPayload(&file);
+    if (payload == nullptr) {
+        frame.resize(LuxZrawFrameBytes(&header));
+        if (LuxZrawReadFrame(&file, frame.data()) < 0) {
+            LuxZrawClose(&file);
+            QMessageBox::information(this, tr("提示"), tr("转换失败"));
+            return;
+        }
+        payload = frame.data();
+    }
+    statsFrame_.assign(payload, payload + LuxZrawFrameBytes(&header));
+
+    std::string tiffFile = "";
+    auto outData = imgCore_->LoadDataForDisplaySelectableMode(
+        workspace_, payload, 1, false, tiffFile, mode_, endian_, width_,
+        height_, bpp_, channel_);
+    LuxZrawClose(&file);
+    if (outData == nullptr) {
+        QMessageBox::information(this, tr("提示"), tr("转换失败"));
+        return;
+    }
+
+    {
+        LUX_TRACE_SCOPE("qpixmap");
+        imageViewer_->setImage(QPixmap::fromImage(QImage(
+            outData, width_, height_, width_, QImage::Format_Indexed8)));
+    }
+    delete[] outData;
+}
+
 void DeCompImgViewMainWindow::onActualSize() {
     // std::cout << __FUNCTION__ << std::endl;
     imageViewer_->actualSize();
@@ -232,11 +446,501 @@ void DeCompImgViewMainWindow::onAbout() {
     about->show();
 }
 
+///
+/// @brief Show the frame in every bit-window mode at once, decoded in one pass
+/// (LuxDecodeModes), the views zoom and scroll together.
+///
+void DeCompImgViewMainWindow::onModeGrid() {
+    std::vector<unsigned char> frame;
+    if (rawFile_.empty() || !readFrame(frameKey(rawFile_), frame)) {
+        QMessageBox::information(this, tr("提示"), tr("请先打开 raw 图像"));
+        return;
+    }
+
+    int samplesPerRow = width_ * channel_;
+    std::vector<std::vector<unsigned char>> modes(
+        6, std::vector<unsigned char>(static_cast<size_t>(samplesPerRow) *
+                                      height_));
+    unsigned char* outputs[6];
+    for (int m = 0; m < 6; ++m) outputs[m] = modes[m].data();
+
+    long long ret = 0;
+    {
+        LUX_TRACE_SCOPE("decode_modes");
+        ret = LuxDecodeModes(frame.data(), frame.size(), samplesPerRow,
+                             height_, bpp_, endian_, workspace_ == 1,
+                             LUX_DECODE_ALL_MODES, outputs);
+    }
+    if (ret < 0) {
+        QMessageBox::information(this, tr("提示"), tr("转换失败"));
+        return;
+    }
+
+    auto grid = new Lux::ziwi::ViewGrid(2, 3);
+    grid->setAttribute(Qt::WA_DeleteOnClose);
+    grid->setWindowTitle(tr("模式对比") + QString::fromStdString(kAT) +
+                         kAppName);
+    grid->setWindowIcon(QIcon(kICON_LOGO.c_str()));
+    grid->resize(size());
+    for (int m = 0; m < 6; ++m) {
+        QImage image(outputs[m], samplesPerRow, height_, samplesPerRow,
+                     QImage::Format_Grayscale8);
+        grid->setImage(m, QPixmap::fromImage(image),
+                       m == 5 ? tr("mode 5: 归一化") : tr("mode %1").arg(m));
+    }
+    grid->show();
+    grid->fitToWindow();
+}
+
+///
+/// @brief Compare 2 or 4 raws side by side with the current parameters. With
+/// a single file it is compared to the raw shown last. The frames come from
+/// frameCache_: one decode per frame, whatever the number of views. With 2
+/// or 3 raws, the difference of the first two takes the next view.
+///
+void DeCompImgViewMainWindow::onCompare() {
+    QStringList files = QFileDialog::getOpenFileNames(
+        this, tr("选择对比图像"), kBASE_DIR.c_str(),
+        tr("图像文件(*.raw *.zraw);;所有文件 (*.*)"));
+    if (files.size() == 1 && !rawFile_.empty())
+        files.prepend(QString::fromStdString(rawFile_));
+    if (files.size() < 2) return;
+    if (files.size() > 4) files = files.mid(0, 4);
+
+    if (compare_ != nullptr) compare_->close();
+    const bool withDiff = files.size() < 4;
+    const bool fourUp = files.size() > 2;
+    compare_ = new Lux::ziwi::ViewGrid(fourUp ? 2 : 1, fourUp ? 2 : 3);
+    compare_->setAttribute(Qt::WA_DeleteOnClose);
+    compare_->setWindowTitle(tr("对比") + QString::fromStdString(kAT) +
+                             kAppName);
+    compare_->setWindowIcon(QIcon(kICON_LOGO.c_str()));
+    compare_->resize(size());
+
+    auto decoder = [this](const FrameKey& key) { return decodeFrame(key); };
+    for (int i = 0; i < files.size(); ++i) {
+        auto image = frameCache_.get(frameKey(files[i].toStdString()), decoder);
+        QString name = QFileInfo(files[i]).fileName();
+        compare_->setImage(i, QPixmap::fromImage(image),
+                           image.isNull() ? name + tr("  [转换失败]") : name);
+    }
+    if (withDiff) {
+        QString caption;
+        auto image = diffFrames(frameKey(files[0].toStdString()),
+                                frameKey(files[1].toStdString()), &caption);
+        compare_->setImage(files.size(), QPixmap::fromImage(image), caption);
+    }
+    compare_->show();
+    compare_->fitToWindow();
+}
+
+Lux::ziwi::FrameKey DeCompImgViewMainWindow::frameKey(
+    const std::string& fileName) const {
+    return FrameKey{fileName, width_,     height_,  bpp_,
+                    channel_, mode_,      endian_,  workspace_,
+                    crcType_, packing_,   frameLayout(), calibration_,
+                    defects_};
+}
+
+///
+/// @brief The payload of a raw: headerless, LuxCodec stream or container;
+/// the CRC framing or the line padding is stripped as in the loaders, a
+/// packing unpacked.
+///
+bool DeCompImgViewMainWindow::readFrame(
+    const FrameKey& key, std::vector<unsigned char>& frame) const {
+    uint64_t samples = static_cast<uint64_t>(key.width) * key.channels;
+    if (!key.packing.empty()) {
+        LuxPackingDesc packing;
+        std::vector<unsigned char> packed;
+        FrameKey packedKey = key;
+        packedKey.packing.clear();
+        if (LuxPackingParse(key.packing.c_str(), &packing) != 0 ||
+            !readPayload(packedKey, LuxPackingRowBytes(&packing, samples),
+                         packed))
+            return false;
+        frame.resize(samples * key.height * 2);
+        return LuxPackingUnpack(&packing, packed.data(), packed.size(),
+                                static_cast<int>(samples), key.height,
+                                LUX_UNPACK_STRETCH16 | LUX_UNPACK_BIG_ENDIAN,
+                                reinterpret_cast<uint16_t*>(frame.data())) >=
+               0;
+    }
+    return readPayload(key, LuxPackedBytes(samples, key.bpp), frame);
+}
+
+bool DeCompImgViewMainWindow::readPayload(
+    const FrameKey& key, uint64_t lineBytes,
+    std::vector<unsigned char>& frame) const {
+    if (lineBytes == 0) return false;
+    frame.resize(lineBytes * key.height);
+
+    LuxCheckConf conf = checkConfig();
+    conf.crcType = key.crcType;
+    if (LuxZrawIsContainer(key.fileName.c_str()) == 1)
+        return LuxReadFrameFromFile(key.fileName.c_str(), frame.data(),
+                                    frame.size()) > 0;
+    if (conf.crcType == LUX_CRC_NONE) {
+        uint64_t bytes =
+            LuxFrameLayoutBytes(&key.layout, lineBytes, key.height);
+        if (bytes == frame.size())
+            return LuxReadFrameFromFile(key.fileName.c_str(), frame.data(),
+                                        frame.size()) > 0;
+        std::vector<unsigned char> capture(bytes);
+        return bytes > 0 &&
+               LuxReadFrameFromFile(key.fileName.c_str(), capture.data(),
+                                    bytes) > 0 &&
+               LuxFrameCompact(capture.data(), bytes, lineBytes, key.height,
+                               &key.layout, frame.data()) >= 0;
+    }
+
+    std::ifstream ifs(key.fileName, std::ios::binary);
+    std::vector<unsigned char> framed(
+        LuxCheckFrameBytes(&conf, lineBytes, key.height));
+    ifs.read(reinterpret_cast<char*>(framed.data()), framed.size());
+    if (ifs.fail()) return false;
+    return LuxCheckVerify(framed.data(), framed.size(), lineBytes, key.height,
+                          &conf, frame.data(), nullptr, 0) >= 0;
+}
+
+///
+/// @brief The 8-bit window @c key.mode of a raw, as in the mode grid, for
+/// frameCache_.
+///
+QImage DeCompImgViewMainWindow::decodeFrame(const FrameKey& key) const {
+    std::vector<unsigned char> frame;
+    if (!readFrame(key, frame)) return QImage();
+
+    int samplesPerRow = key.width * key.channels;
+    std::vector<unsigned char> display(static_cast<size_t>(samplesPerRow) *
+                                       key.height);
+    LuxDecodeRequest request{};
+    request.outputs = LUX_DECODE_DISPLAY8;
+    request.mode = key.mode;
+    request.display8 = display.data();
+    if (LuxDecodeMulti(frame.data(), frame.size(), samplesPerRow, key.height,
+                       key.bpp, key.bigEndian, key.workspace == 1,
+                       &request) < 0)
+        return QImage();
+
+    return QImage(display.data(), samplesPerRow, key.height, samplesPerRow,
+                  QImage::Format_Grayscale8)
+        .copy();
+}
+
+///
+/// @brief Heatmap of the difference of two raws of the same format (see
+/// LuxDiff.h), read into memory only. para.ini: diffMode (abs or signed),
+/// diffThreshold (the differences counted), diffRange (the difference of
+/// the brightest color, 0: the largest one).
+///
+QImage DeCompImgViewMainWindow::diffFrames(const FrameKey& a,
+                                           const FrameKey& b,
+                                           QString* caption) const {
+    std::vector<unsigned char> frameA, frameB;
+    if (!readFrame(a, frameA) || !readFrame(b, frameB) ||
+        frameA.size() != frameB.size()) {
+        *caption = tr("差异  [转换失败]");
+        return QImage();
+    }
+
+    QSettings settings(kPARA_INI.c_str(), QSettings::IniFormat);
+    const bool signedDiff =
+        settings.value("diffMode", "abs").toString() == "signed";
+    const int threshold = settings.value("diffThreshold", 0).toInt();
+    const int range = settings.value("diffRange", 0).toInt();
+
+    // A packing is unpacked into 16-bit big endian, see FrameKey
+    const bool packed = !a.packing.empty();
+    const int samplesPerRow = a.width * a.channels;
+    std::vector<unsigned char> heatmap(static_cast<size_t>(samplesPerRow) *
+                                       a.height * 3);
+    LuxDiffResult result;
+    if (LuxComputeDiff(frameA.data(), frameB.data(), frameA.size(),
+                       samplesPerRow, a.height, packed ? 16 : a.bpp,
+                       packed || a.bigEndian, !packed && a.workspace == 1,
+                       signedDiff ? LUX_DIFF_SIGNED : LUX_DIFF_ABS, threshold,
+                       range, heatmap.data(), &result) < 0) {
+        *caption = tr("差异  [转换失败]");
+        return QImage();
+    }
+
+    const double samples = static_cast<double>(samplesPerRow) * a.height;
+    *caption = tr("%1  最大 %2  均值 %3  > %4: %5 (%6%)")
+                   .arg(signedDiff ? tr("A - B [%1, %2]")
+                                         .arg(result.minSigned)
+                                         .arg(result.maxSigned)
+                                   : tr("|A - B|"))
+                   .arg(result.maxAbs)
+                   .arg(result.meanAbs, 0, 'f', 3)
+                   .arg(threshold)
+                   .arg(result.overThreshold)
+                   .arg(100.0 * result.overThreshold / samples, 0, 'f', 3);
+    return QImage(heatmap.data(), samplesPerRow, a.height, samplesPerRow * 3,
+                  QImage::Format_RGB888)
+        .copy();
+}
+
+///
+/// @brief The compare views follow the zoom and the scroll of the main
+/// viewer, the statistics follow the visible region.
+///
 void DeCompImgViewMainWindow::transformChanged() {
-    // std::cout << __FUNCTION__ << std::endl;
+    if (compare_ != nullptr) compare_->followView(imageViewer_->view());
+    statsTimer_->start();
 }
 void DeCompImgViewMainWindow::scrollChanged() {
-    // std::cout << __FUNCTION__ << std::endl;
+    if (compare_ != nullptr) compare_->followView(imageViewer_->view());
+    statsTimer_->start();
+}
+
+///
+/// @brief Per channel statistics of the part of the raw in the main viewer
+///
+void DeCompImgViewMainWindow::updateStats() {
+    if (statsFrame_.empty() || !statsPanel_->isVisible()) return;
+
+    auto view = imageViewer_->view();
+    QRect visible = view->mapToScene(view->viewport()->rect())
+                        .boundingRect()
+                        .toAlignedRect()
+                        .intersected(QRect(0, 0, width_, height_));
+    if (visible.isEmpty()) return;
+
+    // Scene pixels to samples, the Bayer sites follow the frame
+    LuxRoi roi{visible.x() * channel_, visible.y(),
+               visible.width() * channel_, visible.height()};
+    static const double kRanks[] = {1, 5, 50, 95, 99};
+    LuxBayerStats stats;
+    long long ret = LuxComputeBayerStats(
+        statsFrame_.data(), statsFrame_.size(), width_ * channel_, height_,
+        bpp_, endian_, workspace_ == 1, &roi, kRanks, 5, &stats);
+    if (ret < 0) {
+        statsPanel_->clear();
+        return;
+    }
+    statsPanel_->setStats(stats);
+}
+
+///
+/// @brief Row and column profiles of the whole raw shown
+///
+void DeCompImgViewMainWindow::updateFpn() {
+    if (statsFrame_.empty() || !fpnPanel_->isVisible()) return;
+
+    const int samples = width_ * channel_;
+    std::vector<float> rows(2 * static_cast<size_t>(height_));
+    std::vector<float> columns(2 * static_cast<size_t>(samples));
+    LuxFpnResult result;
+    long long ret = LuxComputeFpnProfiles(
+        statsFrame_.data(), statsFrame_.size(), samples, height_, bpp_,
+        endian_, workspace_ == 1, rows.data(), columns.data(), &result);
+    if (ret < 0) {
+        fpnPanel_->clear();
+        return;
+    }
+    const auto idx = rawFile_.find_last_of('/');
+    fpnPanel_->setProfiles(
+        result, rows, columns,
+        QString::fromStdString(rawFile_.substr(idx + 1)));
+}
+
+///
+/// @brief Profiles of the mean of several raws of the current format, e.g.
+/// a dark sequence: the temporal noise averages out, the fixed pattern stays.
+/// The mean is streamed, one frame in memory at a time.
+///
+void DeCompImgViewMainWindow::onFpnAverage() {
+    if (statsFrame_.empty()) {
+        QMessageBox::information(this, tr("提示"),
+                                 tr("请先以相同格式打开一帧 raw 图像"));
+        return;
+    }
+    QStringList files = QFileDialog::getOpenFileNames(
+        this, tr("选择多帧图像"), kBASE_DIR.c_str(),
+        tr("图像文件(*.raw *.zraw);;所有文件 (*.*)"));
+    if (files.isEmpty()) return;
+
+    // Read as the viewer reads them: CRC framing, line padding and packing
+    // stripped by readFrame(), the samples then as in statsFrame_
+    const int samples = width_ * channel_;
+    LuxTemporalAccumulator accumulator(samples, height_, bpp_, endian_,
+                                       workspace_ == 1);
+    std::vector<unsigned char> frame;
+    std::vector<float> mean(static_cast<size_t>(samples) * height_);
+    std::vector<float> rows(2 * static_cast<size_t>(height_));
+    std::vector<float> columns(2 * static_cast<size_t>(samples));
+    LuxFpnResult result;
+    int failed = 0;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    for (const auto& f : files) {
+        if (!readFrame(frameKey(f.toStdString()), frame) ||
+            accumulator.add(frame.data(), frame.size()) < 0)
+            ++failed;
+    }
+    long long frames = accumulator.finish(mean.data(), nullptr, nullptr);
+    if (frames > 0)
+        LuxComputeFpnProfilesF(mean.data(), samples, height_, rows.data(),
+                               columns.data(), &result);
+    QApplication::restoreOverrideCursor();
+    if (frames <= 0) {
+        QMessageBox::information(this, tr("提示"), tr("转换失败"));
+        return;
+    }
+    QString source = tr("%1 帧平均").arg(frames);
+    if (failed > 0) source += tr("  [%1 帧转换失败]").arg(failed);
+    fpnPanel_->setProfiles(result, rows, columns, source);
+}
+
+///
+/// @brief The packing descriptor of @c rawFile: the sidecar <raw>.pack, else
+/// the [packing] section of para.ini. A layout with a bpp of its own sets
+/// it, the others are unpacked by readFrame() into 16-bit big endian.
+/// @return false if the descriptor found is wrong (logged), no fallback.
+///
+bool DeCompImgViewMainWindow::applyPacking(const std::string& rawFile) {
+    packing_.clear();
+    LuxPackingDesc desc;
+    const std::string sidecar = rawFile + ".pack";
+    std::string source = sidecar;
+    int ret = LuxPackingLoad(sidecar.c_str(), &desc);
+    if (ret == -1 || ret == -2) {
+        source = kPARA_INI;
+        ret = LuxPackingLoad(kPARA_INI.c_str(), &desc);
+    }
+    if (ret == -3) {
+        std::cerr << "Error: wrong packing descriptor in " << source
+                  << std::endl;
+        return false;
+    }
+    if (ret != 0) return true;
+
+    bool highZero = false;
+    if (LuxPackingToBpp(&desc, &bpp_, &endian_, &highZero) == 0) {
+        workspace_ = highZero ? 1 : 0;
+        return true;
+    }
+    char text[256];
+    if (LuxPackingFormat(&desc, text, sizeof(text)) < 0) return true;
+    packing_ = text;
+    bpp_ = 16;
+    endian_ = true;
+    workspace_ = 0;
+    return true;
+}
+
+///
+/// @brief The calibration of the loaders, from para.ini: blackLevel (one
+/// value, or one per Bayer site "r,gr,gb,b" in the order of the frame),
+/// blackRescale, and the raws darkFrame and flatFrame, of the current
+/// geometry and format.
+///
+void DeCompImgViewMainWindow::applyCalibration() {
+    QSettings settings(kPARA_INI.c_str(), QSettings::IniFormat);
+
+    LuxCalibConf conf;
+    LuxGetCalibConf(&conf);
+    // Unquoted "64,64,64,64" reads as a list, as ccm
+    QStringList black = settings.value("blackLevel", "0")
+                            .toStringList()
+                            .join(',')
+                            .split(',');
+    bool blackOk = black.size() == 1 || black.size() == 4;
+    int levels[4] = {0, 0, 0, 0};
+    for (int s = 0; s < 4 && blackOk; ++s)
+        levels[s] = black.value(black.size() == 4 ? s : 0)
+                        .trimmed()
+                        .toInt(&blackOk);
+    if (blackOk) {
+        for (int s = 0; s < 4; ++s) conf.blackLevel[s] = levels[s];
+    } else {
+        std::cerr << "Error: wrong blackLevel \""
+                  << black.join(',').toStdString() << "\" in " << kPARA_INI
+                  << ", ignored" << std::endl;
+    }
+    conf.rescale = settings.value("blackRescale", true).toBool() ? 1 : 0;
+    if (LuxSetCalibConf(&conf) != 0)
+        std::cerr << "Error: wrong blackLevel in " << kPARA_INI << std::endl;
+    LuxGetCalibConf(&conf);
+
+    // The frames are read again only when the file or the format changes
+    const int samples = width_ * channel_;
+    const std::string format =
+        std::to_string(samples) + "x" + std::to_string(height_) + " " +
+        std::to_string(bpp_) + (endian_ ? "be" : "le") +
+        std::to_string(workspace_);
+    const char* keys[2] = {"darkFrame", "flatFrame"};
+    for (int kind : {LUX_CALIB_DARK, LUX_CALIB_FLAT}) {
+        const std::string file =
+            settings.value(keys[kind], "").toString().toStdString();
+        const std::string loaded = file + "|" + format;
+        if (file.empty()) {
+            LuxClearCalibFrame(kind);
+            calibFramesLoaded_[kind].clear();
+        } else if (loaded != calibFramesLoaded_[kind] ||
+                   LuxHasCalibFrame(kind) == 0) {
+            calibFramesLoaded_[kind].clear();
+            if (LuxLoadCalibFrame(kind, file.c_str(), samples, height_, bpp_,
+                                  endian_, workspace_ == 1) < 0) {
+                LuxClearCalibFrame(kind);
+                std::cerr << "Error: wrong " << keys[kind] << " " << file
+                          << std::endl;
+            } else {
+                calibFramesLoaded_[kind] = loaded;
+            }
+        }
+    }
+
+    calibration_.clear();
+    for (int s = 0; s < 4; ++s)
+        calibration_ += std::to_string(conf.blackLevel[s]) + ",";
+    calibration_ += std::to_string(conf.rescale);
+    for (const auto& loaded : calibFramesLoaded_)
+        calibration_ += "|" + loaded;
+}
+
+///
+/// @brief The defect correction of the loaders: the map of the sidecar
+/// <raw>.defects, else of para.ini (defectMap), for frames of the current
+/// geometry; the detector of para.ini (defectDynamic, defectThreshold).
+///
+void DeCompImgViewMainWindow::applyDefects(const std::string& rawFile) {
+    QSettings settings(kPARA_INI.c_str(), QSettings::IniFormat);
+    std::string mapFile = rawFile + ".defects";
+    if (!QFileInfo::exists(QString::fromStdString(mapFile)))
+        mapFile = settings.value("defectMap", "").toString().toStdString();
+
+    // The map is read again only when the file or the geometry changes
+    const int samples = width_ * channel_;
+    const std::string loaded = mapFile + "|" + std::to_string(samples) + "x" +
+                               std::to_string(height_);
+    if (mapFile.empty()) {
+        LuxClearDefectMap();
+        defectMapLoaded_.clear();
+    } else if (loaded != defectMapLoaded_) {
+        defectMapLoaded_.clear();
+        if (LuxLoadDefectMap(mapFile.c_str(), samples, height_) < 0) {
+            LuxClearDefectMap();
+            std::cerr << "Error: wrong defect map " << mapFile << std::endl;
+        } else {
+            defectMapLoaded_ = loaded;
+        }
+    }
+
+    LuxDefectConf conf;
+    LuxGetDefectConf(&conf);
+    conf.dynamic = settings.value("defectDynamic", 0).toInt();
+    conf.threshold =
+        settings.value("defectThreshold", conf.threshold).toDouble();
+    if (LuxSetDefectConf(&conf) != 0)
+        std::cerr << "Error: wrong defectThreshold in " << kPARA_INI
+                  << std::endl;
+    LuxGetDefectConf(&conf);
+
+    defects_.clear();
+    if (LuxGetDefectCount() > 0) defects_ = defectMapLoaded_;
+    if (conf.dynamic != 0)
+        defects_ += "|dynamic " + std::to_string(conf.threshold);
 }
 
 void DeCompImgViewMainWindow::paramConfig() {
@@ -254,6 +958,8 @@ void DeCompImgViewMainWindow::paramConfig() {
         bpp_ = paraConf.bpp;
         mode_ = paraConf.mode;
         endian_ = paraConf.bigEndian;
+        crcType_ = paraConf.crcType;
+        crcScope_ = paraConf.crcScope;
 
         std::unique_ptr<QSettings> setPtr = std::make_unique<QSettings>(
             kPARA_INI.c_str(), QSettings::IniFormat);
@@ -264,6 +970,8 @@ void DeCompImgViewMainWindow::paramConfig() {
         setPtr->setValue("bpp", bpp_);
         setPtr->setValue("mode", mode_);
         setPtr->setValue("endian", endian_);
+        setPtr->setValue("crcType", crcType_);
+        setPtr->setValue("crcScope", crcScope_);
 
     } else {
         std::cout << "cancel" << std::endl;
@@ -271,4 +979,39 @@ void DeCompImgViewMainWindow::paramConfig() {
 
     delete paraConfDialog_;
     paraConfDialog_ = nullptr;
-}
\ No newline at end of file
+}
+
+///
+/// @brief The CRC stage of the raw loaders. The variant and scope come from the
+/// ParaConfDialog, the record layout from para.ini (crcPosition,
+/// crcHeaderBytes, crcPaddingBytes, crcCoverHeader, crcBigEndian).
+///
+LuxCheckConf DeCompImgViewMainWindow::checkConfig() const {
+    QSettings settings(kPARA_INI.c_str(), QSettings::IniFormat);
+
+    LuxCheckConf conf;
+    conf.crcType = crcType_;
+    conf.scope = crcScope_;
+    conf.position = settings.value("crcPosition", LUX_CHECK_TAIL).toInt();
+    conf.headerBytes = settings.value("crcHeaderBytes", 0).toInt();
+    conf.paddingBytes = settings.value("crcPaddingBytes", 0).toInt();
+    conf.coverHeader = settings.value("crcCoverHeader", false).toBool();
+    conf.crcBigEndian = settings.value("crcBigEndian", true).toBool();
+    return conf;
+}
+
+///
+/// @brief Line padding and embedded data lines of the raws, from para.ini
+/// (lineStride in bytes, topLines, bottomLines). The loaders read the rows
+/// in place; with a CRC stage its record layout describes the lines instead.
+///
+LuxFrameLayout DeCompImgViewMainWindow::frameLayout() const {
+    QSettings settings(kPARA_INI.c_str(), QSettings::IniFormat);
+
+    LuxFrameLayout layout;
+    layout.inStride = settings.value("lineStride", 0).toULongLong();
+    layout.topLines = settings.value("topLines", 0).toInt();
+    layout.bottomLines = settings.value("bottomLines", 0).toInt();
+    layout.outStride = 0;
+    return layout;
+}
@@ -1,4 +1,6 @@
 
+#include <imgCore/LuxCheck.h>
+#include <imgCore/LuxUnpack.h>
 #include <ziwi/common.h>
 #include <ziwi/parameterConfigDialog.h>
 
@@ -24,6 +26,9 @@ ParaConfDialog::ParaConfDialog(QDialog *parent)
       radio8_(new QRadioButton("8", this)),
       radio12_(new QRadioButton("12", this)),
       radio16_(new QRadioButton("16", this)),
+      radioRaw10_(new QRadioButton("RAW10", this)),
+      radioRaw12_(new QRadioButton("RAW12 (MIPI)", this)),
+      radioRaw14_(new QRadioButton("RAW14", this)),
       radioBigEndian_(new QRadioButton("大端", this)),
       radioLittleEndian_(new QRadioButton("小端", this)),
       radio18_(new QRadioButton("第一高八位", this)),
@@ -32,6 +37,8 @@ ParaConfDialog::ParaConfDialog(QDialog *parent)
       radio48_(new QRadioButton("第四高八位", this)),
       radio58_(new QRadioButton("第五高八位", this)),
       radioAll8_(new QRadioButton("AllIn8", this)),
+      crcType_(new QComboBox(this)),
+      crcScope_(new QComboBox(this)),
       conf_(new Lux::ziwi::ParaConf) {
     auto setPtr =
         std::make_unique<QSettings>(kPARA_INI.c_str(), QSettings::IniFormat);
@@ -49,6 +56,9 @@ ParaConfDialog::ParaConfDialog(QDialog *parent)
     radioBits->addButton(radio8_, 0);
     radioBits->addButton(radio12_, 1);
     radioBits->addButton(radio16_, 2);
+    radioBits->addButton(radioRaw10_, 3);
+    radioBits->addButton(radioRaw12_, 4);
+    radioBits->addButton(radioRaw14_, 5);
     switch (setPtr->value("bpp").toInt()) {
         case 8:
             radio8_->setChecked(true);
@@ -59,6 +69,15 @@ ParaConfDialog::ParaConfDialog(QDialog *parent)
         case 16:
             radio16_->setChecked(true);
             break;
+        case LUX_BPP_RAW10:
+            radioRaw10_->setChecked(true);
+            break;
+        case LUX_BPP_RAW12:
+            radioRaw12_->setChecked(true);
+            break;
+        case LUX_BPP_RAW14:
+            radioRaw14_->setChecked(true);
+            break;
         default:
             break;
     }
@@ -102,6 +121,19 @@ ParaConfDialog::ParaConfDialog(QDialog *parent)
     }
     // radioAll8_->setChecked(true);
 
+    // CRC, the item index is the LuxCRCType
+    crcType_->addItems({"None", "CRC-4/ITU", "CRC-5/EPC", "CRC-5/ITU",
+                        "CRC-5/USB", "CRC-6/ITU", "CRC-7/MMC", "CRC-8",
+                        "CRC-8/ITU", "CRC-8/ROHC", "CRC-8/MAXIM",
+                        "CRC-16/IBM", "CRC-16/MAXIM", "CRC-16/USB",
+                        "CRC-16/MODBUS", "CRC-16/CCITT", "CRC-16/CCITT-FALSE",
+                        "CRC-16/X25", "CRC-16/XMODEM", "CRC-16/DNP", "CRC-32",
+                        "CRC-32/MPEG-2"});
+    crcType_->setCurrentIndex(setPtr->value("crcType").toInt());
+    crcScope_->addItem("每行", LUX_CHECK_LINE);
+    crcScope_->addItem("每帧", LUX_CHECK_FRAME);
+    crcScope_->setCurrentIndex(setPtr->value("crcScope").toInt());
+
     // Width
     auto widthLabel = new QLabel("Width: ", this);
     connect(width_, &QLineEdit::textChanged, this,
@@ -141,6 +173,10 @@ ParaConfDialog::ParaConfDialog(QDialog *parent)
     // endian
     auto endianLabel = new QLabel("Endian: ", this);
 
+    // crc
+    auto crcLabel = new QLabel("CRC: ", this);
+    crcLabel->setBuddy(crcType_);
+
     auto errorMsgLabel = new QLabel(this);
     errorMsgLabel->setStyleSheet("color: red");
 
@@ -168,23 +204,31 @@ ParaConfDialog::ParaConfDialog(QDialog *parent)
     layout->addWidget(radio12_, 5, 1);
     layout->addWidget(radio16_, 5, 2);
 
-    layout->addWidget(endianLabel, 6, 0);
-    layout->addWidget(radioBigEndian_, 7, 0);
-    layout->addWidget(radioLittleEndian_, 7, 1);
+    layout->addWidget(radioRaw10_, 6, 0);
+    layout->addWidget(radioRaw12_, 6, 1);
+    layout->addWidget(radioRaw14_, 6, 2);
+
+    layout->addWidget(endianLabel, 7, 0);
+    layout->addWidget(radioBigEndian_, 8, 0);
+    layout->addWidget(radioLittleEndian_, 8, 1);
 
-    layout->addWidget(modeLabel, 8, 0);
-    layout->addWidget(radio18_, 9, 0);
-    layout->addWidget(radio28_, 9, 1);
-    layout->addWidget(radio38_, 9, 2);
-    layout->addWidget(radio48_, 10, 0);
-    layout->addWidget(radio58_, 10, 1);
-    layout->addWidget(radioAll8_, 10, 2);
+    layout->addWidget(modeLabel, 9, 0);
+    layout->addWidget(radio18_, 10, 0);
+    layout->addWidget(radio28_, 10, 1);
+    layout->addWidget(radio38_, 10, 2);
+    layout->addWidget(radio48_, 11, 0);
+    layout->addWidget(radio58_, 11, 1);
+    layout->addWidget(radioAll8_, 11, 2);
 
-    layout->addWidget(submitBtn, 11, 1, 1, 1);
+    layout->addWidget(crcLabel, 12, 0);
+    layout->addWidget(crcType_, 12, 1);
+    layout->addWidget(crcScope_, 12, 2);
+
+    layout->addWidget(submitBtn, 13, 1, 1, 1);
     setLayout(layout);
     setWindowTitle("Raw 图像参数配置");
-    setMaximumSize(400, 300);
-    setMinimumSize(400, 300);
+    setMaximumSize(400, 355);
+    setMinimumSize(400, 355);
 }
 
 void ParaConfDialog::onWidthChanged(const QString &width) {
@@ -227,6 +271,12 @@ void ParaConfDialog::onSubmit() {
         conf_->bpp = 12;
     else if (radio16_->isChecked())
         conf_->bpp = 16;
+    else if (radioRaw10_->isChecked())
+        conf_->bpp = LUX_BPP_RAW10;
+    else if (radioRaw12_->isChecked())
+        conf_->bpp = LUX_BPP_RAW12;
+    else if (radioRaw14_->isChecked())
+        conf_->bpp = LUX_BPP_RAW14;
 
     if (radioBigEndian_->isChecked())
         conf_->bigEndian = true;
@@ -246,6 +296,9 @@ void ParaConfDialog::onSubmit() {
     else if (radioAll8_->isChecked())
         conf_->mode = 5;
 
+    conf_->crcType = crcType_->currentIndex();
+    conf_->crcScope = crcScope_->currentData().toInt();
+
     accept();
 }
 
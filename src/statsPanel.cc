@@ -0,0 +1,67 @@
+#include <ziwi/common.h>
+#include <ziwi/statsPanel.h>
+
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+using Lux::ziwi::StatsPanel;
+
+namespace {
+// Bayer sites of LuxBayerStats, RGGB
+const char* const kChannelNames[4] = {"R", "Gr", "Gb", "B"};
+}  // namespace
+
+StatsPanel::StatsPanel(QWidget* parent)
+    : QDockWidget(tr("通道统计"), parent),
+      table_(new QTableWidget(4, 0, this)),
+      roiLabel_(new QLabel(this)) {
+    setObjectName("statsPanel");
+    setFont(FONT);
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionMode(QAbstractItemView::NoSelection);
+    table_->horizontalHeader()->setSectionResizeMode(
+        QHeaderView::ResizeToContents);
+    for (int s = 0; s < 4; ++s)
+        table_->setVerticalHeaderItem(s,
+                                      new QTableWidgetItem(kChannelNames[s]));
+
+    auto body = new QWidget(this);
+    auto layout = new QVBoxLayout(body);
+    layout->setContentsMargins(3, 3, 3, 3);
+    layout->addWidget(roiLabel_);
+    layout->addWidget(table_, 1);
+    setWidget(body);
+    clear();
+}
+
+void StatsPanel::setStats(const LuxBayerStats& stats) {
+    QStringList headers = {tr("数量"), tr("均值"), tr("标准差"), tr("最小"),
+                           tr("最大")};
+    for (int i = 0; i < stats.percentileCount; ++i)
+        headers << QString("P%1").arg(stats.percentileRanks[i]);
+    table_->setColumnCount(headers.size());
+    table_->setHorizontalHeaderLabels(headers);
+
+    for (int s = 0; s < 4; ++s) {
+        const LuxChannelStats& c = stats.channels[s];
+        QStringList cells = {QString::number(c.count),
+                             QString::number(c.mean, 'f', 2),
+                             QString::number(c.stddev, 'f', 2),
+                             QString::number(c.min), QString::number(c.max)};
+        for (int i = 0; i < stats.percentileCount; ++i)
+            cells << QString::number(c.percentiles[i]);
+        for (int k = 0; k < cells.size(); ++k)
+            table_->setItem(s, k, new QTableWidgetItem(cells[k]));
+    }
+    roiLabel_->setText(tr("区域: (%1, %2) %3 x %4, %5 bit")
+                           .arg(stats.roi.x)
+                           .arg(stats.roi.y)
+                           .arg(stats.roi.width)
+                           .arg(stats.roi.height)
+                           .arg(stats.significantBits));
+}
+
+void StatsPanel::clear() {
+    table_->clearContents();
+    roiLabel_->setText(tr("请先打开 raw 图像"));
+}
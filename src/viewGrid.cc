@@ -0,0 +1,143 @@
+#include <ziwi/viewGrid.h>
+
+#include <QVBoxLayout>
+#include <algorithm>
+
+using namespace Lux::ziwi;
+
+ViewSyncGroup::ViewSyncGroup(QObject* parent)
+    : QObject(parent),
+      syncing_(false),
+      throttle_(new QTimer(this)),
+      pending_(nullptr) {
+    // ~60 Hz, a full repaint of every follower per wheel step is too much
+    throttle_->setSingleShot(true);
+    throttle_->setInterval(16);
+    connect(throttle_, &QTimer::timeout, this, &ViewSyncGroup::onThrottle);
+}
+
+void ViewSyncGroup::addView(SynchableGraphicsView* view) {
+    views_.push_back(view);
+    connect(view, &SynchableGraphicsView::transformChanged, this,
+            &ViewSyncGroup::onViewChanged);
+    connect(view, &SynchableGraphicsView::scrollChanged, this,
+            &ViewSyncGroup::onViewChanged);
+    connect(view, &QObject::destroyed, this, [this, view]() {
+        views_.erase(std::remove(views_.begin(), views_.end(), view),
+                     views_.end());
+        if (pending_ == view) pending_ = nullptr;
+    });
+}
+
+void ViewSyncGroup::clear() {
+    for (auto view : views_) disconnect(view, nullptr, this, nullptr);
+    views_.clear();
+    pending_ = nullptr;
+}
+
+void ViewSyncGroup::follow(SynchableGraphicsView* leader) {
+    // Moving the followers emits their own signals, do not echo them back
+    if (syncing_ || leader == nullptr) return;
+    syncing_ = true;
+
+    auto transform = leader->transform();
+    auto scroll = leader->scrollState();
+    for (auto view : views_) {
+        if (view == leader) continue;
+        view->setTransform(transform);
+        view->clearTransformChanges();
+        view->setScrollState(scroll);
+    }
+    syncing_ = false;
+}
+
+void ViewSyncGroup::schedule(SynchableGraphicsView* leader) {
+    if (syncing_) return;
+    if (throttle_->interval() == 0) {
+        follow(leader);
+        return;
+    }
+    // The latest leader wins, the followers catch up once per tick
+    pending_ = leader;
+    if (!throttle_->isActive()) throttle_->start();
+}
+
+void ViewSyncGroup::onViewChanged() {
+    schedule(qobject_cast<SynchableGraphicsView*>(sender()));
+}
+
+void ViewSyncGroup::onThrottle() {
+    auto leader = pending_;
+    pending_ = nullptr;
+    follow(leader);
+}
+
+ViewGrid::ViewGrid(int rows, int cols, QWidget* parent)
+    : QFrame(parent),
+      layout_(new QGridLayout(this)),
+      sync_(new ViewSyncGroup(this)),
+      zoomFactorDelta_(1.25f) {
+    layout_->setContentsMargins(0, 0, 0, 0);
+    layout_->setSpacing(3);
+
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            Cell cell;
+            cell.scene = new QGraphicsScene(this);
+            cell.view = new SynchableGraphicsView(cell.scene, this);
+            cell.item = new QGraphicsPixmapItem();
+            cell.scene->addItem(cell.item);
+            cell.caption = new QLabel(this);
+            cell.caption->setAlignment(Qt::AlignmentFlag::AlignCenter);
+
+            cell.view->setRenderHint(
+                QPainter::RenderHint::SmoothPixmapTransform);
+            cell.view->enableScrollBars(true);
+            connect(cell.view, &SynchableGraphicsView::wheelNotches, this,
+                    &ViewGrid::handleWheelNotches);
+            sync_->addView(cell.view);
+
+            auto box = new QVBoxLayout();
+            box->setContentsMargins(0, 0, 0, 0);
+            box->setSpacing(0);
+            box->addWidget(cell.caption);
+            box->addWidget(cell.view, 1);
+            layout_->addLayout(box, r, c);
+            cells_.push_back(cell);
+        }
+    }
+    setLayout(layout_);
+}
+
+void ViewGrid::setImage(int index, const QPixmap& pixmap,
+                        const QString& caption) {
+    if (index < 0 || index >= count()) return;
+    cells_[index].item->setPixmap(pixmap);
+    cells_[index].item->setTransformationMode(
+        Qt::TransformationMode::SmoothTransformation);
+    cells_[index].scene->setSceneRect(cells_[index].item->boundingRect());
+    cells_[index].caption->setText(caption);
+}
+
+void ViewGrid::fitToWindow() {
+    if (cells_.empty() || cells_[0].item->pixmap().isNull()) return;
+    cells_[0].view->fitInView(cells_[0].item, Qt::KeepAspectRatio);
+    cells_[0].view->clearTransformChanges();
+    sync_->follow(cells_[0].view);
+}
+
+void ViewGrid::actualSize() {
+    if (cells_.empty()) return;
+    cells_[0].view->setZoomFactor(1.0);
+    cells_[0].view->clearTransformChanges();
+    sync_->follow(cells_[0].view);
+}
+
+void ViewGrid::handleWheelNotches(float notches) {
+    auto view = qobject_cast<SynchableGraphicsView*>(sender());
+    if (view == nullptr) return;
+
+    float factor = std::pow(zoomFactorDelta_, notches);
+    view->setZoomFactor(view->zoomFactor() * factor);
+    view->checkTransformChanged();
+}